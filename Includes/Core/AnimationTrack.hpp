@@ -0,0 +1,112 @@
+#ifndef ANIMATION_TRACK_HPP
+#define ANIMATION_TRACK_HPP
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace Core {
+
+	//!
+	//! \brief      Keyframe curves of the same interpolation evaluated together in SIMD lanes
+	//!
+	//! Each lane samples one curve of vec4 keys. The lanes look up their keys with their own
+	//! cursors, then the keys are transposed into the structure of arrays layout and four lanes
+	//! are interpolated per instruction. The results are kept in the same layout, one array per
+	//! component, so that the caller scatters them without shuffling.
+	//!
+	//! The lanes of the baked curves sample their keys at a fixed rate from time zero, which
+	//! finds the keys by an index instead of the search, and their keys may be packed into 48 bits
+	//! unless the kernel is cubic.
+	//!
+	//! The key arrays are referenced, not copied, and must outlive the track.
+	//!
+	class AnimationTrack
+	{
+	public:
+		//! Interpolation applied to every lane of the track
+		enum class Kernel
+		{
+			Lerp = 0,   //! Component-wise linear interpolation
+			NLerp = 1,  //! Normalized linear interpolation of the quaternions
+			SLerp = 2,  //! Spherical linear interpolation of the quaternions
+			Step = 3,   //! Value of the previous key
+			Cubic = 4,  //! Hermite spline of the in-tangent, value and out-tangent triplets of each key
+			NCubic = 5  //! Normalized Hermite spline of the quaternion triplets
+		};
+		//! Encoding of the keys packed into three 16-bit words
+		enum class KeyEncoding
+		{
+			Vector48 = 0,     //! offset + scale * key of each component
+			Quaternion48 = 1  //! Smallest three components of the quaternion, see Quantization.hpp
+		};
+		//! Keys packed into three 16-bit words, decoded when they are interpolated
+		struct PackedKeys
+		{
+			KeyEncoding encoding{ KeyEncoding::Vector48 };
+			const glm::u16vec3* keys{ nullptr };
+			glm::vec3 offset{ 0.0f, 0.0f, 0.0f };
+			glm::vec3 scale{ 1.0f, 1.0f, 1.0f };
+		};
+		//! Number of lanes evaluated per instruction, the lane arrays are padded to its multiple
+		static constexpr std::size_t kLaneWidth = 4;
+		//! Constructor with the interpolation of the lanes
+		explicit AnimationTrack(Kernel kernel = Kernel::Lerp);
+		//! Default destructor
+		~AnimationTrack();
+		//! Add the lane sampling the given keys and returns its index.
+		//! The keys of the cubic kernels are the in-tangent, value and out-tangent triplets, numKeys counts the triplets.
+		std::size_t AddLane(const float* times, const glm::vec4* values, std::size_t numKeys);
+		//! Add the lane sampling the keys at the fixed rate from time zero and returns its index
+		std::size_t AddLane(float sampleRate, const glm::vec4* values, std::size_t numKeys);
+		//! Add the lane sampling the packed keys at the fixed rate from time zero and returns its index
+		std::size_t AddLane(float sampleRate, const PackedKeys& keys, std::size_t numKeys);
+		//! Sample the lanes at the given time. If the active flags of the lanes are given, the inactive lanes skip
+		//! the key lookup and the groups of inactive lanes skip the interpolation, their results are unspecified.
+		void Evaluate(float time, const unsigned char* activeLanes = nullptr);
+		//! Returns the given component of the lane results, valid until the next Evaluate
+		inline const float* GetResults(std::size_t component) const
+		{
+			return _results.data() + component * _prevKeys.size();
+		}
+		//! Returns the interpolation of the lanes
+		inline Kernel GetKernel() const
+		{
+			return _kernel;
+		}
+		//! Returns the number of lanes without the padding
+		inline std::size_t GetNumLanes() const
+		{
+			return _times.size();
+		}
+		//! Returns true if the consecutive quaternion keys are close enough that NLerp equals SLerp
+		static bool IsNLerpExact(const glm::vec4* values, std::size_t numKeys);
+		//! Returns the given key of the packed keys, the vectors have zero w
+		static glm::vec4 DecodeKey(const PackedKeys& keys, std::size_t index);
+	private:
+		Kernel _kernel;
+		//! Times of the lane keys, null for the fixed rate lanes
+		std::vector<const float*> _times;
+		std::vector<float> _sampleRates;
+		//! Float keys of the lane, null for the packed lanes which decode their keys into _decodedKeys
+		std::vector<const glm::vec4*> _values;
+		std::vector<PackedKeys> _packedKeys;
+		std::vector<glm::vec4> _decodedKeys;
+		std::vector<std::size_t> _numKeys;
+		std::vector<std::size_t> _cursors;
+		//! Keys and weights of the current evaluation, the padding lanes interpolate the identity
+		std::vector<const glm::vec4*> _prevKeys;
+		std::vector<const glm::vec4*> _nextKeys;
+		std::vector<float> _weights;
+		//! Out-tangent of the previous key, in-tangent of the next key and the interval between them for the cubic kernels
+		std::vector<const glm::vec4*> _prevTangents;
+		std::vector<const glm::vec4*> _nextTangents;
+		std::vector<float> _intervals;
+		std::vector<float> _results;
+	};
+
+};
+
+#endif //! end of AnimationTrack.hpp
@@ -0,0 +1,64 @@
+#ifndef ARRAY_VIEW_HPP
+#define ARRAY_VIEW_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace Core {
+
+	//!
+	//! \brief      Read-only range of contiguous elements owned by someone else
+	//!
+	//! Points either at a vector or into a mapped file, the owner must outlive the view.
+	//!
+	template <typename Type>
+	class ArrayView
+	{
+	public:
+		using value_type = Type;
+		//! Default constructor, empty range
+		ArrayView() = default;
+		//! Constructor with the first element and the number of elements
+		ArrayView(const Type* data, std::size_t size)
+			: _data(data), _size(size)
+		{
+			//! Do nothing
+		}
+		//! Implicit conversion from the vector holding the elements
+		ArrayView(const std::vector<Type>& values)
+			: _data(values.data()), _size(values.size())
+		{
+			//! Do nothing
+		}
+		inline const Type* data() const
+		{
+			return _data;
+		}
+		inline std::size_t size() const
+		{
+			return _size;
+		}
+		inline bool empty() const
+		{
+			return _size == 0;
+		}
+		inline const Type* begin() const
+		{
+			return _data;
+		}
+		inline const Type* end() const
+		{
+			return _data + _size;
+		}
+		inline const Type& operator[](std::size_t index) const
+		{
+			return _data[index];
+		}
+	private:
+		const Type* _data{ nullptr };
+		std::size_t _size{ 0 };
+	};
+
+};
+
+#endif //! end of ArrayView.hpp
\ No newline at end of file
@@ -1,14 +1,16 @@
 #ifndef GLTF_SCENE_IMPL_HPP
 #define GLTF_SCENE_IMPL_HPP
 
+#include <Core/Quantization.hpp>
 #include <string>
 #include <iostream>
+#include <algorithm>
 #include <tinygltf/tiny_gltf.h>
 
 namespace Core {
 
 	template <typename Type>
-	bool GLTFScene::GetAttributes(const tinygltf::Model& model, const tinygltf::Primitive& primitive, std::vector<Type>& attributes, const std::string& name)
+	bool GLTFScene::GetAttributes(const tinygltf::Model& model, const tinygltf::Primitive& primitive, Type* attributes, std::size_t numAttributes, const std::string& name) const
 	{
 		auto iter = primitive.attributes.find(name);
 		if (iter == primitive.attributes.end())
@@ -17,69 +19,26 @@ namespace Core {
 		//! Retrieving the data of the attributes
 		const auto& accessor = model.accessors[iter->second];
 		const auto& bufferView = model.bufferViews[accessor.bufferView];
-		const auto& buffer = model.buffers[bufferView.buffer];
-		const Type* bufData = reinterpret_cast<const Type*>(&(buffer.data[accessor.byteOffset + bufferView.byteOffset]));
-		const auto& numElements = accessor.count;
-
-		//! Supporting KHR_mesh_quantization
-		assert(accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT);
-
-		if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT)
+		const unsigned char* bufData = GetAccessorData(model, accessor);
+		const std::size_t numElements = std::min(accessor.count, numAttributes);
+		const std::size_t numComponents = static_cast<std::size_t>(tinygltf::GetNumComponentsInType(accessor.type));
+		const int byteStride = accessor.ByteStride(bufferView);
+		if (byteStride <= 0)
 		{
-			if (bufferView.byteStride == 0)
-			{
-				attributes.insert(attributes.end(), bufData, bufData + numElements);
-			}
-			else
-			{
-				auto bufferByte = reinterpret_cast<const unsigned char*>(bufData);
-				for (size_t i = 0; i < numElements; ++i)
-				{
-					attributes.push_back(*reinterpret_cast<const Type*>(bufferByte));
-					bufferByte += bufferView.byteStride;
-				}
-			}
+			std::cerr << "Invalid byte stride of the attributes : " << name << std::endl;
+			return false;
 		}
-		else //! The component is smaller than flaot and need to be covnerted (quantized)
+
+		//! Missing components are filled with one (e.g. alpha of RGB colors)
+		if (numComponents < static_cast<std::size_t>(Type::length()))
+			std::fill(attributes, attributes + numElements, Type(1.0f));
+
+		//! Supporting KHR_mesh_quantization, the smaller components than float are converted
+		if (!DequantizeAttributes(bufData, static_cast<std::size_t>(byteStride), accessor.componentType, accessor.normalized,
+								  numComponents, reinterpret_cast<float*>(attributes), Type::length(), numElements))
 		{
-			//! vec3 or vec4
-			int numComponents = accessor.type;
-			//! unsigned byte or unsigned short.
-			int strideComponent = accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE ? 1 : 2;
-
-			size_t byteStride = bufferView.byteStride > 0 ? bufferView.byteStride : numComponents * strideComponent;
-			auto bufferByte = reinterpret_cast<const unsigned char*>(bufData);
-			for (size_t i = 0; i < numElements; ++i)
-			{
-				Type vecValue;
-				
-				auto bufferByteData = bufferByte;
-				for (int c = 0; c < numComponents; ++c)
-				{
-					float value = *reinterpret_cast<const float*>(bufferByteData);
-					switch (accessor.componentType)
-					{
-					case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-						vecValue[c] = value / std::numeric_limits<unsigned short>::max();
-						break;
-					case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
-						vecValue[c] = value / std::numeric_limits<unsigned char>::max();
-						break;
-					case TINYGLTF_COMPONENT_TYPE_SHORT:
-						vecValue[c] = std::max(value / std::numeric_limits<short>::max(), -1.0f);
-						break;
-					case TINYGLTF_COMPONENT_TYPE_BYTE:
-						vecValue[c] = std::max(value / std::numeric_limits<char>::max(), -1.0f);
-						break;
-					default:
-						std::cerr << "Unknown attributes component type : " << accessor.componentType << " is not supported" << std::endl;
-						return false;
-					}
-					bufferByteData += strideComponent;
-				}
-				bufferByte += byteStride;
-				attributes.push_back(vecValue);
-			}
+			std::cerr << "Unknown attributes component type : " << accessor.componentType << " is not supported" << std::endl;
+			return false;
 		}
 
 		return true;
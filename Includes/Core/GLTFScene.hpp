@@ -1,16 +1,21 @@
 #ifndef GLTF_SCENE_HPP
 #define GLTF_SCENE_HPP
 
+#include <Core/AnimationTrack.hpp>
 #include <Core/Vertex.hpp>
+#include <Core/MappedFile.hpp>
+#include <Core/ArrayView.hpp>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 #include <glm/mat4x4.hpp>
 #include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_precision.hpp>
 #include <string>
 #include <limits>
 #include <functional>
 #include <unordered_map>
+#include <memory>
 #include <tinygltf/tiny_gltf.h>
 
 //! KHR extension list (https://github.com/KhronosGroup/glTF/tree/master/extensions/2.0/Khronos)
@@ -79,6 +84,65 @@ namespace Core {
 		bool CheckRequiredExtensions(const tinygltf::Model& model);
 	};
 
+	//!
+	//! \brief      Options applied while loading the gltf scene
+	//!
+	struct GLTFLoadOptions
+	{
+		//! Map the .glb or external .bin files instead of copying them into tinygltf buffers.
+		//! Accessors read straight from the mapped pages and the mapping is dropped after loading.
+		bool memoryMapped{ false };
+		//! Write the post-processed scene into a binary cache next to the scene file,
+		//! and load it instead of parsing the scene while the source files are unchanged.
+		bool sceneCache{ false };
+		//! Keep the KHR_mesh_quantization attributes in their quantized format for the GPU.
+		//! Applied per attribute when all primitives share the same quantized format.
+		bool keepQuantized{ false };
+		//! Store the indices of primitives with at most 65536 vertices as 16-bit in the element buffer
+		bool shortIndices{ false };
+		//! Compress the vertex attributes for the GPU : positions quantized into the bounds of each primitive,
+		//! octahedral normals, 10-bit snorm tangents, half float texture coordinates and 8-bit colors.
+		//! The positions and the normals are decoded by vertex.glsl, the others by the vertex fetch.
+		//! The encoding errors are reported after loading.
+		bool compressAttributes{ false };
+		//! Reorder the triangles of each primitive for the vertex cache and overdraw,
+		//! and then its vertices for the fetch locality. ACMR/ATVR are reported before and after.
+		bool optimizeMeshes{ false };
+		//! Build up to 4 simplified index ranges per primitive which share its vertices
+		bool generateLods{ false };
+		//! Fit the dense linear translation, rotation and scale keys into fewer cubic spline keys whose largest
+		//! component error stays within keyframeErrorBound. Applied at import, the scene cache keeps the fitted keys.
+		bool reduceKeyframes{ false };
+		float keyframeErrorBound{ 1e-3f };
+		//! Resample the animation samplers to this many keys per second from time zero, so that the key
+		//! lookup is an index. Zero keeps the keys of the file. The memory and the errors are reported per clip.
+		float animationSampleRate{ 0.0f };
+		//! Pack the resampled keys into 48 bits : 16-bit translations and scales in the range of each sampler,
+		//! smallest three rotations. Applied only if animationSampleRate is given.
+		bool compressAnimations{ false };
+		//! Largest allowed error of each key component against the source curves. The samplers exceeding it
+		//! are kept as they were before the resampling or the compression.
+		float animationErrorBound{ 1e-3f };
+	};
+
+	//! One clip blended by GLTFScene::UpdateAnimation, the blend layers are averaged and the additive layers are added on top in order
+	struct GLTFAnimationLayer
+	{
+		enum class Mode
+		{
+			//! Weighted average with the other blend layers, the rest pose fills the total weight below one
+			Blend = 0,
+			//! Difference of the clip to its first frame scaled by the weight
+			Additive = 1
+		};
+		int animIndex{ 0 };
+		float timeElapsed{ 0.0f };
+		float weight{ 1.0f };
+		Mode mode{ Mode::Blend };
+		//! Mask from GLTFScene::AddAnimationMask scaling the weight per node, -1 applies the weight to every node
+		int maskIndex{ -1 };
+	};
+
 	//!
 	//! \brief      GLTF scene file loader class
 	//!
@@ -90,16 +154,65 @@ namespace Core {
 	class GLTFScene
 	{
 	public:
-		using ImageCallback = std::function<void(const tinygltf::Image& image)>;
+		//! Decoded image passed to the image callback, the pixels are owned by the loaded model or the mapped scene cache
+		//! and stay valid only during the call
+		struct GLTFImage
+		{
+			std::string name;
+			int width{ 0 };
+			int height{ 0 };
+			int component{ 0 };
+			int bits{ 0 };
+			int pixelType{ 0 };
+			ArrayView<unsigned char> pixels;
+		};
+		using ImageCallback = std::function<void(const GLTFImage& image)>;
 		//! Default Constructor
 		GLTFScene();
 		//! Default Virtual Destructor
 		virtual ~GLTFScene();
 		//! Initialize the GLTFScene with gltf scene file path
-		bool Initialize(const std::string& filename, VertexFormat format, ImageCallback imageCallback = nullptr);
+		bool Initialize(const std::string& filename, VertexFormat format, const GLTFLoadOptions& options = GLTFLoadOptions(), ImageCallback imageCallback = nullptr);
 		//! Update scene animation
 		//! Returns whether scene is modified or not
 		bool UpdateAnimation(int animIndex, float timeElapsed);
+		//! Sample the clips of the layers on the worker threads and blend them into the node transforms and weights.
+		//! The nodes animated by none of the layers return to their rest pose, the animation LOD is not applied.
+		//! Returns whether scene is modified or not
+		bool UpdateAnimation(const std::vector<GLTFAnimationLayer>& layers);
+		//! Register the weight of every scene node for the layers, returns the mask index or -1 if the size does not match
+		int AddAnimationMask(const std::vector<float>& nodeWeights);
+		//! Register the mask of the subtrees of the given glTF node, returns the mask index or -1 if the node is not in the scene
+		int AddSubtreeMask(int gltfNodeIndex);
+		//! Channels evaluated and skipped by the animation LOD in the last UpdateAnimation
+		struct AnimationStats
+		{
+			std::size_t evaluatedChannels{ 0 };
+			std::size_t skippedChannels{ 0 };
+		};
+		//! Returns the channel counters of the last UpdateAnimation
+		inline const AnimationStats& GetAnimationStats() const
+		{
+			return _animationStats;
+		}
+		//! Measure UpdateAnimation on the synthetic clip of the given size and report the timings
+		static void BenchmarkAnimation(std::size_t numChannels, std::size_t numKeys, int numFrames);
+		//! Measure the keyframe reduction of the synthetic capture clip and the evaluation of the fitted keys and report the timings
+		static void BenchmarkKeyframeReduction(std::size_t numChannels, std::size_t numKeys, int numFrames);
+		//! Measure the transform propagation of the synthetic hierarchy and report the timings
+		static void BenchmarkTransforms(std::size_t numNodes, int numFrames);
+		//! Measure the joint palette update and the CPU skinning of the synthetic skin and report the timings
+		static void BenchmarkSkinning(std::size_t numVertices, std::size_t numJoints, int numFrames);
+		//! Skin the vertices of the primitive with the current joint palette of the skin on the CPU.
+		//! Writes vertexCount elements of the primitive, the normals may be null.
+		//! Returns false if the source vertices are released or the primitive is not skinned.
+		bool SkinPrimitive(unsigned int primMeshIndex, int skinIndex, glm::vec3* positions, glm::vec3* normals) const;
+		//! Measure the weights animation and the blending of the synthetic morph targets and report the timings
+		static void BenchmarkMorphTargets(std::size_t numVertices, std::size_t numTargets, int numFrames);
+		//! Blend the morph targets of the primitive with the current weights of the node on the CPU, same as vertex.glsl does.
+		//! Writes vertexCount elements of the primitive, the normals and the tangents may be null.
+		//! Returns false if the source vertices are released or the node does not draw the primitive.
+		bool MorphPrimitive(int nodeIndex, unsigned int primMeshIndex, glm::vec3* positions, glm::vec3* normals, glm::vec4* tangents) const;
 	protected:
 		//! https://github.com/KhronosGroup/glTF/blob/master/specification/2.0/README.md#reference-material
 		struct GLTFMaterial
@@ -133,17 +246,62 @@ namespace Core {
 			GLTFExtension::KHR_materials_unlit                 unlit;
 		};
 
+		//! The world matrix, the T * R * S * local matrix and the parent of the node
+		//! are kept apart in _nodeWorlds, _nodeTransforms and _nodeParents
 		struct GLTFNode
 		{
-			glm::mat4 world{ 1.0f };
 			glm::mat4 local{ 1.0f };
 			glm::vec3 translation{ 0.0f };
 			glm::vec3 scale{ 1.0f };
 			glm::quat rotation{ 0.0f, 0.0f, 0.0f, 0.0f };
 			std::vector<unsigned int> primMeshes;
 			std::vector<int> childNodes;
-			int parentNode{ -1 };
 			int nodeIndex{ 0 };
+			//! One past the last descendant, the nodes are stored in the parent-before-child order
+			int subtreeEnd{ 0 };
+			int skin{ -1 };
+			//! Morph target weights of the mesh in _morphWeights, animated per node
+			int weightIndex{ 0 };
+			int weightCount{ 0 };
+		};
+
+		//! Range of the skin in the flat joint arrays, the palette of the skin starts at jointIndex
+		struct GLTFSkin
+		{
+			std::string name;
+			int jointIndex{ 0 };
+			int jointCount{ 0 };
+		};
+
+		//! Delta of one vertex attribute, same layout as GltfMorphDelta of gltf.glsl
+		struct GLTFMorphDelta
+		{
+			glm::vec3 delta{ 0.0f, 0.0f, 0.0f };
+			unsigned int vertex{ 0 };  //! Index in the scene vertex streams
+		};
+
+		//! Deltas of one attribute of the morph target in _morphDeltas in the increasing vertex order.
+		//! Dense ranges hold every vertex of the primitive, sparse ones only the vertices of the sparse accessor.
+		struct GLTFMorphRange
+		{
+			int offset{ 0 };
+			int count{ 0 };  //! Zero if the target does not change the attribute
+			int sparse{ 0 };
+		};
+
+		struct GLTFMorphTarget
+		{
+			GLTFMorphRange position;
+			GLTFMorphRange normal;
+			GLTFMorphRange tangent;
+		};
+
+		//! Simplified index range of the primitive
+		struct GLTFPrimLod
+		{
+			unsigned int firstIndex{ 0 };
+			unsigned int indexCount{ 0 };
+			float error{ 0.0f };  //! Object space distance error bound
 		};
 
 		struct GLTFPrimMesh
@@ -157,6 +315,18 @@ namespace Core {
 			glm::vec3 min{ 0.0f, 0.0f, 0.0f };
 			glm::vec3 max{ 0.0f, 0.0f, 0.0f };
 			std::string name;
+
+			//! Coarser levels in the increasing error order, the primitive itself is the level 0
+			std::vector<GLTFPrimLod> lods;
+
+			//! Morph targets of the primitive in _morphTargets
+			int morphTargetIndex{ 0 };
+			int morphTargetCount{ 0 };
+
+			//! Decoding of the compressed positions : offset + scale * position.
+			//! Computed after loading, therefore not written into the scene cache.
+			glm::vec3 positionOffset{ 0.0f, 0.0f, 0.0f };
+			glm::vec3 positionScale{ 1.0f, 1.0f, 1.0f };
 		};
 
 		struct GLTFCamera
@@ -186,6 +356,28 @@ namespace Core {
 			Interpolation interpolation { Interpolation::Linear };
 			std::vector<float> inputs;
 			std::vector<glm::vec4> outputs;
+			//! Weights keys of four morph targets per vec4, one run of keys per four targets.
+			//! Packed from the outputs by BuildAnimationTracks, therefore not written into the scene cache.
+			std::vector<glm::vec4> packedWeights;
+
+			//! Keys per second of the baked sampler from time zero, whose inputs are released.
+			//! Baked after loading, therefore not written into the scene cache like the packed keys.
+			float sampleRate{ 0.0f };
+			std::size_t numBakedKeys{ 0 };
+			//! 48-bit keys of the compressed sampler, whose outputs are released
+			std::vector<glm::u16vec3> packedKeys;
+			AnimationTrack::PackedKeys packedEncoding;
+
+			//! Returns the number of keys of the sampler
+			inline std::size_t GetNumKeys() const
+			{
+				return sampleRate > 0.0f ? numBakedKeys : inputs.size();
+			}
+			//! Returns the number of outputs per key, cubic spline keys are the in-tangent, value and out-tangent triplets
+			inline std::size_t GetKeyStride() const
+			{
+				return interpolation == Interpolation::Cubicspline ? 3 : 1;
+			}
 		};
 
 		struct GLTFChannel
@@ -209,6 +401,60 @@ namespace Core {
 			int samplerCount { 0 };
 			int channelIndex { 0 };
 			int channelCount { 0 };
+			float duration { 0.0f };  //! Last key time of the samplers, computed at import
+			int trackIndex { 0 };
+			int trackCount { 0 };
+			//! Range of the nodes animated by the clip in _animatedNodes, computed with the tracks
+			int animatedNodeIndex { 0 };
+			int animatedNodeCount { 0 };
+		};
+
+		//! Node animated by a clip and the bits (1 << path) of its channels
+		struct GLTFAnimatedNode
+		{
+			int nodeIndex { 0 };
+			unsigned int paths { 0 };
+		};
+
+		//! Sampled transforms of the nodes, indexed like the animated nodes of the clip or like the scene nodes.
+		//! The rotations are stored as x, y, z, w and the weights are indexed like the morph weights.
+		struct GLTFPose
+		{
+			std::vector<glm::vec4> translations;
+			std::vector<glm::vec4> rotations;
+			std::vector<glm::vec4> scales;
+			std::vector<float> weights;
+		};
+
+		//! Channels of one animation sharing the path and the interpolation, one lane per channel
+		struct GLTFTrack
+		{
+			GLTFChannel::Path path { GLTFChannel::Path::Translation };
+			std::vector<int> nodeIndices;
+			//! First morph target of each lane of the weights track, the lane holds up to four targets
+			std::vector<int> targetIndices;
+			AnimationTrack lanes;
+			//! Lanes whose node is updated in the current frame by the animation LOD
+			std::vector<unsigned char> activeLanes;
+			//! Entry of the node of each lane in the animated nodes of the clip
+			std::vector<int> poseIndices;
+		};
+
+		//! Vertex stream kept in the source component type or compressed, each element is aligned to 4 bytes
+		struct GLTFQuantizedStream
+		{
+			int componentType{ 0 };
+			int numComponents{ 0 };
+			bool normalized{ false };
+			unsigned int elementSize{ 0 };
+			std::vector<unsigned char> data;
+			//! Elements in the mapped scene cache, used while data is empty
+			ArrayView<unsigned char> mappedData;
+			//! Returns the elements wherever they are stored
+			ArrayView<unsigned char> GetData() const
+			{
+				return data.empty() ? mappedData : ArrayView<unsigned char>(data);
+			}
 		};
 
 		struct SceneDimension
@@ -222,12 +468,44 @@ namespace Core {
 
 		std::vector<GLTFMaterial> _sceneMaterials;
 		std::vector<GLTFNode> _sceneNodes;
+		//! Hierarchy of _sceneNodes in the flat arrays, UpdateNodeTransforms streams only these
+		std::vector<glm::mat4> _nodeWorlds;
+		//! T * R * S * local of each node, recomputed only when the node is animated
+		std::vector<glm::mat4> _nodeTransforms;
+		//! Parent of each node, -1 for the roots
+		std::vector<int> _nodeParents;
 		std::vector<GLTFPrimMesh> _scenePrimMeshes;
 		std::vector<GLTFCamera> _sceneCameras;
 		std::vector<GLTFLight> _sceneLights;
 		std::vector<GLTFAnimation> _sceneAnims;
 		std::vector<GLTFSampler> _sceneSamplers;
 		std::vector<GLTFChannel> _sceneChannels;
+		//! Channels grouped for the batch evaluation, rebuilt from the channels at load
+		std::vector<GLTFTrack> _sceneTracks;
+		//! Nodes animated by every clip sorted by the node index, one range per clip
+		std::vector<GLTFAnimatedNode> _animatedNodes;
+		//! Imported transforms and weights of the scene nodes which the blend layers start from
+		GLTFPose _restPose;
+		//! First frame of every clip, subtracted from the additive layers
+		std::vector<GLTFPose> _referencePoses;
+		//! Nodes whose local transform is changed since the last UpdateNodeTransforms
+		std::vector<int> _dirtyNodes;
+		//! Node ranges [first, last) whose world matrices are recomputed by the last UpdateNodeTransforms, in the increasing order
+		std::vector<std::pair<int, int>> _updatedNodeRanges;
+		//! Animation LOD of each node set by the renderer : the channels of the node are evaluated every given number of frames,
+		//! zero freezes the node. Empty evaluates every channel every frame. The ancestors of the node must update as often.
+		std::vector<int> _nodeUpdatePeriods;
+		std::vector<GLTFSkin> _sceneSkins;
+		//! Joint node and inverse bind matrix of every skin in one array,
+		//! the palette is jointNode.world * inverseBindMatrix in the world space.
+		std::vector<int> _jointNodes;
+		std::vector<glm::mat4> _inverseBindMatrices;
+		std::vector<glm::mat4> _jointPalette;
+		//! Morph targets of every primitive and their packed deltas, the sparse accessors are kept sparse
+		std::vector<GLTFMorphTarget> _morphTargets;
+		std::vector<GLTFMorphDelta> _morphDeltas;
+		//! Current morph target weights of every node drawing the morphed mesh
+		std::vector<float> _morphWeights;
 
 		std::vector<glm::vec3> _positions;
 		std::vector<glm::vec3> _normals;
@@ -235,6 +513,40 @@ namespace Core {
 		std::vector<glm::vec4> _colors;
 		std::vector<glm::vec2> _texCoords;
 		std::vector<unsigned int> _indices;
+		//! JOINTS_0 and the normalized 16-bit WEIGHTS_0, empty if the scene has no skin
+		std::vector<glm::u16vec4> _skinJoints;
+		std::vector<glm::u16vec4> _skinWeights;
+
+		//! Quantized or compressed copies of the vertex streams, empty if not used
+		GLTFQuantizedStream _quantizedPositions;
+		GLTFQuantizedStream _quantizedNormals;
+		GLTFQuantizedStream _quantizedTangents;
+		GLTFQuantizedStream _quantizedColors;
+		GLTFQuantizedStream _quantizedTexCoords;
+
+		//! The scene cache stays mapped after a warm start, the streams point into it instead of being copied
+		//! into the vectors above. Released by ReleaseSourceData() with the vectors.
+		MappedFile _sceneCacheFile;
+		ArrayView<glm::vec3> _mappedPositions;
+		ArrayView<glm::vec3> _mappedNormals;
+		ArrayView<glm::vec4> _mappedTangents;
+		ArrayView<glm::vec4> _mappedColors;
+		ArrayView<glm::vec2> _mappedTexCoords;
+		ArrayView<unsigned int> _mappedIndices;
+		ArrayView<glm::u16vec4> _mappedSkinJoints;
+		ArrayView<glm::u16vec4> _mappedSkinWeights;
+		ArrayView<GLTFMorphDelta> _mappedMorphDeltas;
+
+		//! Returns the vertex streams wherever they are stored, in the vectors or in the mapped scene cache
+		ArrayView<glm::vec3> GetPositions() const;
+		ArrayView<glm::vec3> GetNormals() const;
+		ArrayView<glm::vec4> GetTangents() const;
+		ArrayView<glm::vec4> GetColors() const;
+		ArrayView<glm::vec2> GetTexCoords() const;
+		ArrayView<unsigned int> GetIndices() const;
+		ArrayView<glm::u16vec4> GetSkinJoints() const;
+		ArrayView<glm::u16vec4> GetSkinWeights() const;
+		ArrayView<GLTFMorphDelta> GetMorphDeltas() const;
 
 		SceneDimension _sceneDim;
 
@@ -242,31 +554,91 @@ namespace Core {
 		void ReleaseSourceData();
 	private:
 		//! Load GLTF model from the given filename and pass it by reference. 
+		//! The file format(.gltf or .glb) is decided from the header of the file.
 		//! Returns success or not.
-		static bool LoadModel(tinygltf::Model* model, const std::string& filename);
+		bool LoadModel(tinygltf::Model* model, const std::string& filename, const GLTFLoadOptions& options);
+		//! Load GLTF model without copying the binary buffers.
+		//! Returns false if the model can't be loaded in this way(e.g. draco compressed).
+		bool LoadMappedModel(tinygltf::Model* model, const MappedFile& file, const std::string& baseDir);
+		//! Returns the path of the binary scene cache for the given scene file
+		static std::string GetSceneCachePath(const std::string& filename);
+		//! Load the post-processed scene from the binary cache.
+		//! Returns false if the cache is missing, stale or written with the other format or options.
+		bool LoadSceneCache(const std::string& filename, VertexFormat format, const GLTFLoadOptions& options, const ImageCallback& imageCallback);
+		//! Returns whether every range and index read from the scene cache lies within the array it refers to,
+		//! the cache key hashes the source files only and a corrupted payload of the same size still reads
+		bool ValidateSceneCache(VertexFormat format) const;
+		//! Write the post-processed scene and the decoded images of the model into the binary cache.
+		//! The dependencies are the source files relative to the scene directory.
+		bool SaveSceneCache(const std::string& filename, VertexFormat format, const GLTFLoadOptions& options, const tinygltf::Model& model, const std::vector<std::string>& dependencies) const;
+		//! Returns the address of the first element of the given accessor
+		const unsigned char* GetAccessorData(const tinygltf::Model& model, const tinygltf::Accessor& accessor) const;
 		//!
 		//! \brief      Parse attribute with desire type from the model.
 		//! 
 		//! \tparam Type - attribute type to be retrieved from this function.
 		//!
+		//! Write at most numAttributes elements to the given destination.
+		//!
 		template <typename Type>
-		static bool GetAttributes(const tinygltf::Model& model, const tinygltf::Primitive& primitive, std::vector<Type>& attributes, const std::string& name);
+		bool GetAttributes(const tinygltf::Model& model, const tinygltf::Primitive& primitive, Type* attributes, std::size_t numAttributes, const std::string& name) const;
+		//! Set up the quantized stream of the attribute if all primitives share the same quantized format.
+		//! Returns false and leaves the stream empty otherwise.
+		bool PrepareQuantizedStream(const tinygltf::Model& model, const std::vector<const tinygltf::Primitive*>& primitives, const std::string& name, std::size_t numVertices, GLTFQuantizedStream* stream) const;
+		//! Copy the quantized attribute of the primitive into the reserved range of the stream
+		void CopyQuantizedAttributes(const tinygltf::Model& model, const tinygltf::Primitive& primitive, const std::string& name, const GLTFPrimMesh& primMesh, GLTFQuantizedStream* stream) const;
+		//! Optimize the index and vertex order of every primitive in parallel
+		void OptimizeMeshes();
+		//! Simplify every primitive into the LOD chain appended to the indices
+		void GenerateLods(bool optimizeMeshes);
+		//! Replace the quantized streams with the compressed encodings of the float streams
+		//! and report the largest encoding error of each attribute.
+		void CompressVertexAttributes(VertexFormat format);
 		//! Returns the SRT matrix combination of this node.
 		static glm::mat4 GetLocalMatrix(const GLTFNode& node);
 		//! Import materials from the model
 		void ImportMaterials(const tinygltf::Model& model);
-		//! Process mesh in the model
-		void ProcessMesh(const tinygltf::Model& model, const tinygltf::Primitive& mesh, VertexFormat format, const std::string& name);
+		//! Process mesh in the model and write it's attributes into the reserved range of the primMesh.
+		//! Primitives do not share any range, therefore this can be called in parallel.
+		void ProcessMesh(const tinygltf::Model& model, const tinygltf::Primitive& mesh, VertexFormat format, const GLTFPrimMesh& primMesh);
+		//! Import the morph target deltas of the primitive into its reserved ranges of _morphDeltas.
+		//! Primitives do not share any range, therefore this can be called in parallel.
+		void ProcessMorphTargets(const tinygltf::Model& model, const tinygltf::Primitive& mesh, const GLTFPrimMesh& primMesh);
 		//! Process node in the model recursively.
 		void ProcessNode(const tinygltf::Model& model, int nodeIdx, int parentIndex);
-		//! Update world coordinates of the given node and child nodes
-		void UpdateNode(int nodeIndex);
+		//! Recompute the world matrices of the dirty nodes and their descendants in one linear pass
+		void UpdateNodeTransforms();
 		//! Process animation in the model
 		void ProcessAnimation(const tinygltf::Model& model, const tinygltf::Animation& anim, std::size_t channelOffset, std::size_t samplerOffset);
 		//! Process animation channel and append it to _sceneChannels
-		void ProcessChannel(const tinygltf::Model& model, const tinygltf::AnimationChannel& channel);
+		void ProcessChannel(const tinygltf::Model& model, const tinygltf::AnimationChannel& channel, std::size_t samplerOffset);
 		//! Process animation sampler and append it to _sceneSamplers
 		void ProcessSampler(const tinygltf::Model& model, const tinygltf::AnimationSampler& sampler);
+		//! Group the channels of each animation into the tracks, then list the animated nodes and sample the first frame of each clip
+		void BuildAnimationTracks();
+		//! Size the pose for the animated nodes of the clip
+		void ResizePose(const GLTFAnimation& anim, GLTFPose* pose) const;
+		//! Copy the evaluated lanes of the track into the pose of its clip
+		void ScatterTrack(const GLTFTrack& track, GLTFPose* pose) const;
+		//! Replace the dense linear samplers of every animation by the cubic spline keys fitted within the error bound,
+		//! then report the keys, the memory and the largest error of each clip. The tracks must be rebuilt afterwards.
+		void ReduceKeyframes(float errorBound);
+		//! Find the path and the number of morph targets of the channels sampling the given sampler of the animation.
+		//! Returns false if no channel samples it or its channels do not agree, then the sampler cannot be rewritten.
+		bool GetSamplerTarget(const GLTFAnimation& anim, int samplerIndex, GLTFChannel::Path* path, int* numTargets) const;
+		//! Resample the samplers of every animation to the fixed rate and pack the keys if requested,
+		//! then report the memory and the largest error of each clip. The tracks must be rebuilt afterwards.
+		void BakeAnimations(const GLTFLoadOptions& options);
+		//! Pack the scalar weights keys of the sampler into the vec4 keys of four morph targets.
+		//! Returns false if the sampler does not hold the weights of the given number of targets.
+		static bool PackWeightsKeys(GLTFSampler& sampler, int numTargets);
+		//! Add the lanes sampling the keys of the sampler to the track, four morph targets per lane of the packed
+		//! weights keys or a single lane if numTargets is zero. Returns the number of added lanes.
+		static int AddSamplerLanes(AnimationTrack& track, const GLTFSampler& sampler, int numTargets);
+		//! Import the skins of the model into the flat joint arrays
+		void ImportSkins(const tinygltf::Model& model);
+		//! Recompute the joint palette of every skin from the node world matrices in one pass
+		void UpdateJointPalettes();
 		//! Calculate the scene dimension from loaded nodes.
 		void CalculateSceneDimension();
 		//! Compute the uninitialized cameras with parsed scene dimension.
@@ -281,9 +653,25 @@ namespace Core {
 		static void GetTextureID(const tinygltf::Value& value, const std::string& name, int& id);
 		//! Temporary storages for processing nodes.
 		std::unordered_map<unsigned int, std::vector<unsigned int>> _meshToPrimMap;
-		std::vector<unsigned int> _u32Buffer;
-		std::vector<unsigned short> _u16Buffer;
-		std::vector<unsigned char> _u8Buffer;
+		//! _sceneNodes index of each glTF node, -1 for the nodes which are not in _sceneNodes
+		std::vector<int> _nodeRemap;
+		//! Memory mapped source files and the base address of each model buffer
+		std::vector<std::unique_ptr<MappedFile>> _mappedFiles;
+		std::vector<const unsigned char*> _bufferData;
+		//! Frames counted by UpdateAnimation to stagger the reduced update rates of the nodes
+		unsigned int _animationFrame{ 0 };
+		AnimationStats _animationStats;
+		//! Sampled clip of each layer and the blended pose of the scene nodes accumulated from them
+		std::vector<GLTFPose> _layerPoses;
+		GLTFPose _blendPose;
+		//! Total weight of the blend layers per node for the translation, rotation, scale and weights
+		std::vector<glm::vec4> _blendSums;
+		//! Nodes written by the last layered update, they are reset to the rest pose once no layer animates them
+		std::vector<int> _blendedNodes;
+		//! Marks the nodes already collected by the current layered update
+		std::vector<unsigned char> _blendedFlags;
+		//! Node weights of every mask, one run of the scene nodes per mask
+		std::vector<float> _animationMasks;
 	};
 
 }
@@ -19,6 +19,10 @@ typedef SSIZE_T ssize_t;
 #include <sys/types.h>
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE2
+#endif
+
 #ifndef UNUSED_VARIABLE
 #define UNUSED_VARIABLE(x) ((void)x)
 #endif
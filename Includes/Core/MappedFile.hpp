@@ -0,0 +1,52 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <Core/Macros.hpp>
+#include <string>
+#include <cstddef>
+
+namespace Core {
+
+	//!
+	//! \brief      Read-only memory mapped file
+	//!
+	//! Pages of the file are loaded lazily by the OS when they are accessed and
+	//! they do not need to be copied into the heap. The mapping is released on
+	//! Close() or destruction.
+	//!
+	class MappedFile
+	{
+	public:
+		//! Default constructor
+		MappedFile();
+		//! Default destructor, unmap the file
+		~MappedFile();
+		//! Non-copyable, the mapping is owned by only one instance
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		//! Map the whole file with the given path. Returns success or not.
+		bool Open(const std::string& path);
+		//! Unmap the file
+		void Close();
+		//! Returns the address of the first byte of the file
+		inline const unsigned char* GetData() const
+		{
+			return _data;
+		}
+		//! Returns the file size in bytes
+		inline std::size_t GetSize() const
+		{
+			return _size;
+		}
+	private:
+		const unsigned char* _data{ nullptr };
+		std::size_t _size{ 0 };
+#if defined(WINDOWS)
+		void* _fileHandle{ nullptr };
+		void* _mappingHandle{ nullptr };
+#endif
+	};
+
+};
+
+#endif //! end of MappedFile.hpp
@@ -6,6 +6,7 @@
 
 #include <Core/Macros.hpp>
 #include <glm/gtx/quaternion.hpp>
+#include <algorithm>
 
 namespace Core
 {
@@ -45,12 +46,12 @@ namespace Core
 		}
 
 		template <typename Type>
-		Type CubicSpline(Type prev, Type next, const float keyframe)
+		Type CubicSpline(Type prevValue, Type prevOutTangent, Type nextInTangent, Type nextValue, const float keyframe, const float interval)
 		{
-			UNUSED_VARIABLE(prev);
-			UNUSED_VARIABLE(next);
-			UNUSED_VARIABLE(keyframe);
-			static_assert("Not implemented yet");
+			const float t2 = keyframe * keyframe;
+			const float t3 = t2 * keyframe;
+			return (2.0f * t3 - 3.0f * t2 + 1.0f) * prevValue + (t3 - 2.0f * t2 + keyframe) * interval * prevOutTangent +
+				   (-2.0f * t3 + 3.0f * t2) * nextValue + (t3 - t2) * interval * nextInTangent;
 		}
 
 		template <typename Type>
@@ -59,6 +60,28 @@ namespace Core
 			return keyframe >= 1.0 ? next : prev;
 		}
 	};
+
+	inline std::size_t FindKeyframe(const float* times, std::size_t count, float time, std::size_t hint)
+	{
+		if (count < 2 || time < times[1])
+			return 0;
+
+		const std::size_t last = count - 2;
+		if (time >= times[last])
+			return last;
+
+		//! Forward playback stays in the hinted interval or steps into the next one
+		if (hint < last && times[hint] <= time)
+		{
+			if (time < times[hint + 1])
+				return hint;
+			if (time < times[hint + 2])
+				return hint + 1;
+		}
+
+		//! times[1] <= time < times[last] here, the first key greater than the time is in [2, last]
+		return static_cast<std::size_t>(std::upper_bound(times + 2, times + last, time) - times) - 1;
+	}
 };
 
 #endif //! end of MathUtils-Impl.hpp
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef MATHUTILS_HPP
 #define MATHUTILS_HPP
 
+#include <cstddef>
 #include <functional>
 
 namespace Core
@@ -16,12 +17,26 @@ namespace Core
 		template <typename Type>
 		Type SLerp(Type prev, Type next, const float keyframe);
 
+		//! Hermite spline between the values with the out-tangent of the previous key and the in-tangent
+		//! of the next key, which are scaled by the interval between the keys as the glTF tangents are
 		template <typename Type>
-		Type CubicSpline(Type prev, Type next, const float keyframe);
+		Type CubicSpline(Type prevValue, Type prevOutTangent, Type nextInTangent, Type nextValue, const float keyframe, const float interval);
 
 		template <typename Type>
 		Type Step(Type prev, Type next, const float keyframe);
 	};
+
+	//!
+	//! \brief      Find the keyframe interval [times[i], times[i + 1]) containing the time
+	//!
+	//! The times must be sorted in the ascending order. The time before the first key maps to
+	//! the first interval and the time after the last key maps to the last interval.
+	//! The hint(previous result) and its next interval are tried first, therefore the forward
+	//! playback takes O(1) and the seeks fall back to the binary search.
+	//!
+	//! Returns zero if there are less than two keys.
+	//!
+	std::size_t FindKeyframe(const float* times, std::size_t count, float time, std::size_t hint);
 };
 
 #include <Core/MathUtils-Impl.hpp>
@@ -0,0 +1,70 @@
+#ifndef MESH_OPTIMIZER_HPP
+#define MESH_OPTIMIZER_HPP
+
+#include <glm/vec3.hpp>
+#include <cstddef>
+
+namespace Core {
+
+	//! Size of the simulated FIFO post-transform vertex cache
+	constexpr unsigned int kVertexCacheSize = 16;
+
+	//! Post-transform vertex cache statistics of an index buffer
+	struct VertexCacheStatistics
+	{
+		unsigned int vertexTransforms{ 0 };
+		float acmr{ 0.0f };  //! Average number of transformed vertices per triangle
+		float atvr{ 0.0f };  //! Average number of transforms per vertex, 1.0 is the best
+	};
+
+	//! Simulate the FIFO vertex cache over the triangle list
+	VertexCacheStatistics AnalyzeVertexCache(const unsigned int* indices, std::size_t indexCount, std::size_t vertexCount,
+											 unsigned int cacheSize = kVertexCacheSize);
+
+	//!
+	//! \brief      Reorder the triangles for the post-transform vertex cache (Tipsify)
+	//!
+	//! Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", 2007.
+	//! Every index must be less than vertexCount and the ranges must not overlap.
+	//!
+	void OptimizeVertexCache(unsigned int* dst, const unsigned int* src, std::size_t indexCount, std::size_t vertexCount,
+							 unsigned int cacheSize = kVertexCacheSize);
+
+	//!
+	//! \brief      Reorder the clusters of the cache optimized triangles to reduce overdraw
+	//!
+	//! The triangles are split where the cache is flushed and then wherever the ACMR of the piece
+	//! stays under threshold times the ACMR of the enclosing piece. The clusters facing outward
+	//! from the mesh centroid are drawn first since they are likely to occlude the others.
+	//! The ranges must not overlap.
+	//!
+	void OptimizeOverdraw(unsigned int* dst, const unsigned int* src, std::size_t indexCount, const glm::vec3* positions,
+						  std::size_t vertexCount, float threshold = 1.05f, unsigned int cacheSize = kVertexCacheSize);
+
+	//!
+	//! \brief      Build the vertex remap table in the order of the first use by the indices
+	//!
+	//! remap[oldIndex] gives the new index, the unreferenced vertices are moved to the end.
+	//! Returns the number of the referenced vertices.
+	//!
+	std::size_t BuildVertexFetchRemap(unsigned int* remap, const unsigned int* indices, std::size_t indexCount, std::size_t vertexCount);
+
+	//!
+	//! \brief      Simplify the triangles with the quadric error metric (Garland and Heckbert, 1997)
+	//!
+	//! Edges are collapsed into their existing endpoints, therefore the result shares the vertices.
+	//! The vertices with the same position(e.g. on the UV seams) are collapsed together, and the
+	//! vertices on the open borders only move along the borders. Collapses flipping the triangles
+	//! are rejected. Stops when the number of indices reaches targetIndexCount or the next collapse
+	//! exceeds maxError.
+	//!
+	//! \param dst - destination with room for indexCount indices, must not overlap the source
+	//! \param resultError - largest object space distance error of the collapses, can be nullptr
+	//!
+	//! Returns the number of the written indices.
+	//!
+	std::size_t SimplifyMesh(unsigned int* dst, const unsigned int* indices, std::size_t indexCount, const glm::vec3* positions,
+							 std::size_t vertexCount, std::size_t targetIndexCount, float maxError, float* resultError);
+};
+
+#endif //! end of MeshOptimizer.hpp
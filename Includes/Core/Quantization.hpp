@@ -0,0 +1,60 @@
+#ifndef QUANTIZATION_HPP
+#define QUANTIZATION_HPP
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include <cstddef>
+
+namespace Core {
+
+	//!
+	//! \brief      Convert quantized vertex attributes into floats
+	//!
+	//! Component types follow the glTF(and OpenGL) enums : BYTE, UNSIGNED_BYTE, SHORT,
+	//! UNSIGNED_SHORT and FLOAT. Normalized integers are mapped to [0, 1] or [-1, 1] as
+	//! described in the glTF specification, the others are converted as they are.
+	//!
+	//! \param src - address of the first element
+	//! \param srcStride - distance between the elements in bytes
+	//! \param componentType - type of each component in the source
+	//! \param normalized - whether the integer components are normalized
+	//! \param numComponents - number of components of each source element (1 ~ 4)
+	//! \param dst - destination of the tightly packed float elements
+	//! \param dstComponents - number of floats of each destination element
+	//! \param count - number of elements
+	//!
+	//! Extra destination components are left untouched. Returns false if the component type is not supported.
+	//!
+	bool DequantizeAttributes(const unsigned char* src, std::size_t srcStride, int componentType, bool normalized,
+							  std::size_t numComponents, float* dst, std::size_t dstComponents, std::size_t count);
+
+	//! Returns the size of the given component type in bytes, zero if it is unknown
+	std::size_t GetComponentSize(int componentType);
+
+	//! Widen 8-bit or 16-bit indices into 32-bit, the ranges must not overlap
+	void WidenIndices(const unsigned char* src, unsigned int* dst, std::size_t count);
+	void WidenIndices(const unsigned short* src, unsigned int* dst, std::size_t count);
+
+	//! Narrow 32-bit indices into 16-bit, every index must be less than 65536
+	void NarrowIndices(const unsigned int* src, unsigned short* dst, std::size_t count);
+
+	//! OpenGL component types of the compressed attributes which glTF does not define
+	constexpr int kComponentTypeHalfFloat = 0x140B;			//! GL_HALF_FLOAT
+	constexpr int kComponentTypeInt2101010Rev = 0x8D9F;		//! GL_INT_2_10_10_10_REV
+
+	//! Map the direction onto the octahedron unfolded into [-1, 1]^2, zero vector maps to +Z
+	glm::vec2 EncodeOctahedral(const glm::vec3& direction);
+	//! Returns the unit direction of the octahedral coordinates, same as the decoding in vertex.glsl
+	glm::vec3 DecodeOctahedral(const glm::vec2& encoded);
+
+	//! Pack the unit quaternion (x, y, z, w) into 48 bits : the index of the largest component in 2 bits and
+	//! the other three in 15 bits each over [-1/sqrt(2), 1/sqrt(2)], within 2.2e-5 per component.
+	//! The sign of the quaternion is flipped to make the largest component positive.
+	glm::u16vec3 EncodeSmallestThree(const glm::vec4& quaternion);
+	//! Returns the unit quaternion of the smallest three encoding
+	glm::vec4 DecodeSmallestThree(const glm::u16vec3& encoded);
+};
+
+#endif //! end of Quantization.hpp
@@ -0,0 +1,20 @@
+#ifndef RADIX_SORT_HPP
+#define RADIX_SORT_HPP
+
+#include <cstdint>
+#include <vector>
+
+namespace Core {
+
+	//!
+	//! \brief      Stable LSD radix sort of the 64-bit keys with their values, 8 bits per pass
+	//!
+	//! The passes whose byte is the same for every key are skipped, therefore the keys using
+	//! only their upper bits take as many passes as the bytes they use. The scratch arrays
+	//! are resized as needed and can be kept between the calls.
+	//!
+	void RadixSort(std::vector<std::uint64_t>& keys, std::vector<int>& values,
+				   std::vector<std::uint64_t>& scratchKeys, std::vector<int>& scratchValues);
+};
+
+#endif //! end of RadixSort.hpp
\ No newline at end of file
@@ -0,0 +1,65 @@
+#ifndef SCRATCH_ARENA_HPP
+#define SCRATCH_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace Core {
+
+	//!
+	//! \brief      Linear allocator for the temporary arrays of one pass
+	//!
+	//! Allocations are bumped from the current block and released all at once by Reset()
+	//! or destruction. The arrays are uninitialized and aligned for SSE loads. When the
+	//! block runs out a new block is added, the next Reset() merges them into one block.
+	//! Not thread-safe, but the returned arrays can be shared by the jobs of the pass.
+	//!
+	class ScratchArena
+	{
+	public:
+		//! Alignment of every allocation in bytes
+		static constexpr std::size_t kAlignment = 16;
+		//! Constructor with the initial capacity in bytes
+		explicit ScratchArena(std::size_t capacity = 0);
+		//! Default destructor
+		~ScratchArena();
+		//! Non-copyable, the arrays are owned by only one instance
+		ScratchArena(const ScratchArena&) = delete;
+		ScratchArena& operator=(const ScratchArena&) = delete;
+		//! Returns an uninitialized array of the given number of elements
+		template <typename Type>
+		Type* Allocate(std::size_t count)
+		{
+			static_assert(std::is_trivially_destructible<Type>::value, "Destructors of the arena arrays are never called");
+			static_assert(alignof(Type) <= kAlignment, "Over-aligned types are not supported");
+			return static_cast<Type*>(AllocateBytes(count * sizeof(Type)));
+		}
+		//! Release every allocation while keeping the capacity
+		void Reset();
+		//! Returns the number of the allocated bytes since the last reset
+		inline std::size_t GetUsedBytes() const
+		{
+			return _usedBytes;
+		}
+	private:
+		//! Returns aligned storage of the given size, adding a block if needed
+		void* AllocateBytes(std::size_t bytes);
+		//! Add the block which holds at least the given bytes
+		void AddBlock(std::size_t bytes);
+
+		struct Block
+		{
+			std::unique_ptr<unsigned char[]> storage;
+			unsigned char* begin{ nullptr };  //! Aligned start of the storage
+			std::size_t capacity{ 0 };
+		};
+		std::vector<Block> _blocks;
+		std::size_t _offset{ 0 };  //! Offset in the last block
+		std::size_t _usedBytes{ 0 };
+	};
+
+};
+
+#endif //! end of ScratchArena.hpp
@@ -0,0 +1,26 @@
+#ifndef SKINNING_HPP
+#define SKINNING_HPP
+
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include <cstddef>
+
+namespace Core {
+
+	//!
+	//! \brief      Linear blend skinning of the vertices on the CPU, same as vertex.glsl does
+	//!
+	//! Each vertex blends up to four matrices of the palette with its normalized 16-bit weights,
+	//! then transforms the position and the normal with the blended matrix. The joints out of
+	//! the palette are ignored. The normals are normalized after the transform and may be null.
+	//!
+	//! Used as the reference of the GPU skinning for the validation and the headless runs.
+	//! Vertices are processed in parallel chunks, four weights per SSE instruction.
+	//!
+	void SkinVertices(glm::vec3* outPositions, glm::vec3* outNormals, const glm::vec3* positions, const glm::vec3* normals,
+					  const glm::u16vec4* joints, const glm::u16vec4* weights, std::size_t vertexCount,
+					  const glm::mat4* palette, std::size_t jointCount);
+};
+
+#endif //! end of Skinning.hpp
@@ -0,0 +1,33 @@
+#ifndef TANGENT_GENERATOR_HPP
+#define TANGENT_GENERATOR_HPP
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <cstddef>
+
+namespace Core {
+
+	//!
+	//! \brief      Generate the per-vertex tangents of the triangles in the MikkTSpace convention
+	//!
+	//! Follows the default MikkTSpace algorithm that glTF refers to : the texture space
+	//! derivative of each triangle is projected onto the tangent plane of the vertex normal,
+	//! and then averaged with the weights of the corner angles. The vertices with equal
+	//! position, normal and texture coordinates are treated as one vertex like MikkTSpace does.
+	//!
+	//! MikkTSpace would split the vertex whose triangles have the opposite texture space
+	//! orientations, since the vertices are shared here the dominant orientation is used instead.
+	//! Vertices without any valid triangle get an arbitrary tangent perpendicular to the normal.
+	//!
+	//! The bitangent is cross(normal, tangent.xyz) * tangent.w and points along the decreasing V
+	//! of glTF, same as the tangents written by the exporters.
+	//!
+	//! Triangles and vertices are processed in parallel chunks, the result does not depend
+	//! on the number of threads.
+	//!
+	void GenerateTangents(glm::vec4* tangents, const unsigned int* indices, std::size_t indexCount, const glm::vec3* positions,
+						  const glm::vec3* normals, const glm::vec2* texCoords, std::size_t vertexCount);
+};
+
+#endif //! end of TangentGenerator.hpp
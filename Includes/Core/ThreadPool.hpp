@@ -0,0 +1,81 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Core {
+
+	//!
+	//! \brief      Fixed size worker thread pool
+	//!
+	//! All workers pull jobs from one shared queue. A thread waiting in ParallelFor
+	//! keeps executing the pending chunks of its own call, therefore ParallelFor can be
+	//! nested inside of the job without deadlock and never runs the unrelated jobs inline.
+	//!
+	class ThreadPool
+	{
+	public:
+		using Job = std::function<void()>;
+		using RangeJob = std::function<void(std::size_t, std::size_t)>;
+		//! Constructor with the number of worker threads.
+		//! Zero means the number of hardware threads minus the calling thread.
+		explicit ThreadPool(std::size_t numThreads = 0);
+		//! Default destructor, join all worker threads
+		~ThreadPool();
+		//! Returns the process-wide shared thread pool
+		static ThreadPool& GetInstance();
+		//! Returns the number of threads participating ParallelFor (workers + caller)
+		std::size_t GetConcurrency() const;
+		//! Push the job to the queue
+		void Enqueue(Job job);
+		//!
+		//! \brief      Split [0, count) into chunks and run them over the workers.
+		//!
+		//! \param count - total number of items
+		//! \param grainSize - maximum number of items of one chunk
+		//! \param job - callback invoked with the half-open range [begin, end)
+		//!
+		//! Returns after all chunks are finished. The calling thread executes chunks too.
+		//! The first exception thrown by a chunk is rethrown after all chunks are finished.
+		void ParallelFor(std::size_t count, std::size_t grainSize, const RangeJob& job);
+		//! Run the pending jobs on the calling thread until the flag is set,
+		//! therefore the enqueued job setting it completes even without any worker.
+		void WaitFor(const std::atomic<bool>& done);
+	private:
+		//! Chunks of one ParallelFor call
+		struct JobGroup
+		{
+			std::atomic<std::size_t> remaining{ 0 };
+			std::atomic<bool> failed{ false };
+			//! First exception of the chunks, written once by the chunk which set failed
+			std::exception_ptr exception;
+		};
+		//! Queued job with the group it belongs to, nullptr for the enqueued jobs
+		struct PendingJob
+		{
+			Job job;
+			const JobGroup* group{ nullptr };
+		};
+		//! Pop one pending job of the group and run it, any job if the group is nullptr.
+		//! Returns false if there was no such job.
+		bool RunPendingJob(const JobGroup* group = nullptr);
+		//! Main loop of the worker threads
+		void WorkerLoop();
+
+		std::vector<std::thread> _workers;
+		std::deque<PendingJob> _jobs;
+		std::mutex _mutex;
+		std::condition_variable _condition;
+		bool _stop{ false };
+	};
+
+};
+
+#endif //! end of ThreadPool.hpp
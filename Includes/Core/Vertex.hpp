@@ -66,6 +66,22 @@ namespace Core {
         Position3Normal3TexCoord2Color4Tangent4 = Position3Normal3TexCoord2Color4 | Tangent4,
     };
 
+    //! Vertex buffer layouts of the vertex format.
+    enum class VertexLayout
+    {
+        //! One buffer per attribute (structure of arrays).
+        Separate = 0,
+
+        //! All attributes interleaved in one buffer.
+        Interleaved = 1,
+
+        //! Positions in their own buffer for depth-only passes, the others interleaved.
+        PositionSplit = 2,
+
+        //! Number of layouts
+        Count = 3,
+    };
+
     //! Bit-wise operator for two vertex formats
     inline VertexFormat operator|(VertexFormat a, VertexFormat b)
     {
@@ -95,6 +111,13 @@ namespace Core {
 
         //! Returns size of a single vertex with given format in bytes.
         static std::size_t GetSizeInBytes(VertexFormat format);
+
+        //! Returns size of a single compressed vertex with given format in bytes.
+        //! Positions take 4 x uint16, texture coordinates half floats and the others 32 bits.
+        static std::size_t GetCompressedSizeInBytes(VertexFormat format);
+
+        //! Returns the name of the given vertex layout.
+        static const char* GetLayoutName(VertexLayout layout);
     };
 
 }  
@@ -0,0 +1,63 @@
+#ifndef BVH_HPP
+#define BVH_HPP
+
+#include <GL3/BoundingBox.hpp>
+#include <glm/vec4.hpp>
+#include <array>
+#include <atomic>
+#include <vector>
+
+namespace GL3 {
+
+	//!
+	//! \brief      Bounding volume hierarchy over the boxes of the drawn items
+	//!
+	//! Built top-down with the binned surface area heuristic, the large subtrees are built
+	//! on the thread pool. The moving items refit the nodes above them instead of rebuilding,
+	//! the frustum walk tests four planes at once with SSE.
+	//!
+	class BVH
+	{
+	public:
+		//! Default constructor
+		BVH();
+		//! Default destructor
+		~BVH();
+		//! Build the hierarchy over the given items, the boxes are indexed by the item
+		void Build(const std::vector< BoundingBox >& boxes, std::vector< int > items);
+		//! Update the bounds of the nodes above the changed items from their new boxes
+		void Refit(const std::vector< BoundingBox >& boxes, const std::vector< int >& changedItems);
+		//! Append the items whose box is not fully behind one of the planes, the normals point inside
+		void Cull(const std::array< glm::vec4, 6 >& planes, std::vector< int >* visibleItems) const;
+		//! Returns the number of the nodes
+		size_t GetNumNodes() const;
+		//! Remove every node and item
+		void Clear();
+	private:
+		//! Leaves have no child, the items of every node are contiguous in _items
+		struct Node
+		{
+			glm::vec3 boundMin{ 0.0f };
+			int firstChild{ -1 };
+			glm::vec3 boundMax{ 0.0f };
+			int parent{ -1 };
+			int firstItem{ 0 };
+			int numItems{ 0 };
+		};
+		//! Split the items [begin, end) of the node, the children are allocated from numNodes
+		void BuildNode(const std::vector< BoundingBox >& boxes, int nodeIdx, int begin, int end, std::atomic< int >& numNodes);
+		//! Recompute the bounds of the node from its children or its items
+		void UpdateBounds(const std::vector< BoundingBox >& boxes, Node& node) const;
+
+		std::vector< Node > _nodes;
+		std::vector< int > _items;
+		//! Leaf of each item, -1 if the item is not in the hierarchy
+		std::vector< int > _itemLeaves;
+		//! Scratch of the refit
+		std::vector< int > _refitNodes;
+		std::vector< unsigned char > _refitMarks;
+	};
+
+};
+
+#endif //! end of BVH.hpp
\ No newline at end of file
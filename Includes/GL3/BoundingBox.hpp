@@ -2,6 +2,7 @@
 #define BOUDNING_BOX_HPP
 
 #include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
 
 namespace GL3 {
 
@@ -25,6 +26,13 @@ namespace GL3 {
 		void Merge(const BoundingBox& bb);
 		//! Reset the bounding box
 		void Reset();
+		//! Returns the box enclosing the eight transformed corners of this box
+		BoundingBox Transform(const glm::mat4& matrix) const;
+		//! Returns whether nothing has been merged yet
+		inline bool IsEmpty() const
+		{
+			return _bFirstMerge;
+		}
 		//! Corner getter
 		inline glm::vec3 GetLowerCorner() const
 		{
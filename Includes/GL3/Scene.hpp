@@ -2,14 +2,22 @@
 #define SCENE_HPP
 
 #include <GL3/GLTypes.hpp>
+#include <GL3/BVH.hpp>
 #include <GL3/DebugUtils.hpp>
 #include <Core/GLTFScene.hpp>
 #include <Core/Vertex.hpp>
 #include <glm/mat4x4.hpp>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <memory>
 #include <vector>
 
+//! Shared with the shaders, defined by gltf.glsl
+struct GltfMorphTarget;
+struct GltfDrawRecord;
+
 namespace GL3 {
 
 	class Shader;
@@ -22,34 +30,266 @@ namespace GL3 {
 	public:
 		//! Scene node matrix type definition with pair of glm::mat4.
 		using NodeMatrix = std::pair<glm::mat4, glm::mat4>;
+		//! Where the animation of the next frame is evaluated
+		enum class UpdateMode
+		{
+			//! On a worker thread while the current frame is drawn
+			Pipelined = 0,
+			//! On the calling thread before the frame is drawn, for the reproducible runs
+			Deterministic = 1
+		};
 		//! Default constructor
 		Scene();
 		//! Default destructor
 		~Scene();
 		//! Load GLTFScene from the given scene filename and generate buffers 
-		bool Initialize(const std::string& filename, Core::VertexFormat format);
-		//! Update the scene for animating
+		bool Initialize(const std::string& filename, Core::VertexFormat format, const Core::GLTFLoadOptions& options = Core::GLTFLoadOptions(),
+						Core::VertexLayout layout = Core::VertexLayout::Separate);
+		//! Upload the staged frame of the current time and issue the next frame in the pipelined mode
 		void Update(double dt);
-		//! Render the whole nodes of the parsed gltf-scene
-		void Render(const std::shared_ptr< Shader >& shader, GLenum alphaMode) const;
+		//! Set where the animation of the next frame is evaluated, pipelined by default
+		void SetUpdateMode(UpdateMode mode);
+		//! Returns the channel counters of the frame being drawn
+		const AnimationStats& GetFrameAnimationStats() const;
+		//! Render the whole nodes of the parsed gltf-scene : the opaque primitives front to back with the opaque shader
+		//! if given, then the alpha tested ones and the blended ones back to front with the given shader
+		void Render(const std::shared_ptr< Shader >& shader, const std::shared_ptr< Shader >& opaqueShader = nullptr);
+		//! Submit the primitives with one multi-draw indirect per index type instead of one draw per primitive, enabled by default
+		void SetIndirectDraws(bool enabled);
+		//! Cull the indirect draws against the camera frustum by a compute pass, the number of visible draws
+		//! is read back one frame late only if requested
+		void SetGpuCulling(bool enabled, bool readbackStats);
+		//! Cull the indirect draws hidden by the depth of the bound framebuffer in two phases : the draws visible
+		//! in the last frame are drawn first, then the others are tested against the Hi-Z pyramid of their depth
+		void SetOcclusionCulling(bool enabled);
+		//! Cull the draws against the LOD camera frustum by walking the hierarchy of their world boxes on the CPU,
+		//! the hierarchy is refit to the animated nodes
+		void SetCpuCulling(bool enabled);
+		//! Returns the number of the draws which passed the GPU culling in the last read back frame
+		size_t GetNumVisibleDraws() const;
 		//! Clean up the generated resources
 		void CleanUp();
 		//! Returns the number of animations
 		size_t GetNumAnimations() const;
 		//! Set current scene animation index
 		void SetAnimIndex(size_t animIndex);
+		//! Blend the given layers instead of the single animation, each layer plays from its own time.
+		//! Empty layers return to the single animation.
+		void SetAnimationLayers(const std::vector< Core::GLTFAnimationLayer >& layers);
+		//! Set the camera used for selecting the LOD of each node, zero viewport height disables the selection
+		void SetLodCamera(const glm::mat4& view, const glm::mat4& projection, int viewportHeight);
+		//! Set the largest allowed screen space error of the selected LOD in pixels
+		void SetLodPixelError(float pixelError);
+		//! Enable the animation LOD with the LOD camera : the nodes out of the frustum are frozen and the nodes
+		//! smaller than the given size in pixels update every reducedPeriod frames. They catch up once they are visible.
+		void SetAnimationLod(bool enabled, float pixelSize, int reducedPeriod);
 	private:
-		//! Update matrix buffer with modified scene nodes
-		void UpdateMatrixBuffer();
+		//! Index type and byte offset of the primitive in the element buffer
+		struct IndexRange
+		{
+			GLenum type{ 0 };  //! GL_UNSIGNED_INT or GL_UNSIGNED_SHORT
+			size_t offset{ 0 };
+			unsigned int count{ 0 };
+		};
+		//! Render pass of the draws from the alpha mode of their material, in the submission order
+		enum class RenderPass
+		{
+			Opaque = 0,
+			Mask = 1,
+			Blend = 2
+		};
+		//! Consecutive commands of the render queue submitted by one multi-draw
+		struct DrawRun
+		{
+			RenderPass pass{ RenderPass::Opaque };
+			GLenum type{ 0 };
+			int first{ 0 };
+			int count{ 0 };
+		};
+		//! Pass of the culling shader, same as the CULL_* values of cull.comp
+		enum class CullPhase
+		{
+			Frustum = 0,
+			Visible = 1,
+			Occlusion = 2
+		};
+		//! Layout of DrawElementsIndirectCommand
+		struct DrawCommand
+		{
+			GLuint count{ 0 };
+			GLuint instanceCount{ 0 };
+			GLuint firstIndex{ 0 };
+			GLint baseVertex{ 0 };
+			GLuint baseInstance{ 0 }; //! Index of the draw record
+		};
+		//! Node and primitive of each draw in the node order
+		struct DrawItem
+		{
+			int nodeIdx{ 0 };
+			unsigned int meshIdx{ 0 };
+		};
+		//! Scene state of one frame, written by the update and read by the upload and the draws
+		struct FrameState
+		{
+			//! Inputs captured on the GL thread when the frame is issued
+			float time{ 0.0f };
+			size_t animIndex{ 0 };
+			std::vector< Core::GLTFAnimationLayer > layers;
+			bool sceneModified{ false };
+			AnimationStats stats;
+			//! Matrices of every drawn node and the ranges of them changed by the frame
+			std::vector< NodeMatrix > matrices;
+			std::vector< std::pair< int, int > > matrixRanges;
+			std::vector< glm::mat4 > jointPalette;
+			std::vector< float > morphWeights;
+		};
+		//! Capture the inputs of the frame and select the animation LOD, called on the GL thread while no frame is staged
+		void IssueFrame(FrameState& frame);
+		//! Evaluate the animation of the issued frame and stage its matrices, the previous frame is read only
+		void StageFrame(FrameState& frame, const FrameState& previous);
+		//! Upload the changes of the staged frame
+		void UploadFrame(const FrameState& frame);
+		//! Wait for the frame staged by the worker if any
+		void WaitForFrame();
+		//! Compute the matrices of the drawn nodes in the node range [firstNode, lastNode) into the frame
+		void StageMatrices(FrameState& frame, int firstNode, int lastNode) const;
+		//! Select the update period of each node from its bounds seen by the LOD camera, the joints and the ancestors
+		//! of the drawn nodes update as often as them
+		void UpdateAnimationLods();
+		//! Rebuild and upload the morph targets with a non-zero weight of the drawn primitives whose weights changed
+		void UpdateMorphBuffer(const std::vector< float >& morphWeights);
+		//! Create the draw commands, the draw records and the draw index buffer of the indirect draws
+		void CreateDrawBuffers();
+		//! Sort the draws by their pass, index type, depth and material unless the frame and the eye kept the last order
+		void BuildRenderQueue(const FrameState& frame);
+		//! Build the draw records from the morph ranges and upload them
+		void UpdateDrawRecords();
+		//! Submit the drawn primitives with the selected LOD of the given frame by the indirect commands, the opaque pass
+		//! with the opaque shader and the others with the given one
+		void DrawIndirect(const std::shared_ptr< Shader >& opaqueShader, const std::shared_ptr< Shader >& shader, const FrameState& frame);
+		//! Compact the commands of the draw command buffer passing the given phase into the culled command buffer
+		void CullDraws(CullPhase phase);
+		//! Copy the draw counts of this frame into the next readback slot and fence it, skipped while the slot is in flight
+		void CopyDrawCounts();
+		//! Read the newest draw counts whose fence is signalled without waiting for the pending ones
+		void ReadDrawCounts();
+		//! Submit the commands of the given pass from the given buffer, one multi-draw per run
+		void SubmitCommands(GLuint commandBuffer, RenderPass pass) const;
+		//! Enable the alpha blending without the depth writes for the blend pass
+		void BeginBlendPass() const;
+		//! Restore the blending and the depth writes of the other passes
+		void EndBlendPass() const;
+		//! Reduce the given depth texture into the Hi-Z pyramid, keeping the farthest depth
+		void BuildHiZ(GLuint depthTexture);
+		//! Returns the depth texture attached to the bound draw framebuffer, 0 if there is none
+		GLuint GetBoundDepthTexture() const;
+		//! Submit the drawn primitives of the render queue range [first, last) with the selected LOD of the given frame one by one
+		void DrawDirect(const std::shared_ptr< Shader >& shader, const FrameState& frame, int first, int last) const;
+		//! Select the visible draws from the hierarchy
+		void CullDrawsCpu();
+		//! Update the world boxes of the draws whose matrices were changed by the frame and refit the hierarchy
+		void RefitDrawBoxes(const FrameState& frame);
+		//! Compute the world boxes of the draws [firstDraw, lastDraw) from the matrices of the frame
+		void UpdateDrawBoxes(const FrameState& frame, int firstDraw, int lastDraw);
+		//! Returns the object space error to pixels scale of the node, zero keeps the full detail
+		float GetProjectedScale(const FrameState& frame, size_t nodeIdx) const;
+		//! Create the vertex buffers of the format packed in the given layout
+		void CreateVertexBuffers(Core::VertexFormat format, Core::VertexLayout layout);
+		//! Create the element buffer, 16-bit indices are packed after the 32-bit ones if requested
+		void CreateElementBuffer(bool shortIndices);
+		//! Compute the local bounding sphere of each node from its primitives
+		void CreateNodeSpheres();
+		//! Returns the coarsest LOD of the primitive whose projected error stays under the pixel error
+		size_t SelectLod(const GLTFPrimMesh& primMesh, float projectedScale) const;
 
 		std::vector< GLuint > _textures;
 		std::vector< GLuint > _buffers;
+		//! Index ranges of each primitive, LOD 0 first
+		std::vector< std::vector< IndexRange > > _indexRanges;
+		std::vector< glm::vec4 > _nodeSpheres;
+		//! Index of the first matrix of the node range starting at each node, one more for the end
+		std::vector< int > _matrixIndices;
+		//! First slot and count of the morph targets of each drawn primitive in the morph target buffer
+		std::vector< std::pair< int, int > > _morphRanges;
+		//! Copy of the morph target buffer and of the weights it was last built from
+		std::vector< GltfMorphTarget > _morphTargetData;
+		std::vector< float > _uploadedMorphWeights;
+		//! Copy of the draw record buffer
+		std::vector< GltfDrawRecord > _drawRecords;
+		std::vector< DrawItem > _drawItems;
+		//! Draws in the submission order : the opaque then the masked ones by index type, front to back and by material,
+		//! then the blended ones back to front
+		std::vector< int > _queueOrder;
+		std::vector< DrawRun > _queueRuns;
+		//! First command of the opaque 32-bit, opaque 16-bit, mask 32-bit, mask 16-bit and blend groups
+		std::array< int, 5 > _queueGroups{};
+		std::vector< std::uint64_t > _sortKeys;
+		std::vector< std::uint64_t > _sortScratchKeys;
+		std::vector< int > _sortScratchValues;
+		//! Eye of the last sort, the queue is sorted again once the eye moves away or the matrices change
+		glm::vec3 _queueEye{ 0.0f, 0.0f, 0.0f };
+		bool _queueDirty{ true };
+		size_t _numBlendDraws{ 0 };
+		//! Zero if the draw is culled, read as the instance count of the indirect commands
+		std::vector< unsigned char > _drawVisible;
+		//! First draw of each matrix, one more for the end
+		std::vector< int > _matrixFirstDraws;
+		std::vector< BoundingBox > _drawBoxes;
+		std::vector< int > _bvhItems;
+		std::vector< int > _visibleDraws;
+		std::vector< int > _changedDraws;
+		BVH _drawBvh;
+		bool _cpuCulling{ false };
+		//! Commands of the last submission, uploaded only when the selected LODs change
+		std::vector< DrawCommand > _drawCommands;
+		glm::vec3 _lodEye{ 0.0f, 0.0f, 0.0f };
+		float _lodProjectionScale{ 0.0f };
+		float _lodPixelError{ 1.0f };
+		//! Frustum planes of the LOD camera in the world space, the normals point inside
+		std::array< glm::vec4, 6 > _lodFrustum;
+		bool _animationLod{ false };
+		float _animationLodPixelSize{ 0.0f };
+		int _animationLodPeriod{ 1 };
 		DebugUtils _debug;
 		GLuint _vao{ 0 }, _ebo{ 0 };
 		GLuint _matrixBuffer{ 0 };
 		GLuint _materialBuffer{ 0 };
+		GLuint _jointBuffer{ 0 };
+		GLuint _morphDeltaBuffer{ 0 };
+		GLuint _morphTargetBuffer{ 0 };
+		GLuint _drawCommandBuffer{ 0 };
+		GLuint _drawRecordBuffer{ 0 };
+		GLuint _drawIndexBuffer{ 0 };
+		bool _indirectDraws{ true };
+		std::unique_ptr< Shader > _cullShader;
+		GLuint _culledCommandBuffer{ 0 };
+		GLuint _drawCountBuffer{ 0 };
+		//! Ring of the draw count copies in a persistently mapped buffer, a slot is read once its fence is signalled
+		static constexpr int kDrawCountSlots = 3;
+		GLuint _drawCountReadback{ 0 };
+		const GLuint* _drawCountMapped{ nullptr };
+		std::array< GLsync, kDrawCountSlots > _drawCountFences{};
+		int _drawCountSlot{ 0 };
+		bool _gpuCulling{ false };
+		bool _cullStats{ false };
+		size_t _numVisibleDraws{ 0 };
+		//! Texture unit of the Hi-Z pyramid, after the material textures of output.glsl
+		static constexpr GLuint kHiZTextureUnit = 23;
+		std::unique_ptr< Shader > _hiZShader;
+		GLuint _hiZTexture{ 0 };
+		GLuint _visibilityBuffer{ 0 };
+		int _hiZWidth{ 0 }, _hiZHeight{ 0 }, _hiZLevels{ 1 };
+		bool _occlusionCulling{ false };
 		double _timeElapsed{ 0.0 };
+		bool _compressedAttributes{ false };
 		size_t _animIndex{ 0 };
+		std::vector< Core::GLTFAnimationLayer > _animationLayers;
+		//! Double-buffered frames : the front one is drawn while the other one is staged by the worker
+		std::array< FrameState, 2 > _frames;
+		std::atomic< int > _frontFrame{ 0 };
+		std::atomic< bool > _frameStaged{ true };
+		bool _frameInFlight{ false };
+		UpdateMode _updateMode{ UpdateMode::Pipelined };
 	};
 
 };
@@ -27,6 +27,13 @@ protected:
 	void OnProcessResize(int width, int height) override;
 
 private:
+	//! Parse the vertex layout from it's name, returns false if unknown
+	static bool ParseVertexLayout(const std::string& name, Core::VertexLayout* layout);
+	//! Parse the comma separated animation layers and register their masks to the scene, returns false if malformed
+	bool ParseAnimationLayers(const std::string& description, std::vector<Core::GLTFAnimationLayer>* layers);
+	//! Measure the geometry processing time of the scene in every vertex layout
+	void BenchmarkVertexLayouts(const std::string& filename, Core::VertexFormat format, const Core::GLTFLoadOptions& options, int numFrames);
+
 	struct SceneData {
 		glm::vec4	lightDirection { 1.0f };
 		float		lightIntensity{ 1.0f };
@@ -41,6 +48,14 @@ private:
 	GL3::SkyDome _skyDome;
 	GL3::DebugUtils _debug;
 	GLuint _uniformBuffer;
+	int _viewportHeight{ 0 };
+	//! Animation channels counted over the last second with the animation LOD
+	bool _reportAnimationStats{ false };
+	std::size_t _evaluatedChannels{ 0 };
+	std::size_t _skippedChannels{ 0 };
+	double _statsElapsed{ 0.0 };
+	bool _reportCullStats{ false };
+	double _cullStatsElapsed{ 0.0 };
 };
 
 #endif //! end of GLTFSceneApp.hpp
\ No newline at end of file
@@ -29,3 +29,39 @@ struct GltfShadeMaterial
 	int shadingModel;  // 120, 0: metallic-roughness, 1: specular-glossiness 
 	int padding[2];
 };
+
+// Delta of one vertex attribute of the morph target
+struct GltfMorphDelta
+{
+	vec3 delta;  // 12
+	uint vertex; // 16, index of the vertex in the scene vertex buffers
+};
+
+// Per-draw inputs of the multi-draw indirect, selected by the base instance of the draw command
+struct GltfDrawRecord
+{
+	vec4 positionOffset; // 16, xyz : bounds of the compressed positions
+	vec4 positionScale;  // 32
+	vec4 boundCenter;    // 48, xyz : local bounding box of the primitive
+	vec4 boundExtent;    // 64
+	int  instanceIdx;    // 68, node matrix
+	int  materialIdx;    // 72
+	int  jointOffset;    // 76, -1 if the node is not skinned
+	int  morphOffset;    // 80
+	int  morphCount;     // 84
+	int  padding[3];     // 96
+};
+
+// Morph target with a non-zero weight of the drawn primitive.
+// Dense deltas are indexed by the vertex from their base, the sparse ones are searched in the vertex order.
+struct GltfMorphTarget
+{
+	int   positionBase;  // 4
+	int   positionCount; // 8, zero if the target does not move the positions
+	int   normalBase;    // 12
+	int   normalCount;   // 16
+	int   tangentBase;   // 20
+	int   tangentCount;  // 24
+	int   sparseMask;    // 28, 1 : position, 2 : normal, 4 : tangent
+	float weight;        // 32
+};
@@ -11,8 +11,14 @@ layout(location = 0) in VSOUT
 	vec3 normal;
 	vec4 color;
 	vec2 texCoord;
+	flat int materialIdx;
 } fs_in;
 
+#ifdef OPAQUE_PASS
+//! Nothing is discarded, the depth test runs before the shading
+layout(early_fragment_tests) in;
+#endif
+
 layout(location = 0) out vec4 fragColor;
 
 layout(std140, binding = 0) uniform UBOCamera
@@ -45,8 +51,6 @@ layout ( binding = 1 ) uniform sampler2D samplerBRDFLUT;
 layout ( binding = 2 ) uniform samplerCube prefilteredMap;
 layout ( binding = 3 ) uniform sampler2D textures[MAX_TEXTURES];
 
-uniform int materialIdx = 0;
-
 #include tonemapping.glsl
 #include utils.glsl
 #include pbr.glsl
@@ -86,7 +90,7 @@ void main()
 	float perceptualRoughness;
 	float metallic;
 
-	GltfShadeMaterial material = materials[materialIdx];
+	GltfShadeMaterial material = materials[fs_in.materialIdx];
 
 	if (material.shadingModel == PBR_METALLIC_ROUGHNESS_MODEL)
 	{
@@ -139,8 +143,11 @@ void main()
 	diffuseColor = baseColor.rgb * (vec3(1.0) - f0) * (1.0 - metallic);
 	specularColor = mix(f0, baseColor.rgb, metallic);
 
-	if (material.alphaMode > 0 && baseColor.a < material.alphaCutoff)
+#ifndef OPAQUE_PASS
+	//! Only the masked materials are alpha tested, the blended ones keep their coverage in the alpha
+	if (material.alphaMode == 1 && baseColor.a < material.alphaCutoff)
 		discard;
+#endif
 
 	//! Roughness is authored as perceptual roughness; as is convention
 	//! convert to material roughness by squaring the perceptual roughness [2].
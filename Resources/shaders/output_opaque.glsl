@@ -0,0 +1,5 @@
+#version 450 core
+
+//! Output of the opaque pass, the alpha test is compiled out for the early depth test
+#define OPAQUE_PASS
+#include output.glsl
\ No newline at end of file
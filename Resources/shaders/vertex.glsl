@@ -1,9 +1,14 @@
 #version 450 core
+#extension GL_ARB_shader_draw_parameters : enable
 
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
 layout(location = 2) in vec4 color;
 layout(location = 3) in vec2 texCoord;
+layout(location = 5) in uvec4 joints;
+layout(location = 6) in vec4 weights;
+// Base instance of the indirect draw through the instanced attribute, without the draw parameters
+layout(location = 7) in int drawIndex;
 
 layout(std140, binding = 0) uniform UBOCamera
 {
@@ -24,21 +29,141 @@ layout(std430, binding = 2) readonly buffer UBOinstance
 	InstanceMat matrices[];
 };
 
+// Joint palettes of every skin in the world space
+layout(std430, binding = 4) readonly buffer UBOJoint
+{
+	mat4 jointMatrices[];
+};
+
+#include gltf.glsl
+// Packed deltas of every morph target, static
+layout(std430, binding = 5) readonly buffer UBOMorphDelta
+{
+	GltfMorphDelta morphDeltas[];
+};
+
+// Targets with a non-zero weight of every drawn primitive, rebuilt when the weights change
+layout(std430, binding = 6) readonly buffer UBOMorphTarget
+{
+	GltfMorphTarget morphTargets[];
+};
+
+// Inputs of every draw of the multi-draw indirect
+layout(std430, binding = 7) readonly buffer UBODraw
+{
+	GltfDrawRecord drawRecords[];
+};
+
 layout(location = 0) out VSOUT
 {
 	vec3 worldPos;
 	vec3 normal;
 	vec4 color;
 	vec2 texCoord;
+	flat int materialIdx;
 } vs_out;
 
+// The uniforms below are replaced by the draw record of the indirect draws
+uniform bool indirectDraws = false;
 uniform int instanceIdx = 0;
+uniform int materialIdx = 0;
+// First palette entry of the skin of the node, -1 if the node is not skinned
+uniform int jointOffset = -1;
+// Range of the morph targets of the primitive in morphTargets, only the non-zero weights are listed
+uniform int morphOffset = 0;
+uniform int morphCount = 0;
+
+// Compressed attributes : positions quantized into the primitive bounds
+// and octahedral normals, the others are converted by the vertex fetch.
+uniform bool compressedAttributes = false;
+uniform vec3 positionOffset = vec3(0.0);
+uniform vec3 positionScale = vec3(1.0);
+
+vec3 DecodeOctahedral(vec2 encoded)
+{
+	vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
+// Delta of this vertex in the given range, zero if the sparse range does not list the vertex
+vec3 FetchMorphDelta(int base, int count, bool sparse)
+{
+	if (count == 0)
+		return vec3(0.0);
+	if (!sparse)
+		return morphDeltas[base + gl_VertexID].delta;
+
+	// Vertices out of the touched region are rejected before the binary search
+	uint vertex = uint(gl_VertexID);
+	int lower = base, upper = base + count - 1;
+	if (vertex < morphDeltas[lower].vertex || vertex > morphDeltas[upper].vertex)
+		return vec3(0.0);
+	while (lower < upper)
+	{
+		int middle = (lower + upper) >> 1;
+		if (morphDeltas[middle].vertex < vertex)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+	return morphDeltas[lower].vertex == vertex ? morphDeltas[lower].delta : vec3(0.0);
+}
 
 void main()
 {
-	vec4 worldPos = matrices[instanceIdx].model * vec4(position, 1.0);
+	int nodeMatrix = instanceIdx, firstJoint = jointOffset, firstMorph = morphOffset, numMorphs = morphCount;
+	vec3 boundOffset = positionOffset, boundScale = positionScale;
+	vs_out.materialIdx = materialIdx;
+	if (indirectDraws)
+	{
+#ifdef GL_ARB_shader_draw_parameters
+		GltfDrawRecord draw = drawRecords[gl_BaseInstanceARB];
+#else
+		GltfDrawRecord draw = drawRecords[drawIndex];
+#endif
+		nodeMatrix	= draw.instanceIdx;
+		firstJoint	= draw.jointOffset;
+		firstMorph	= draw.morphOffset;
+		numMorphs	= draw.morphCount;
+		boundOffset = draw.positionOffset.xyz;
+		boundScale	= draw.positionScale.xyz;
+		vs_out.materialIdx = draw.materialIdx;
+	}
+
+	vec3 localPos	 = compressedAttributes ? boundOffset + position * boundScale : position;
+	vec3 localNormal = compressedAttributes ? DecodeOctahedral(normal.xy) : normal;
+
+	// Morph targets are blended before the skinning
+	if (numMorphs > 0)
+	{
+		for (int i = firstMorph; i < firstMorph + numMorphs; ++i)
+		{
+			GltfMorphTarget target = morphTargets[i];
+			localPos	+= target.weight * FetchMorphDelta(target.positionBase, target.positionCount, (target.sparseMask & 1) != 0);
+			localNormal += target.weight * FetchMorphDelta(target.normalBase, target.normalCount, (target.sparseMask & 2) != 0);
+		}
+		localNormal = normalize(localNormal);
+	}
+
+	vec4 worldPos;
+	if (firstJoint >= 0)
+	{
+		mat4 skinMatrix = weights.x * jointMatrices[firstJoint + int(joints.x)] +
+						  weights.y * jointMatrices[firstJoint + int(joints.y)] +
+						  weights.z * jointMatrices[firstJoint + int(joints.z)] +
+						  weights.w * jointMatrices[firstJoint + int(joints.w)];
+		worldPos = skinMatrix * vec4(localPos, 1.0);
+		vs_out.normal = normalize(mat3(skinMatrix) * localNormal);
+	}
+	else
+	{
+		worldPos = matrices[nodeMatrix].model * vec4(localPos, 1.0);
+		vs_out.normal = (matrices[nodeMatrix].modelIT * vec4(localNormal, 1.0)).xyz;
+	}
 	vs_out.worldPos = worldPos.xyz;
-	vs_out.normal	= (matrices[instanceIdx].modelIT * vec4(normal, 1.0)).xyz;
 	vs_out.color	= color;
 	vs_out.texCoord = texCoord;
 
@@ -0,0 +1,358 @@
+#include <Core/AnimationTrack.hpp>
+#include <Core/Macros.hpp>
+#include <Core/MathUtils.hpp>
+#include <Core/Quantization.hpp>
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <cmath>
+
+#if defined(SIMD_SSE2)
+#include <emmintrin.h>
+#endif
+
+namespace Core {
+
+	namespace
+	{
+		//! Same threshold as Interpolation::SLerp, closer quaternions are interpolated linearly
+		constexpr float kSLerpThreshold = 0.9995f;
+		//! Keys of the padding lanes
+		const glm::vec4 kPaddingKey(0.0f, 0.0f, 0.0f, 1.0f);
+		const glm::vec4 kPaddingTangent(0.0f, 0.0f, 0.0f, 0.0f);
+
+#if defined(SIMD_SSE2)
+		inline __m128 DotLanes(const __m128* lhs, const __m128* rhs)
+		{
+			return _mm_add_ps(_mm_add_ps(_mm_mul_ps(lhs[0], rhs[0]), _mm_mul_ps(lhs[1], rhs[1])),
+							  _mm_add_ps(_mm_mul_ps(lhs[2], rhs[2]), _mm_mul_ps(lhs[3], rhs[3])));
+		}
+
+		inline __m128 SelectLanes(__m128 mask, __m128 lhs, __m128 rhs)
+		{
+			return _mm_or_ps(_mm_and_ps(mask, lhs), _mm_andnot_ps(mask, rhs));
+		}
+
+		//! Sine of [0, pi/2] with the Taylor series up to x^11, within 6e-8
+		inline __m128 SinLanes(__m128 x)
+		{
+			const __m128 x2 = _mm_mul_ps(x, x);
+			__m128 polynomial = _mm_set1_ps(-2.5052108e-8f);
+			polynomial = _mm_add_ps(_mm_mul_ps(polynomial, x2), _mm_set1_ps(2.7557319e-6f));
+			polynomial = _mm_add_ps(_mm_mul_ps(polynomial, x2), _mm_set1_ps(-1.9841270e-4f));
+			polynomial = _mm_add_ps(_mm_mul_ps(polynomial, x2), _mm_set1_ps(8.3333333e-3f));
+			polynomial = _mm_add_ps(_mm_mul_ps(polynomial, x2), _mm_set1_ps(-1.6666667e-1f));
+			return _mm_add_ps(x, _mm_mul_ps(_mm_mul_ps(x, x2), polynomial));
+		}
+
+		//! Arc cosine of [0, 1] within 2e-8 radians (Abramowitz and Stegun 4.4.46)
+		inline __m128 ArcCosLanes(__m128 x)
+		{
+			__m128 polynomial = _mm_set1_ps(-0.0012624911f);
+			polynomial = _mm_add_ps(_mm_mul_ps(polynomial, x), _mm_set1_ps(0.0066700901f));
+			polynomial = _mm_add_ps(_mm_mul_ps(polynomial, x), _mm_set1_ps(-0.0170881256f));
+			polynomial = _mm_add_ps(_mm_mul_ps(polynomial, x), _mm_set1_ps(0.0308918810f));
+			polynomial = _mm_add_ps(_mm_mul_ps(polynomial, x), _mm_set1_ps(-0.0501743046f));
+			polynomial = _mm_add_ps(_mm_mul_ps(polynomial, x), _mm_set1_ps(0.0889789874f));
+			polynomial = _mm_add_ps(_mm_mul_ps(polynomial, x), _mm_set1_ps(-0.2145988016f));
+			polynomial = _mm_add_ps(_mm_mul_ps(polynomial, x), _mm_set1_ps(1.5707963050f));
+			const __m128 oneMinusX = _mm_max_ps(_mm_sub_ps(_mm_set1_ps(1.0f), x), _mm_setzero_ps());
+			return _mm_mul_ps(_mm_sqrt_ps(oneMinusX), polynomial);
+		}
+
+		//! result = (1 - t) * prev + t * next for each component
+		inline void LerpLanes(__m128* result, const __m128* prev, const __m128* next, __m128 prevWeight, __m128 nextWeight)
+		{
+			for (int c = 0; c < 4; ++c)
+				result[c] = _mm_add_ps(_mm_mul_ps(prevWeight, prev[c]), _mm_mul_ps(nextWeight, next[c]));
+		}
+
+		//! Hermite spline of the values and the tangents scaled by the intervals for each component
+		inline void CubicLanes(__m128* result, const __m128* prev, const __m128* prevTangent, const __m128* nextTangent, const __m128* next,
+							   __m128 weight, __m128 interval)
+		{
+			const __m128 t2 = _mm_mul_ps(weight, weight);
+			const __m128 t3 = _mm_mul_ps(t2, weight);
+			const __m128 two = _mm_set1_ps(2.0f), three = _mm_set1_ps(3.0f);
+			//! h01 = 3t^2 - 2t^3, h00 = 1 - h01, h10 = t^3 - 2t^2 + t, h11 = t^3 - t^2
+			const __m128 nextWeight = _mm_sub_ps(_mm_mul_ps(three, t2), _mm_mul_ps(two, t3));
+			const __m128 prevWeight = _mm_sub_ps(_mm_set1_ps(1.0f), nextWeight);
+			const __m128 prevTangentWeight = _mm_mul_ps(_mm_add_ps(_mm_sub_ps(t3, _mm_mul_ps(two, t2)), weight), interval);
+			const __m128 nextTangentWeight = _mm_mul_ps(_mm_sub_ps(t3, t2), interval);
+			for (int c = 0; c < 4; ++c)
+				result[c] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(prevWeight, prev[c]), _mm_mul_ps(prevTangentWeight, prevTangent[c])),
+									   _mm_add_ps(_mm_mul_ps(nextWeight, next[c]), _mm_mul_ps(nextTangentWeight, nextTangent[c])));
+		}
+
+		inline void NormalizeLanes(__m128* value)
+		{
+			const __m128 length = _mm_sqrt_ps(DotLanes(value, value));
+			for (int c = 0; c < 4; ++c)
+				value[c] = _mm_div_ps(value[c], length);
+		}
+
+		//! Flip the next quaternions onto the hemisphere of the previous ones, returns the absolute dot products
+		inline __m128 AlignHemisphereLanes(const __m128* prev, __m128* next)
+		{
+			const __m128 signMask = _mm_set1_ps(-0.0f);
+			const __m128 dotProduct = DotLanes(prev, next);
+			const __m128 sign = _mm_and_ps(dotProduct, signMask);
+			for (int c = 0; c < 4; ++c)
+				next[c] = _mm_xor_ps(next[c], sign);
+			return _mm_andnot_ps(signMask, dotProduct);
+		}
+#endif
+	};
+
+	AnimationTrack::AnimationTrack(Kernel kernel)
+		: _kernel(kernel)
+	{
+		//! Do nothing
+	}
+
+	AnimationTrack::~AnimationTrack()
+	{
+		//! Do nothing
+	}
+
+	std::size_t AnimationTrack::AddLane(const float* times, const glm::vec4* values, std::size_t numKeys)
+	{
+		const std::size_t lane = _times.size();
+		_times.push_back(times);
+		_sampleRates.push_back(0.0f);
+		_values.push_back(values);
+		_packedKeys.push_back(PackedKeys());
+		_numKeys.push_back(numKeys);
+		_cursors.push_back(0);
+
+		const std::size_t numPaddedLanes = (_times.size() + kLaneWidth - 1) / kLaneWidth * kLaneWidth;
+		_prevKeys.resize(numPaddedLanes, &kPaddingKey);
+		_nextKeys.resize(numPaddedLanes, &kPaddingKey);
+		_weights.resize(numPaddedLanes, 0.0f);
+		_prevTangents.resize(numPaddedLanes, &kPaddingTangent);
+		_nextTangents.resize(numPaddedLanes, &kPaddingTangent);
+		_intervals.resize(numPaddedLanes, 0.0f);
+		_results.resize(numPaddedLanes * 4, 0.0f);
+		_decodedKeys.resize(_times.size() * 2);
+		return lane;
+	}
+
+	std::size_t AnimationTrack::AddLane(float sampleRate, const glm::vec4* values, std::size_t numKeys)
+	{
+		const std::size_t lane = AddLane(nullptr, values, numKeys);
+		_sampleRates[lane] = sampleRate;
+		return lane;
+	}
+
+	std::size_t AnimationTrack::AddLane(float sampleRate, const PackedKeys& keys, std::size_t numKeys)
+	{
+		const std::size_t lane = AddLane(sampleRate, nullptr, numKeys);
+		_packedKeys[lane] = keys;
+		return lane;
+	}
+
+	glm::vec4 AnimationTrack::DecodeKey(const PackedKeys& keys, std::size_t index)
+	{
+		const glm::u16vec3& key = keys.keys[index];
+		if (keys.encoding == KeyEncoding::Quaternion48)
+			return DecodeSmallestThree(key);
+		return glm::vec4(keys.offset + keys.scale * glm::vec3(key), 0.0f);
+	}
+
+	void AnimationTrack::Evaluate(float time, const unsigned char* activeLanes)
+	{
+		//! Keys out of the curve range are clamped to the first or the last one
+		const std::size_t numLanes = _times.size();
+		const bool isCubic = _kernel == Kernel::Cubic || _kernel == Kernel::NCubic;
+		for (std::size_t lane = 0; lane < numLanes; ++lane)
+		{
+			if (activeLanes != nullptr && !activeLanes[lane])
+				continue;
+
+			const float* times = _times[lane];
+			const std::size_t numKeys = _numKeys[lane];
+			std::size_t i, next;
+			float interval;
+			if (times == nullptr)
+			{
+				//! Fixed rate keys are found by the index
+				const float position = std::max(time * _sampleRates[lane], 0.0f);
+				i = std::min(static_cast<std::size_t>(position), numKeys - 1);
+				next = std::min(i + 1, numKeys - 1);
+				interval = 1.0f / _sampleRates[lane];
+				_weights[lane] = next > i ? std::min(position - static_cast<float>(i), 1.0f) : 0.0f;
+			}
+			else
+			{
+				i = FindKeyframe(times, numKeys, time, _cursors[lane]);
+				next = std::min(i + 1, numKeys - 1);
+				interval = times[next] - times[i];
+				_weights[lane] = interval > 0.0f ? std::min(std::max((time - times[i]) / interval, 0.0f), 1.0f) : 0.0f;
+				_cursors[lane] = i;
+			}
+
+			if (isCubic)
+			{
+				//! The value of key i is the middle of its triplet
+				const glm::vec4* values = _values[lane];
+				_prevKeys[lane] = values + i * 3 + 1;
+				_prevTangents[lane] = values + i * 3 + 2;
+				_nextTangents[lane] = values + next * 3;
+				_nextKeys[lane] = values + next * 3 + 1;
+				_intervals[lane] = interval;
+			}
+			else if (_values[lane] == nullptr)
+			{
+				_decodedKeys[lane * 2] = DecodeKey(_packedKeys[lane], i);
+				_decodedKeys[lane * 2 + 1] = DecodeKey(_packedKeys[lane], next);
+				_prevKeys[lane] = &_decodedKeys[lane * 2];
+				_nextKeys[lane] = &_decodedKeys[lane * 2 + 1];
+			}
+			else
+			{
+				_prevKeys[lane] = _values[lane] + i;
+				_nextKeys[lane] = _values[lane] + next;
+			}
+		}
+
+		const std::size_t numPaddedLanes = _prevKeys.size();
+#if defined(SIMD_SSE2)
+		const __m128 one = _mm_set1_ps(1.0f);
+		for (std::size_t lane = 0; lane < numPaddedLanes; lane += kLaneWidth)
+		{
+			if (activeLanes != nullptr)
+			{
+				bool isActive = false;
+				for (std::size_t k = lane; k < std::min(lane + kLaneWidth, numLanes); ++k)
+					isActive |= activeLanes[k] != 0;
+				if (!isActive)
+					continue;
+			}
+
+			//! Four keys of vec4 become four vectors of x, y, z and w lanes
+			__m128 prev[4], next[4], result[4];
+			for (std::size_t k = 0; k < kLaneWidth; ++k)
+			{
+				prev[k] = _mm_loadu_ps(&_prevKeys[lane + k]->x);
+				next[k] = _mm_loadu_ps(&_nextKeys[lane + k]->x);
+			}
+			_MM_TRANSPOSE4_PS(prev[0], prev[1], prev[2], prev[3]);
+			_MM_TRANSPOSE4_PS(next[0], next[1], next[2], next[3]);
+			const __m128 weight = _mm_loadu_ps(&_weights[lane]);
+			const __m128 prevWeight = _mm_sub_ps(one, weight);
+
+			switch (_kernel)
+			{
+			case Kernel::Lerp:
+				LerpLanes(result, prev, next, prevWeight, weight);
+				break;
+			case Kernel::NLerp:
+				AlignHemisphereLanes(prev, next);
+				LerpLanes(result, prev, next, prevWeight, weight);
+				NormalizeLanes(result);
+				break;
+			case Kernel::SLerp:
+			{
+				//! sin((1 - t) * theta) / sin(theta) and sin(t * theta) / sin(theta), the angle is at most pi / 2
+				const __m128 dotProduct = AlignHemisphereLanes(prev, next);
+				const __m128 theta = ArcCosLanes(dotProduct);
+				const __m128 sinTheta = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(one, _mm_mul_ps(dotProduct, dotProduct)), _mm_setzero_ps()));
+				const __m128 sphericalPrev = _mm_div_ps(SinLanes(_mm_mul_ps(prevWeight, theta)), sinTheta);
+				const __m128 sphericalNext = _mm_div_ps(SinLanes(_mm_mul_ps(weight, theta)), sinTheta);
+				//! The lanes of the close quaternions fall back to NLerp, discarding the division by zero
+				const __m128 isClose = _mm_cmpgt_ps(dotProduct, _mm_set1_ps(kSLerpThreshold));
+				LerpLanes(result, prev, next, SelectLanes(isClose, prevWeight, sphericalPrev), SelectLanes(isClose, weight, sphericalNext));
+				NormalizeLanes(result);
+				break;
+			}
+			case Kernel::Step:
+			{
+				const __m128 isNext = _mm_cmpge_ps(weight, one);
+				for (int c = 0; c < 4; ++c)
+					result[c] = SelectLanes(isNext, next[c], prev[c]);
+				break;
+			}
+			case Kernel::Cubic:
+			case Kernel::NCubic:
+			{
+				__m128 prevTangent[4], nextTangent[4];
+				for (std::size_t k = 0; k < kLaneWidth; ++k)
+				{
+					prevTangent[k] = _mm_loadu_ps(&_prevTangents[lane + k]->x);
+					nextTangent[k] = _mm_loadu_ps(&_nextTangents[lane + k]->x);
+				}
+				_MM_TRANSPOSE4_PS(prevTangent[0], prevTangent[1], prevTangent[2], prevTangent[3]);
+				_MM_TRANSPOSE4_PS(nextTangent[0], nextTangent[1], nextTangent[2], nextTangent[3]);
+				CubicLanes(result, prev, prevTangent, nextTangent, next, weight, _mm_loadu_ps(&_intervals[lane]));
+				if (_kernel == Kernel::NCubic)
+					NormalizeLanes(result);
+				break;
+			}
+			}
+
+			for (int c = 0; c < 4; ++c)
+				_mm_storeu_ps(&_results[c * numPaddedLanes + lane], result[c]);
+		}
+#else
+		for (std::size_t lane = 0; lane < numLanes; ++lane)
+		{
+			if (activeLanes != nullptr && !activeLanes[lane])
+				continue;
+
+			const glm::vec4& prev = *_prevKeys[lane];
+			glm::vec4 next = *_nextKeys[lane];
+			const float weight = _weights[lane];
+
+			glm::vec4 result;
+			switch (_kernel)
+			{
+			case Kernel::Lerp:
+				result = Interpolation::Lerp(prev, next, weight);
+				break;
+			case Kernel::NLerp:
+			case Kernel::SLerp:
+			{
+				float dotProduct = glm::dot(prev, next);
+				if (dotProduct < 0.0f)
+				{
+					next = -next;
+					dotProduct = -dotProduct;
+				}
+				if (_kernel == Kernel::NLerp || dotProduct > kSLerpThreshold)
+				{
+					result = glm::normalize(Interpolation::Lerp(prev, next, weight));
+				}
+				else
+				{
+					const float theta = std::acos(dotProduct);
+					const float sinTheta = std::sqrt(1.0f - dotProduct * dotProduct);
+					result = glm::normalize(prev * (std::sin((1.0f - weight) * theta) / sinTheta) + next * (std::sin(weight * theta) / sinTheta));
+				}
+				break;
+			}
+			case Kernel::Step:
+				result = Interpolation::Step(prev, next, weight);
+				break;
+			case Kernel::Cubic:
+			case Kernel::NCubic:
+				result = Interpolation::CubicSpline(prev, *_prevTangents[lane], *_nextTangents[lane], next, weight, _intervals[lane]);
+				if (_kernel == Kernel::NCubic)
+					result = glm::normalize(result);
+				break;
+			}
+
+			for (int c = 0; c < 4; ++c)
+				_results[c * numPaddedLanes + lane] = result[c];
+		}
+#endif
+	}
+
+	bool AnimationTrack::IsNLerpExact(const glm::vec4* values, std::size_t numKeys)
+	{
+		for (std::size_t i = 0; i + 1 < numKeys; ++i)
+		{
+			if (std::fabs(glm::dot(values[i], values[i + 1])) <= kSLerpThreshold)
+				return false;
+		}
+		return true;
+	}
+};
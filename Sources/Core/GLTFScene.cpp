@@ -1,8 +1,21 @@
 #include <Core/GLTFScene.hpp>
 #include <Core/MathUtils.hpp>
+#include <Core/ThreadPool.hpp>
+#include <Core/Quantization.hpp>
+#include <Core/MeshOptimizer.hpp>
+#include <Core/TangentGenerator.hpp>
+#include <Core/Skinning.hpp>
+#include <Core/Macros.hpp>
 #include <glm/gtx/quaternion.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/packing.hpp>
 #include <unordered_set>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <limits>
 #include <iostream>
 #include <cassert>
 
@@ -25,6 +38,10 @@
 
 #include <tinygltf/tiny_gltf.h>
 
+#if defined(SIMD_SSE2)
+#include <xmmintrin.h>
+#endif
+
 namespace Core {
 
 	bool GLTFExtension::CheckRequiredExtensions(const tinygltf::Model& model)
@@ -65,18 +82,70 @@ namespace Core {
 		//! Do nothing
 	}
 
-	bool GLTFScene::Initialize(const std::string& filename, VertexFormat format, ImageCallback imageCallback)
+	namespace
+	{
+		//! Collect the scene file and the external buffers & images relative to the scene directory
+		std::vector<std::string> CollectDependencies(const tinygltf::Model& model, const std::string& filename)
+		{
+			const std::string baseDir = tinygltf::GetBaseDir(filename);
+			std::vector<std::string> dependencies;
+			dependencies.push_back(baseDir.empty() ? filename : filename.substr(baseDir.size() + 1));
+
+			auto addURI = [&dependencies](const std::string& uri) {
+				if (!uri.empty() && !tinygltf::IsDataURI(uri))
+					dependencies.push_back(tinygltf::dlib::urldecode(uri));
+			};
+			for (const auto& buffer : model.buffers)
+				addURI(buffer.uri);
+			for (const auto& image : model.images)
+				addURI(image.uri);
+
+			return dependencies;
+		}
+
+		//! Reserve the deltas of the morph target attribute, the sparse accessors without the base values keep their count
+		void ReserveMorphRange(const tinygltf::Model& model, const std::map<std::string, int>& target, const std::string& name,
+							   unsigned int vertexCount, int* numDeltas, int* offset, int* count, int* sparse)
+		{
+			auto iter = target.find(name);
+			if (iter == target.end())
+				return;
+
+			const auto& accessor = model.accessors[iter->second];
+			*sparse = accessor.sparse.isSparse && accessor.bufferView < 0;
+			*count = *sparse ? std::min(accessor.sparse.count, static_cast<int>(vertexCount)) : static_cast<int>(vertexCount);
+			*offset = *numDeltas;
+			*numDeltas += *count;
+		}
+	};
+
+	bool GLTFScene::Initialize(const std::string& filename, VertexFormat format, const GLTFLoadOptions& options, ImageCallback imageCallback)
 	{
 		assert(static_cast<int>(format & Core::VertexFormat::Position3) && "Scene model must contain Position attribute");
 
+		//! Skip parsing entirely while the cache is up to date
+		if (options.sceneCache && LoadSceneCache(filename, format, options, imageCallback))
+		{
+			if (options.compressAttributes)
+				CompressVertexAttributes(format);
+			BakeAnimations(options);
+			BuildAnimationTracks();
+			UpdateJointPalettes();
+			return true;
+		}
+
 		tinygltf::Model model;
-		if (!LoadModel(&model, filename))
+		if (!LoadModel(&model, filename, options))
 			return false;
 
 		if (!GLTFExtension::CheckRequiredExtensions(model))
 			return false;
 
+		//! Counting pass : reserve exact vertex & index range for each primitive
+		//! so that primitives can be converted independently.
+		std::vector<const tinygltf::Primitive*> primitives;
 		unsigned int numVertices{ 0 }, numIndices{ 0 }, primCount{ 0 }, meshCount{ 0 };
+		int numMorphDeltas{ 0 };
 		for (const auto& mesh : model.meshes)
 		{
 			std::vector<unsigned int> vPrim;
@@ -85,49 +154,115 @@ namespace Core {
 				if (prim.mode != TINYGLTF_MODE_TRIANGLES)
 					continue;
 
+				GLTFPrimMesh primMesh;
+				primMesh.name = mesh.name;
+				primMesh.materialIndex = prim.material < 0 ? 0 : prim.material;
+				primMesh.vertexOffset = numVertices;
+				primMesh.firstIndex = numIndices;
+
+				//! Keeping the size of this primitive (spec says this is required information)
 				const auto& posAccessor = model.accessors[prim.attributes.find("POSITION")->second];
-				numVertices += posAccessor.count;
+				primMesh.vertexCount = static_cast<unsigned int>(posAccessor.count);
+				if (posAccessor.minValues.empty() == false)
+					primMesh.min = glm::vec3(posAccessor.minValues[0], posAccessor.minValues[1], posAccessor.minValues[2]);
+				if (posAccessor.maxValues.empty() == false)
+					primMesh.max = glm::vec3(posAccessor.maxValues[0], posAccessor.maxValues[1], posAccessor.maxValues[2]);
+
 				if (prim.indices > -1)
-				{
-					const auto& indexAccessor = model.accessors[prim.indices];
-					numIndices += indexAccessor.count;
-				}
+					primMesh.indexCount = static_cast<unsigned int>(model.accessors[prim.indices].count);
 				else
+					primMesh.indexCount = primMesh.vertexCount;
+
+				//! Morph targets are reserved the same way
+				primMesh.morphTargetIndex = static_cast<int>(_morphTargets.size());
+				primMesh.morphTargetCount = static_cast<int>(prim.targets.size());
+				for (const auto& target : prim.targets)
 				{
-					numIndices += posAccessor.count;
+					GLTFMorphTarget morphTarget;
+					auto reserve = [&](GLTFMorphRange& range, const std::string& name) {
+						ReserveMorphRange(model, target, name, primMesh.vertexCount, &numMorphDeltas, &range.offset, &range.count, &range.sparse);
+					};
+					reserve(morphTarget.position, "POSITION");
+					if (static_cast<int>(format & VertexFormat::Normal3))
+						reserve(morphTarget.normal, "NORMAL");
+					if (static_cast<int>(format & VertexFormat::Tangent4))
+						reserve(morphTarget.tangent, "TANGENT");
+					_morphTargets.push_back(morphTarget);
 				}
+
+				numVertices += primMesh.vertexCount;
+				numIndices += primMesh.indexCount;
+				_scenePrimMeshes.emplace_back(std::move(primMesh));
+				primitives.push_back(&prim);
 				vPrim.push_back(primCount++);
 			}
 			_meshToPrimMap[meshCount++] = std::move(vPrim);
 		}
 
-		_positions.reserve(numVertices);
-		_indices.reserve(numIndices);
+		//! Zero-initialized storages, generated normals and tangents are accumulated on them
+		_positions.resize(numVertices);
+		_indices.resize(numIndices);
 		if (static_cast<int>(format & VertexFormat::Normal3))
-			_normals.reserve(numVertices);
+			_normals.resize(numVertices);
 		if (static_cast<int>(format & VertexFormat::Tangent4))
-			_tangents.reserve(numVertices);
+			_tangents.resize(numVertices);
 		if (static_cast<int>(format & VertexFormat::Color4))
-			_colors.reserve(numVertices);
+			_colors.resize(numVertices);
 		if (static_cast<int>(format & VertexFormat::TexCoord2))
-			_texCoords.reserve(numVertices);
+			_texCoords.resize(numVertices);
+		//! Skinning streams regardless of the format, the vertices out of the skinned primitives have zero weights
+		if (!model.skins.empty())
+		{
+			_skinJoints.resize(numVertices);
+			_skinWeights.resize(numVertices);
+		}
+		_morphDeltas.resize(numMorphDeltas);
 
-		//! Convert all mesh/primitves+ to a single primitive per mesh.
-		for (const auto& mesh : model.meshes)
+		//! Attributes which are uploaded to the GPU without dequantization
+		std::vector<std::pair<std::string, GLTFQuantizedStream*>> quantizedStreams;
+		if (options.keepQuantized)
 		{
-			for (const auto& prim : mesh.primitives)
+			const std::pair<VertexFormat, std::pair<std::string, GLTFQuantizedStream*>> candidates[] = {
+				{ VertexFormat::Position3, { "POSITION", &_quantizedPositions } },
+				{ VertexFormat::Normal3, { "NORMAL", &_quantizedNormals } },
+				{ VertexFormat::Tangent4, { "TANGENT", &_quantizedTangents } },
+				{ VertexFormat::Color4, { "COLOR_0", &_quantizedColors } },
+				{ VertexFormat::TexCoord2, { "TEXCOORD_0", &_quantizedTexCoords } },
+			};
+			for (const auto& candidate : candidates)
 			{
-				ProcessMesh(model, prim, format, mesh.name);
+				const auto& stream = candidate.second;
+				if (static_cast<int>(format & candidate.first) && PrepareQuantizedStream(model, primitives, stream.first, numVertices, stream.second))
+					quantizedStreams.push_back(stream);
 			}
 		}
 
+		//! Convert all mesh/primitves+ to a single primitive per mesh.
+		ThreadPool::GetInstance().ParallelFor(primitives.size(), 1, [&](std::size_t begin, std::size_t end) {
+			for (std::size_t i = begin; i < end; ++i)
+			{
+				ProcessMesh(model, *primitives[i], format, _scenePrimMeshes[i]);
+				ProcessMorphTargets(model, *primitives[i], _scenePrimMeshes[i]);
+				for (const auto& stream : quantizedStreams)
+					CopyQuantizedAttributes(model, *primitives[i], stream.first, _scenePrimMeshes[i], stream.second);
+			}
+		});
+
+		if (options.optimizeMeshes)
+			OptimizeMeshes();
+		if (options.generateLods)
+			GenerateLods(options.optimizeMeshes);
+
 		//! Transforming the scene hierarchy to a flat list.
 		int defaultScene = model.defaultScene > -1 ? model.defaultScene : 0;
 		const auto& scene = model.scenes[defaultScene];
+		_nodeRemap.assign(model.nodes.size(), -1);
 		for (auto nodeIdx : scene.nodes)
 		{
 			ProcessNode(model, nodeIdx, -1);
 		}
+		ImportSkins(model);
+		UpdateJointPalettes();
 
 		//! Convert all channels & samplers into each single vectors,
 		//! make animation node point to base & stride of them.
@@ -135,6 +270,8 @@ namespace Core {
 		{
 			ProcessAnimation(model, anim, _sceneChannels.size(), _sceneSamplers.size());
 		}
+		if (options.reduceKeyframes)
+			ReduceKeyframes(options.keyframeErrorBound);
 
 		//! Compute scene dimension
 		CalculateSceneDimension();
@@ -142,59 +279,74 @@ namespace Core {
 
 		//! Clear all temporal resources.
 		_meshToPrimMap.clear();
-		_u8Buffer.clear();
-		_u16Buffer.clear();
-		_u32Buffer.clear();
+		_nodeRemap.clear();
+		_bufferData.clear();
+		_mappedFiles.clear();
 
 		//! Import materials from the model
 		ImportMaterials(model);
 
+		if (options.sceneCache && !SaveSceneCache(filename, format, options, model, CollectDependencies(model, filename)))
+			std::clog << "[GLTFScene::Initialize] Failed to write the scene cache : " << GetSceneCachePath(filename) << std::endl;
+
+		//! Compressed after writing the cache which keeps the float streams
+		if (options.compressAttributes)
+			CompressVertexAttributes(format);
+
+		//! Baked after writing the cache as well, which keeps the source keys
+		BakeAnimations(options);
+		BuildAnimationTracks();
+
 		//! Finally import images from the model
 		if (imageCallback != nullptr)
 		{
 			for (const auto& image : model.images)
-				imageCallback(image);
+				imageCallback({ image.name, image.width, image.height, image.component, image.bits, image.pixel_type, image.image });
 		}
 
 		return true;
 	}
 
-	void GLTFScene::ProcessMesh(const tinygltf::Model& model, const tinygltf::Primitive& mesh, VertexFormat format, const std::string& name)
+	namespace
 	{
-		GLTFPrimMesh resultMesh;
-		resultMesh.name = name;
-		resultMesh.materialIndex = mesh.material < 0 ? 0 : mesh.material;
-		resultMesh.vertexOffset = static_cast<unsigned int>(_positions.size());
-		resultMesh.firstIndex = static_cast<unsigned int>(_indices.size());
+		//! Normalize the weights and round them to 16-bit, the rounding error goes to the largest weight
+		glm::u16vec4 QuantizeWeights(glm::vec4 weights)
+		{
+			weights = glm::max(weights, glm::vec4(0.0f));
+			const float sum = weights.x + weights.y + weights.z + weights.w;
+			if (sum <= 0.0f)
+				return glm::u16vec4(65535, 0, 0, 0);
+
+			glm::u16vec4 quantized(glm::round(weights / sum * 65535.0f));
+			const int error = 65535 - (quantized.x + quantized.y + quantized.z + quantized.w);
+			int largest = 0;
+			for (int k = 1; k < 4; ++k)
+				largest = quantized[k] > quantized[largest] ? k : largest;
+			quantized[largest] = static_cast<glm::u16>(quantized[largest] + error);
+			return quantized;
+		}
+	};
 
-		//! Only triangles supported.
-		if (mesh.mode != TINYGLTF_MODE_TRIANGLES)
-			return;
+	void GLTFScene::ProcessMesh(const tinygltf::Model& model, const tinygltf::Primitive& mesh, VertexFormat format, const GLTFPrimMesh& primMesh)
+	{
+		unsigned int* indices = _indices.data() + primMesh.firstIndex;
 
 		//! Indices
 		if (mesh.indices > -1)
 		{
 			const tinygltf::Accessor& indexAccessor = model.accessors[mesh.indices];
-			const tinygltf::BufferView& bufferView = model.bufferViews[indexAccessor.bufferView];
-			const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
+			const unsigned char* indexData = GetAccessorData(model, indexAccessor);
 
-			resultMesh.indexCount = static_cast<unsigned int>(indexAccessor.count);
 			switch (indexAccessor.componentType)
 			{
 			case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT:
-				_u32Buffer.resize(indexAccessor.count);
-				std::memcpy(&_u32Buffer[0], &buffer.data[indexAccessor.byteOffset + bufferView.byteOffset], indexAccessor.count * sizeof(unsigned int));
-				_indices.insert(_indices.end(), std::make_move_iterator(_u32Buffer.begin()), std::make_move_iterator(_u32Buffer.end()));
+				std::memcpy(indices, indexData, primMesh.indexCount * sizeof(unsigned int));
 				break;
 			case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT:
-				_u16Buffer.resize(indexAccessor.count);
-				std::memcpy(&_u16Buffer[0], &buffer.data[indexAccessor.byteOffset + bufferView.byteOffset], indexAccessor.count * sizeof(unsigned short));
-				_indices.insert(_indices.end(), std::make_move_iterator(_u16Buffer.begin()), std::make_move_iterator(_u16Buffer.end()));
+				WidenIndices(reinterpret_cast<const unsigned short*>(indexData), indices, primMesh.indexCount);
 				break;
 			case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE:
-				_u8Buffer.resize(indexAccessor.count);
-				std::memcpy(&_u8Buffer[0], &buffer.data[indexAccessor.byteOffset + bufferView.byteOffset], indexAccessor.count * sizeof(unsigned char));
-				_indices.insert(_indices.end(), std::make_move_iterator(_u8Buffer.begin()), std::make_move_iterator(_u8Buffer.end()));
+				WidenIndices(indexData, indices, primMesh.indexCount);
 				break;
 			default:
 				std::cerr << "Unknown index component type : " << indexAccessor.componentType << " is not supported" << std::endl;
@@ -204,60 +356,49 @@ namespace Core {
 		else
 		{
 			//! Primitive without indices, creating them
-			const auto& accessor = model.accessors[mesh.attributes.find("POSITION")->second];
-			for (unsigned int i = 0; i < accessor.count; ++i)
-				_indices.push_back(i);
-			resultMesh.indexCount = static_cast<unsigned int>(accessor.count);
+			for (unsigned int i = 0; i < primMesh.indexCount; ++i)
+				indices[i] = i;
 		}
 
 		//! POSITION
-		{
-			[[maybe_unused]] bool result = GetAttributes<glm::vec3>(model, mesh, _positions, "POSITION");
-
-			//! Keeping the size of this primitive (spec says this is required information)
-			const auto& accessor = model.accessors[mesh.attributes.find("POSITION")->second];
-			resultMesh.vertexCount = static_cast<unsigned int>(accessor.count);
-			if (accessor.minValues.empty() == false)
-				resultMesh.min = glm::vec3(accessor.minValues[0], accessor.minValues[1], accessor.minValues[2]);
-			if (accessor.maxValues.empty() == false)
-				resultMesh.max = glm::vec3(accessor.maxValues[0], accessor.maxValues[1], accessor.maxValues[2]);
-		}
+		glm::vec3* positions = _positions.data() + primMesh.vertexOffset;
+		[[maybe_unused]] bool result = GetAttributes<glm::vec3>(model, mesh, positions, primMesh.vertexCount, "POSITION");
 
 		//! NORMAL
 		if (static_cast<int>(format & VertexFormat::Normal3))
 		{
-			if (!GetAttributes<glm::vec3>(model, mesh, _normals, "NORMAL"))
+			glm::vec3* normals = _normals.data() + primMesh.vertexOffset;
+			if (!GetAttributes<glm::vec3>(model, mesh, normals, primMesh.vertexCount, "NORMAL"))
 			{
 				//! You need to compute the normals
-				std::vector<glm::vec3> meshNormals(resultMesh.vertexCount, glm::vec3(0.0f));
-				for (size_t i = 0; i < resultMesh.indexCount; i += 3)
-				{
-					unsigned int idx0 = _indices[resultMesh.firstIndex + i + 0];
-					unsigned int idx1 = _indices[resultMesh.firstIndex + i + 1];
-					unsigned int idx2 = _indices[resultMesh.firstIndex + i + 2];
-					const auto& pos0 = _positions[resultMesh.vertexOffset + idx0];
-					const auto& pos1 = _positions[resultMesh.vertexOffset + idx1];
-					const auto& pos2 = _positions[resultMesh.vertexOffset + idx2];
+				for (size_t i = 0; i < primMesh.indexCount; i += 3)
+				{
+					unsigned int idx0 = indices[i + 0];
+					unsigned int idx1 = indices[i + 1];
+					unsigned int idx2 = indices[i + 2];
+					const auto& pos0 = positions[idx0];
+					const auto& pos1 = positions[idx1];
+					const auto& pos2 = positions[idx2];
 					const auto edge0 = glm::normalize(pos1 - pos0);
 					const auto edge1 = glm::normalize(pos2 - pos0);
 					const auto n = glm::normalize(glm::cross(edge0, edge1));
-					meshNormals[idx0] += n;
-					meshNormals[idx1] += n;
-					meshNormals[idx2] += n;
+					normals[idx0] += n;
+					normals[idx1] += n;
+					normals[idx2] += n;
 				}
-				_normals.insert(_normals.end(), std::make_move_iterator(meshNormals.begin()), std::make_move_iterator(meshNormals.end()));
 			}
 		}
 
 		//! TEXCOORD2
 		if (static_cast<int>(format & VertexFormat::TexCoord2))
 		{
-			if (!GetAttributes<glm::vec2>(model, mesh, _texCoords, "TEXCOORD_0"))
+			glm::vec2* texCoords = _texCoords.data() + primMesh.vertexOffset;
+			if (!GetAttributes<glm::vec2>(model, mesh, texCoords, primMesh.vertexCount, "TEXCOORD_0"))
 			{
 				//! CubeMap projection
-				for (unsigned int i = 0; i < resultMesh.vertexCount; ++i)
+				for (unsigned int i = 0; i < primMesh.vertexCount; ++i)
 				{
-					const auto& pos = _positions[resultMesh.vertexOffset + i];
+					const auto& pos = positions[i];
 					float absX = std::fabs(pos.x);
 					float absY = std::fabs(pos.y);
 					float absZ = std::fabs(pos.z);
@@ -326,7 +467,7 @@ namespace Core {
 					float u = (uc / mapAxis + 1.0f) * 0.5f;
 					float v = (vc / mapAxis + 1.0f) * 0.5f;
 
-					_texCoords.push_back(glm::vec2(u, v));
+					texCoords[i] = glm::vec2(u, v);
 				}
 			}
 		}
@@ -334,267 +475,1731 @@ namespace Core {
 		//! TANGENT
 		if (static_cast<int>(format & VertexFormat::Tangent4))
 		{
-			if (!GetAttributes(model, mesh, _tangents, "TANGENT"))
+			glm::vec4* tangents = _tangents.data() + primMesh.vertexOffset;
+			if (!GetAttributes(model, mesh, tangents, primMesh.vertexCount, "TANGENT"))
+			{
+				//! Generated in the MikkTSpace convention which the normal maps are usually baked with
+				if (_normals.empty() || _texCoords.empty())
+					std::fill(tangents, tangents + primMesh.vertexCount, glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
+				else
+					GenerateTangents(tangents, indices, primMesh.indexCount, positions, _normals.data() + primMesh.vertexOffset,
+									 _texCoords.data() + primMesh.vertexOffset, primMesh.vertexCount);
+			}
+		}
+
+		//! COLOR
+		if (static_cast<int>(format & VertexFormat::Color4))
+		{
+			glm::vec4* colors = _colors.data() + primMesh.vertexOffset;
+			if (!GetAttributes(model, mesh, colors, primMesh.vertexCount, "COLOR_0"))
+			{
+				std::fill(colors, colors + primMesh.vertexCount, glm::vec4(1.0f));
+			}
+		}
+
+		//! JOINTS & WEIGHTS
+		if (!_skinJoints.empty())
+		{
+			//! Dequantized joints then weights, kept by the thread for its next primitives instead of allocated per primitive
+			thread_local std::vector<glm::vec4> skinScratch;
+			//! Zeroed like fresh vectors, the accessors shorter than the primitive leave the rest unused
+			skinScratch.assign(primMesh.vertexCount * 2, glm::vec4(0.0f));
+			const glm::vec4* joints = skinScratch.data();
+			const glm::vec4* weights = skinScratch.data() + primMesh.vertexCount;
+			if (GetAttributes(model, mesh, skinScratch.data(), primMesh.vertexCount, "JOINTS_0") &&
+				GetAttributes(model, mesh, skinScratch.data() + primMesh.vertexCount, primMesh.vertexCount, "WEIGHTS_0"))
+			{
+				for (unsigned int i = 0; i < primMesh.vertexCount; ++i)
+				{
+					_skinJoints[primMesh.vertexOffset + i] = glm::u16vec4(joints[i]);
+					_skinWeights[primMesh.vertexOffset + i] = QuantizeWeights(weights[i]);
+				}
+			}
+		}
+	}
+
+	void GLTFScene::ProcessMorphTargets(const tinygltf::Model& model, const tinygltf::Primitive& mesh, const GLTFPrimMesh& primMesh)
+	{
+		auto getBufferViewData = [&](int bufferViewIndex, std::size_t byteOffset) {
+			const tinygltf::BufferView& bufferView = model.bufferViews[bufferViewIndex];
+			return _bufferData[bufferView.buffer] + bufferView.byteOffset + byteOffset;
+		};
+
+		for (int t = 0; t < primMesh.morphTargetCount; ++t)
+		{
+			const auto& target = mesh.targets[t];
+			const auto& morphTarget = _morphTargets[primMesh.morphTargetIndex + t];
+			const std::pair<std::string, const GLTFMorphRange*> attributes[] = {
+				{ "POSITION", &morphTarget.position }, { "NORMAL", &morphTarget.normal }, { "TANGENT", &morphTarget.tangent }
+			};
+			for (const auto& attribute : attributes)
+			{
+				const GLTFMorphRange& range = *attribute.second;
+				if (range.count == 0)
+					continue;
+
+				const auto& accessor = model.accessors[target.find(attribute.first)->second];
+				const std::size_t numComponents = std::min<std::size_t>(tinygltf::GetNumComponentsInType(accessor.type), 3);
+				GLTFMorphDelta* deltas = _morphDeltas.data() + range.offset;
+				//! The deltas are written with the stride of GLTFMorphDelta, the vertex indices are left untouched
+				auto readDeltas = [&](const unsigned char* src, std::size_t stride, GLTFMorphDelta* dst, std::size_t count) {
+					if (!DequantizeAttributes(src, stride, accessor.componentType, accessor.normalized, numComponents,
+											  &dst->delta.x, sizeof(GLTFMorphDelta) / sizeof(float), count))
+						std::cerr << "[GLTFScene::ProcessMorphTargets] Unknown " << attribute.first << " component type : " << accessor.componentType << std::endl;
+				};
+
+				//! Indices and values of the sparse accessor, the values are tightly packed
+				std::vector<unsigned int> sparseIndices;
+				const unsigned char* sparseValues = nullptr;
+				if (accessor.sparse.isSparse)
+				{
+					sparseIndices.resize(accessor.sparse.count);
+					const unsigned char* indexData = getBufferViewData(accessor.sparse.indices.bufferView, accessor.sparse.indices.byteOffset);
+					switch (accessor.sparse.indices.componentType)
+					{
+					case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT:
+						std::memcpy(sparseIndices.data(), indexData, sparseIndices.size() * sizeof(unsigned int));
+						break;
+					case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT:
+						WidenIndices(reinterpret_cast<const unsigned short*>(indexData), sparseIndices.data(), sparseIndices.size());
+						break;
+					default:
+						WidenIndices(indexData, sparseIndices.data(), sparseIndices.size());
+						break;
+					}
+					sparseValues = getBufferViewData(accessor.sparse.values.bufferView, accessor.sparse.values.byteOffset);
+				}
+				const std::size_t sparseStride = numComponents * GetComponentSize(accessor.componentType);
+
+				if (range.sparse)
+				{
+					//! Only the listed vertices are stored, the indices out of the primitive are dropped
+					int count = 0;
+					for (std::size_t i = 0; i < sparseIndices.size() && count < range.count; ++i)
+					{
+						if (sparseIndices[i] >= primMesh.vertexCount)
+							continue;
+						deltas[count].vertex = primMesh.vertexOffset + sparseIndices[i];
+						readDeltas(sparseValues + i * sparseStride, sparseStride, deltas + count, 1);
+						++count;
+					}
+					std::sort(deltas, deltas + count, [](const GLTFMorphDelta& lhs, const GLTFMorphDelta& rhs) { return lhs.vertex < rhs.vertex; });
+					//! Dropped entries are kept as zero deltas of the last vertex
+					for (int i = count; i < range.count; ++i)
+						deltas[i] = GLTFMorphDelta{ glm::vec3(0.0f), count > 0 ? deltas[count - 1].vertex : primMesh.vertexOffset };
+				}
+				else
+				{
+					for (unsigned int v = 0; v < primMesh.vertexCount; ++v)
+						deltas[v].vertex = primMesh.vertexOffset + v;
+					const std::size_t numElements = std::min<std::size_t>(accessor.count, primMesh.vertexCount);
+					if (accessor.bufferView >= 0)
+					{
+						const int byteStride = accessor.ByteStride(model.bufferViews[accessor.bufferView]);
+						if (byteStride > 0)
+							readDeltas(GetAccessorData(model, accessor), static_cast<std::size_t>(byteStride), deltas, numElements);
+					}
+
+					//! The sparse values replace the base values
+					for (std::size_t i = 0; i < sparseIndices.size(); ++i)
+					{
+						if (sparseIndices[i] < numElements)
+							readDeltas(sparseValues + i * sparseStride, sparseStride, deltas + sparseIndices[i], 1);
+					}
+				}
+			}
+		}
+	}
+
+	bool GLTFScene::LoadModel(tinygltf::Model* model, const std::string& filename, const GLTFLoadOptions& options)
+	{
+		//! Read the source through the mapping, the file contents are not copied to the heap
+		auto file = std::make_unique<MappedFile>();
+		if (!file->Open(filename))
+		{
+			std::cerr << "Failed to open GLTF model : " << filename << std::endl;
+			return false;
+		}
+
+		const std::string baseDir = tinygltf::GetBaseDir(filename);
+		bool res = options.memoryMapped && LoadMappedModel(model, *file, baseDir);
+		if (res)
+		{
+			_mappedFiles.emplace_back(std::move(file));
+		}
+		else
+		{
+			*model = tinygltf::Model();
+
+			//! Binary glTF always starts with the magic "glTF"
+			tinygltf::TinyGLTF loader;
+			std::string err, warn;
+			if (file->GetSize() >= 4 && std::memcmp(file->GetData(), "glTF", 4) == 0)
+				res = loader.LoadBinaryFromMemory(model, &err, &warn, file->GetData(), static_cast<unsigned int>(file->GetSize()), baseDir);
+			else
+				res = loader.LoadASCIIFromString(model, &err, &warn, reinterpret_cast<const char*>(file->GetData()), static_cast<unsigned int>(file->GetSize()), baseDir);
+
+			if (!warn.empty())
+				std::clog << "[GLTFScene::LoadModel] " << warn << std::endl;
+			if (!err.empty())
+				std::cerr << "[GLTFScene::LoadModel] " << err << std::endl;
+
+			//! Every buffer lives in the tinygltf model
+			_bufferData.clear();
+			for (const auto& buffer : model->buffers)
+				_bufferData.push_back(buffer.data.data());
+		}
+
+		if (!res)
+			std::cerr << "Failed to load GLTF model : " << filename << std::endl;
+
+		return res;
+	}
+
+	namespace
+	{
+		//! 1-byte data uri replacing the mapped buffers in the json, tinygltf requires a valid buffer
+		constexpr const char* kPlaceholderBufferURI = "data:application/octet-stream;base64,AA==";
+
+		//! Image loader context for images stored in the mapped buffers
+		struct MappedImageContext
+		{
+			std::unordered_map<int, std::pair<const unsigned char*, std::size_t>> images;
+		};
+
+		bool LoadMappedImageData(tinygltf::Image* image, const int imageIdx, std::string* err, std::string* warn, int reqWidth, int reqHeight, const unsigned char* bytes, int size, void* userData)
+		{
+			const auto* context = static_cast<const MappedImageContext*>(userData);
+			auto iter = context->images.find(imageIdx);
+			if (iter != context->images.end())
+			{
+				bytes = iter->second.first;
+				size = static_cast<int>(iter->second.second);
+			}
+
+			return tinygltf::LoadImageData(image, imageIdx, err, warn, reqWidth, reqHeight, bytes, size, nullptr);
+		}
+	};
+
+	bool GLTFScene::LoadMappedModel(tinygltf::Model* model, const MappedFile& file, const std::string& baseDir)
+	{
+		const unsigned char* data = file.GetData();
+		const std::size_t size = file.GetSize();
+
+		//! Find json and binary chunk from the file
+		const char* jsonBegin = reinterpret_cast<const char*>(data);
+		std::size_t jsonLength = size;
+		const unsigned char* binChunk = nullptr;
+		std::size_t binLength = 0;
+		if (size >= 4 && std::memcmp(data, "glTF", 4) == 0)
+		{
+			//! https://github.com/KhronosGroup/glTF/tree/master/specification/2.0#glb-file-format-specification
+			auto readU32 = [data](std::size_t offset) {
+				uint32_t value;
+				std::memcpy(&value, data + offset, sizeof(uint32_t));
+				return value;
+			};
+
+			if (size < 20 || readU32(4) != 2 || readU32(16) != 0x4E4F534A /* JSON */)
+				return false;
+
+			jsonLength = readU32(12);
+			jsonBegin = reinterpret_cast<const char*>(data + 20);
+			const std::size_t binHeader = 20 + ((jsonLength + 3) & ~std::size_t(3));
+			if (binHeader > size)
+				return false;
+			if (binHeader + 8 <= size && readU32(binHeader + 4) == 0x004E4942 /* BIN */)
+			{
+				binLength = std::min<std::size_t>(readU32(binHeader), size - binHeader - 8);
+				binChunk = data + binHeader + 8;
+			}
+		}
+
+		nlohmann::json document = nlohmann::json::parse(jsonBegin, jsonBegin + jsonLength, nullptr, false);
+		if (document.is_discarded() || !document.is_object())
+			return false;
+
+		//! Draco decoder reads the compressed buffer views while parsing
+		if (document.count("extensionsUsed") > 0)
+		{
+			for (const auto& extension : document["extensionsUsed"])
+				if (extension.is_string() && extension.get<std::string>() == KHR_DARCO_MESH_EXTENSION_NAME)
+					return false;
+		}
+
+		//! Map the binary buffers and replace them with the placeholder
+		std::vector<std::unique_ptr<MappedFile>> mappedFiles;
+		std::vector<const unsigned char*> mappedBuffers;
+		int placeholderBuffer = -1;
+		if (document.count("buffers") > 0)
+		{
+			auto& buffers = document["buffers"];
+			for (std::size_t i = 0; i < buffers.size(); ++i)
+			{
+				auto& buffer = buffers[i];
+				const std::size_t byteLength = buffer.value("byteLength", std::size_t(0));
+				const std::string uri = buffer.value("uri", std::string());
+
+				const unsigned char* mapped = nullptr;
+				if (uri.empty())
+				{
+					if (binChunk == nullptr || byteLength > binLength)
+						return false;
+					mapped = binChunk;
+				}
+				else if (uri.compare(0, 5, "data:") != 0)
+				{
+					auto binFile = std::make_unique<MappedFile>();
+					const std::string path = baseDir.empty() ? tinygltf::dlib::urldecode(uri) : baseDir + "/" + tinygltf::dlib::urldecode(uri);
+					if (!binFile->Open(path) || binFile->GetSize() < byteLength)
+						return false;
+					mapped = binFile->GetData();
+					mappedFiles.emplace_back(std::move(binFile));
+				}
+
+				mappedBuffers.push_back(mapped);
+				if (mapped != nullptr)
+				{
+					buffer["byteLength"] = 1;
+					buffer["uri"] = kPlaceholderBufferURI;
+					placeholderBuffer = static_cast<int>(i);
+				}
+			}
+		}
+
+		//! Images stored in the mapped buffers are decoded from the mapping.
+		//! Their buffer view is redirected to the placeholder while tinygltf parses them.
+		MappedImageContext imageContext;
+		std::unordered_map<int, int> imageBufferViews;
+		if (placeholderBuffer != -1 && document.count("images") > 0 && document.count("bufferViews") > 0)
+		{
+			auto& bufferViews = document["bufferViews"];
+			const int placeholderView = static_cast<int>(bufferViews.size());
+			auto& images = document["images"];
+			for (std::size_t i = 0; i < images.size(); ++i)
+			{
+				auto& image = images[i];
+				if (image.count("bufferView") == 0)
+					continue;
+
+				const int viewIdx = image["bufferView"].get<int>();
+				if (viewIdx < 0 || viewIdx >= placeholderView)
+					return false;
+				const auto& view = bufferViews[viewIdx];
+				const int bufferIdx = view.value("buffer", -1);
+				if (bufferIdx < 0 || bufferIdx >= static_cast<int>(mappedBuffers.size()) || mappedBuffers[bufferIdx] == nullptr)
+					continue;
+
+				imageContext.images[static_cast<int>(i)] = { mappedBuffers[bufferIdx] + view.value("byteOffset", std::size_t(0)), view.value("byteLength", std::size_t(0)) };
+				imageBufferViews[static_cast<int>(i)] = viewIdx;
+				image["bufferView"] = placeholderView;
+			}
+
+			if (!imageBufferViews.empty())
+				bufferViews.push_back({ { "buffer", placeholderBuffer }, { "byteOffset", 0 }, { "byteLength", 1 } });
+		}
+
+		tinygltf::TinyGLTF loader;
+		loader.SetImageLoader(LoadMappedImageData, &imageContext);
+		std::string err, warn;
+		const std::string json = document.dump();
+		//! Release the document before tinygltf builds it's own one
+		document = nlohmann::json();
+		if (!loader.LoadASCIIFromString(model, &err, &warn, json.c_str(), static_cast<unsigned int>(json.size()), baseDir))
+		{
+			std::cerr << "[GLTFScene::LoadMappedModel] " << err << std::endl;
+			return false;
+		}
+		if (!warn.empty())
+			std::clog << "[GLTFScene::LoadMappedModel] " << warn << std::endl;
+
+		//! Restore the original image buffer views and remove the placeholder
+		if (!imageBufferViews.empty())
+		{
+			model->bufferViews.pop_back();
+			for (const auto& image : imageBufferViews)
+				model->images[image.first].bufferView = image.second;
+		}
+
+		_bufferData.resize(model->buffers.size());
+		for (std::size_t i = 0; i < model->buffers.size(); ++i)
+		{
+			auto& buffer = model->buffers[i];
+			if (i < mappedBuffers.size() && mappedBuffers[i] != nullptr)
+			{
+				buffer.data.clear();
+				_bufferData[i] = mappedBuffers[i];
+			}
+			else
+			{
+				_bufferData[i] = buffer.data.data();
+			}
+		}
+
+		for (auto& mappedFile : mappedFiles)
+			_mappedFiles.emplace_back(std::move(mappedFile));
+
+		return true;
+	}
+
+	bool GLTFScene::PrepareQuantizedStream(const tinygltf::Model& model, const std::vector<const tinygltf::Primitive*>& primitives, const std::string& name, std::size_t numVertices, GLTFQuantizedStream* stream) const
+	{
+		if (primitives.empty())
+			return false;
+
+		const tinygltf::Accessor* first = nullptr;
+		for (const auto* primitive : primitives)
+		{
+			auto iter = primitive->attributes.find(name);
+			if (iter == primitive->attributes.end())
+				return false;
+
+			//! Streams are concatenated into one vertex buffer, therefore they must share one format
+			const auto& accessor = model.accessors[iter->second];
+			if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT || accessor.bufferView < 0)
+				return false;
+			if (first == nullptr)
+				first = &accessor;
+			else if (accessor.componentType != first->componentType || accessor.normalized != first->normalized || accessor.type != first->type)
+				return false;
+		}
+
+		const std::size_t componentSize = GetComponentSize(first->componentType);
+		if (componentSize == 0)
+			return false;
+
+		stream->componentType = first->componentType;
+		stream->numComponents = tinygltf::GetNumComponentsInType(first->type);
+		stream->normalized = first->normalized;
+		stream->elementSize = static_cast<unsigned int>((stream->numComponents * componentSize + 3) & ~static_cast<std::size_t>(3));
+		stream->data.resize(numVertices * stream->elementSize);
+		return true;
+	}
+
+	void GLTFScene::CopyQuantizedAttributes(const tinygltf::Model& model, const tinygltf::Primitive& primitive, const std::string& name, const GLTFPrimMesh& primMesh, GLTFQuantizedStream* stream) const
+	{
+		const auto& accessor = model.accessors[primitive.attributes.find(name)->second];
+		const std::size_t byteStride = static_cast<std::size_t>(accessor.ByteStride(model.bufferViews[accessor.bufferView]));
+		const std::size_t numElements = std::min<std::size_t>(accessor.count, primMesh.vertexCount);
+		const std::size_t copySize = stream->numComponents * GetComponentSize(stream->componentType);
+
+		const unsigned char* src = GetAccessorData(model, accessor);
+		unsigned char* dst = stream->data.data() + static_cast<std::size_t>(primMesh.vertexOffset) * stream->elementSize;
+		if (numElements == 0)
+			return;
+
+		//! Padding of the last element may be out of the buffer view
+		if (byteStride == stream->elementSize)
+		{
+			std::memcpy(dst, src, (numElements - 1) * stream->elementSize + copySize);
+			return;
+		}
+
+		for (std::size_t i = 0; i < numElements; ++i)
+			std::memcpy(dst + i * stream->elementSize, src + i * byteStride, copySize);
+	}
+
+	void GLTFScene::OptimizeMeshes()
+	{
+		//! Drawing the clusters out of the cache order may raise ACMR up to this ratio
+		constexpr float kOverdrawThreshold = 1.05f;
+
+		std::vector<std::pair<VertexCacheStatistics, VertexCacheStatistics>> statistics(_scenePrimMeshes.size());
+		ThreadPool::GetInstance().ParallelFor(_scenePrimMeshes.size(), 1, [&](std::size_t begin, std::size_t end) {
+			std::vector<unsigned int> scratch, remap;
+			std::vector<unsigned char> vertexScratch;
+			for (std::size_t i = begin; i < end; ++i)
+			{
+				const auto& primMesh = _scenePrimMeshes[i];
+				unsigned int* indices = _indices.data() + primMesh.firstIndex;
+				const std::size_t indexCount = primMesh.indexCount, vertexCount = primMesh.vertexCount;
+
+				auto& statistic = statistics[i];
+				statistic.first = AnalyzeVertexCache(indices, indexCount, vertexCount);
+				statistic.second = statistic.first;
+				if (indexCount < 3 || std::any_of(indices, indices + indexCount, [vertexCount](unsigned int index) { return index >= vertexCount; }))
+					continue;
+
+				scratch.resize(indexCount);
+				OptimizeVertexCache(scratch.data(), indices, indexCount, vertexCount);
+				OptimizeOverdraw(indices, scratch.data(), indexCount, _positions.data() + primMesh.vertexOffset, vertexCount, kOverdrawThreshold);
+
+				remap.resize(vertexCount);
+				BuildVertexFetchRemap(remap.data(), indices, indexCount, vertexCount);
+				for (std::size_t k = 0; k < indexCount; ++k)
+					indices[k] = remap[indices[k]];
+
+				//! Move every vertex of the primitive to its remapped slot
+				auto reorderStream = [&](unsigned char* data, std::size_t elementSize) {
+					unsigned char* first = data + primMesh.vertexOffset * elementSize;
+					vertexScratch.assign(first, first + vertexCount * elementSize);
+					for (std::size_t v = 0; v < vertexCount; ++v)
+						std::memcpy(first + remap[v] * elementSize, vertexScratch.data() + v * elementSize, elementSize);
+				};
+				auto reorderVector = [&](auto& stream) {
+					if (!stream.empty())
+						reorderStream(reinterpret_cast<unsigned char*>(stream.data()), sizeof(stream[0]));
+				};
+				reorderVector(_positions);
+				reorderVector(_normals);
+				reorderVector(_tangents);
+				reorderVector(_colors);
+				reorderVector(_texCoords);
+				reorderVector(_skinJoints);
+				reorderVector(_skinWeights);
+
+				//! Dense morph deltas follow their vertices, the sparse ones are sorted again
+				for (int t = primMesh.morphTargetIndex; t < primMesh.morphTargetIndex + primMesh.morphTargetCount; ++t)
+				{
+					for (const auto* range : { &_morphTargets[t].position, &_morphTargets[t].normal, &_morphTargets[t].tangent })
+					{
+						GLTFMorphDelta* deltas = _morphDeltas.data() + range->offset;
+						for (int i = 0; i < range->count; ++i)
+							deltas[i].vertex = primMesh.vertexOffset + remap[deltas[i].vertex - primMesh.vertexOffset];
+						std::stable_sort(deltas, deltas + range->count, [](const GLTFMorphDelta& lhs, const GLTFMorphDelta& rhs) { return lhs.vertex < rhs.vertex; });
+					}
+				}
+				for (auto* stream : { &_quantizedPositions, &_quantizedNormals, &_quantizedTangents, &_quantizedColors, &_quantizedTexCoords })
+				{
+					if (!stream->data.empty())
+						reorderStream(stream->data.data(), stream->elementSize);
+				}
+
+				statistic.second = AnalyzeVertexCache(indices, indexCount, vertexCount);
+			}
+		});
+
+		//! Weighted by the number of triangles and vertices of the primitives
+		std::size_t numTriangles = 0, numVertices = 0, transformsBefore = 0, transformsAfter = 0;
+		for (std::size_t i = 0; i < _scenePrimMeshes.size(); ++i)
+		{
+			numTriangles += _scenePrimMeshes[i].indexCount / 3;
+			numVertices += _scenePrimMeshes[i].vertexCount;
+			transformsBefore += statistics[i].first.vertexTransforms;
+			transformsAfter += statistics[i].second.vertexTransforms;
+		}
+		if (numTriangles == 0 || numVertices == 0)
+			return;
+
+		std::clog << "[GLTFScene::OptimizeMeshes] " << _scenePrimMeshes.size() << " primitives, FIFO cache of " << kVertexCacheSize << " vertices\n"
+				  << "\tACMR : " << static_cast<float>(transformsBefore) / numTriangles << " -> " << static_cast<float>(transformsAfter) / numTriangles << '\n'
+				  << "\tATVR : " << static_cast<float>(transformsBefore) / numVertices << " -> " << static_cast<float>(transformsAfter) / numVertices << std::endl;
+	}
+
+	void GLTFScene::GenerateLods(bool optimizeMeshes)
+	{
+		constexpr std::size_t kMaxLods = 4;
+		//! Each level targets half of the previous one and is dropped if it keeps more than 80%
+		constexpr float kLodReduction = 0.5f;
+		constexpr float kMinReduction = 0.8f;
+		//! Primitives and levels smaller than this are not simplified further
+		constexpr std::size_t kMinLodIndices = 3 * 64;
+		//! Largest accumulated error relative to the bounding radius of the primitive
+		constexpr float kMaxRelativeError = 0.25f;
+
+		std::vector<std::vector<unsigned int>> lodIndices(_scenePrimMeshes.size());
+		ThreadPool::GetInstance().ParallelFor(_scenePrimMeshes.size(), 1, [&](std::size_t begin, std::size_t end) {
+			std::vector<unsigned int> source, simplified, optimized;
+			for (std::size_t i = begin; i < end; ++i)
+			{
+				auto& primMesh = _scenePrimMeshes[i];
+				const unsigned int* indices = _indices.data() + primMesh.firstIndex;
+				const glm::vec3* positions = _positions.data() + primMesh.vertexOffset;
+				const std::size_t vertexCount = primMesh.vertexCount;
+				primMesh.lods.clear();
+				if (primMesh.indexCount < kMinLodIndices * 2 ||
+					std::any_of(indices, indices + primMesh.indexCount, [vertexCount](unsigned int index) { return index >= vertexCount; }))
+					continue;
+
+				glm::vec3 lower = positions[0], upper = positions[0];
+				for (std::size_t v = 1; v < vertexCount; ++v)
+				{
+					lower = glm::min(lower, positions[v]);
+					upper = glm::max(upper, positions[v]);
+				}
+				const float maxError = glm::length(upper - lower) * 0.5f * kMaxRelativeError;
+
+				//! Every level is simplified from the previous one, the errors are accumulated
+				source.assign(indices, indices + primMesh.indexCount);
+				float error = 0.0f;
+				for (std::size_t level = 0; level < kMaxLods && error < maxError; ++level)
+				{
+					const std::size_t targetIndexCount = static_cast<std::size_t>(source.size() * kLodReduction) / 3 * 3;
+					if (targetIndexCount < kMinLodIndices)
+						break;
+
+					float levelError = 0.0f;
+					simplified.resize(source.size());
+					const std::size_t indexCount = SimplifyMesh(simplified.data(), source.data(), source.size(), positions, vertexCount,
+																targetIndexCount, maxError - error, &levelError);
+					if (indexCount == 0 || indexCount > source.size() * kMinReduction)
+						break;
+					simplified.resize(indexCount);
+
+					if (optimizeMeshes)
+					{
+						optimized.resize(indexCount);
+						OptimizeVertexCache(optimized.data(), simplified.data(), indexCount, vertexCount);
+						simplified.swap(optimized);
+					}
+
+					error += levelError;
+					primMesh.lods.push_back({ 0, static_cast<unsigned int>(indexCount), error });
+					lodIndices[i].insert(lodIndices[i].end(), simplified.begin(), simplified.end());
+					source.swap(simplified);
+				}
+			}
+		});
+
+		//! Append the levels after the indices of all primitives
+		std::size_t numIndices = _indices.size();
+		for (const auto& indices : lodIndices)
+			numIndices += indices.size();
+		_indices.reserve(numIndices);
+
+		std::vector<std::size_t> levelTriangles(kMaxLods + 1, 0), levelPrimitives(kMaxLods + 1, 0);
+		for (std::size_t i = 0; i < _scenePrimMeshes.size(); ++i)
+		{
+			auto& primMesh = _scenePrimMeshes[i];
+			levelTriangles[0] += primMesh.indexCount / 3;
+			++levelPrimitives[0];
+
+			//! The levels of the primitive are contiguous in their order
+			unsigned int firstIndex = static_cast<unsigned int>(_indices.size());
+			for (std::size_t level = 0; level < primMesh.lods.size(); ++level)
+			{
+				auto& lod = primMesh.lods[level];
+				lod.firstIndex = firstIndex;
+				firstIndex += lod.indexCount;
+				levelTriangles[level + 1] += lod.indexCount / 3;
+				++levelPrimitives[level + 1];
+			}
+			_indices.insert(_indices.end(), lodIndices[i].begin(), lodIndices[i].end());
+		}
+
+		std::clog << "[GLTFScene::GenerateLods] triangles(primitives) per level :";
+		for (std::size_t level = 0; level <= kMaxLods && levelPrimitives[level] > 0; ++level)
+			std::clog << ' ' << levelTriangles[level] << '(' << levelPrimitives[level] << ')';
+		std::clog << std::endl;
+	}
+
+	void GLTFScene::CompressVertexAttributes(VertexFormat format)
+	{
+		//! The float streams are in the mapped scene cache after a warm start
+		const auto positions = GetPositions();
+		const auto normals = GetNormals();
+		const auto tangents = GetTangents();
+		const auto colors = GetColors();
+		const auto texCoords = GetTexCoords();
+		const std::size_t numVertices = positions.size();
+		auto resetStream = [numVertices](GLTFQuantizedStream* stream, int componentType, int numComponents, bool normalized, unsigned int elementSize) {
+			stream->componentType = componentType;
+			stream->numComponents = numComponents;
+			stream->normalized = normalized;
+			stream->elementSize = elementSize;
+			stream->data.resize(numVertices * elementSize);
+		};
+		const bool hasNormals = static_cast<int>(format & VertexFormat::Normal3) != 0;
+		const bool hasTangents = static_cast<int>(format & VertexFormat::Tangent4) != 0;
+		const bool hasColors = static_cast<int>(format & VertexFormat::Color4) != 0;
+		const bool hasTexCoords = static_cast<int>(format & VertexFormat::TexCoord2) != 0;
+
+		//! The 4th component of the positions is a padding
+		resetStream(&_quantizedPositions, TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, 3, true, 4 * sizeof(uint16_t));
+		if (hasNormals)
+			resetStream(&_quantizedNormals, TINYGLTF_COMPONENT_TYPE_SHORT, 2, true, 2 * sizeof(int16_t));
+		if (hasTangents)
+			resetStream(&_quantizedTangents, kComponentTypeInt2101010Rev, 4, true, sizeof(uint32_t));
+		if (hasColors)
+			resetStream(&_quantizedColors, TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE, 4, true, sizeof(uint32_t));
+		if (hasTexCoords)
+			resetStream(&_quantizedTexCoords, kComponentTypeHalfFloat, 2, false, 2 * sizeof(uint16_t));
+
+		//! Largest error of each primitive, angles of the directions in degrees
+		struct EncodingError
+		{
+			float position{ 0.0f };
+			float relativePosition{ 0.0f };
+			float normal{ 0.0f };
+			float tangent{ 0.0f };
+			float color{ 0.0f };
+			float texCoord{ 0.0f };
+		};
+		std::vector<EncodingError> errors(_scenePrimMeshes.size());
+
+		auto angleBetween = [](const glm::vec3& direction, const glm::vec3& decoded) {
+			const float length = glm::length(direction);
+			if (length == 0.0f)
+				return 0.0f;
+			return glm::degrees(std::acos(glm::clamp(glm::dot(direction / length, decoded), -1.0f, 1.0f)));
+		};
+
+		ThreadPool::GetInstance().ParallelFor(_scenePrimMeshes.size(), 1, [&](std::size_t begin, std::size_t end) {
+			for (std::size_t i = begin; i < end; ++i)
+			{
+				auto& primMesh = _scenePrimMeshes[i];
+				auto& error = errors[i];
+				const std::size_t first = primMesh.vertexOffset, last = first + primMesh.vertexCount;
+				if (first == last)
+					continue;
+
+				//! The accessor bounds are used unless some vertices lie outside of them,
+				//! e.g. the bounds of the quantized accessors are in the quantized space.
+				glm::vec3 lower = positions[first], upper = positions[first];
+				for (std::size_t v = first; v < last; ++v)
+				{
+					lower = glm::min(lower, positions[v]);
+					upper = glm::max(upper, positions[v]);
+				}
+				if (glm::all(glm::lessThanEqual(primMesh.min, lower)) && glm::all(glm::lessThanEqual(upper, primMesh.max)))
+				{
+					lower = primMesh.min;
+					upper = primMesh.max;
+				}
+				primMesh.positionOffset = lower;
+				primMesh.positionScale = upper - lower;
+
+				const float maxExtent = std::max({ primMesh.positionScale.x, primMesh.positionScale.y, primMesh.positionScale.z });
+				glm::vec3 invScale(0.0f);
+				for (int c = 0; c < 3; ++c)
+				{
+					if (primMesh.positionScale[c] > 0.0f)
+						invScale[c] = 65535.0f / primMesh.positionScale[c];
+				}
+
+				for (std::size_t v = first; v < last; ++v)
+				{
+					const glm::vec3& position = positions[v];
+					const glm::vec3 quantized = glm::round(glm::clamp((position - lower) * invScale, 0.0f, 65535.0f));
+					const uint16_t packed[4] = { static_cast<uint16_t>(quantized.x), static_cast<uint16_t>(quantized.y), static_cast<uint16_t>(quantized.z), 0 };
+					std::memcpy(_quantizedPositions.data.data() + v * _quantizedPositions.elementSize, packed, sizeof(packed));
+
+					const glm::vec3 decoded = lower + quantized / 65535.0f * primMesh.positionScale;
+					const glm::vec3 diff = glm::abs(decoded - position);
+					error.position = std::max({ error.position, diff.x, diff.y, diff.z });
+				}
+				if (maxExtent > 0.0f)
+					error.relativePosition = error.position / maxExtent;
+
+				for (std::size_t v = first; v < last; ++v)
+				{
+					if (hasNormals)
+					{
+						const uint32_t packed = glm::packSnorm2x16(EncodeOctahedral(normals[v]));
+						std::memcpy(_quantizedNormals.data.data() + v * _quantizedNormals.elementSize, &packed, sizeof(packed));
+						error.normal = std::max(error.normal, angleBetween(normals[v], DecodeOctahedral(glm::unpackSnorm2x16(packed))));
+					}
+					if (hasTangents)
+					{
+						//! Direction in snorm RGB and the handedness in A, normalized back to the vec4 by the vertex fetch
+						const glm::vec3 tangent(tangents[v]);
+						const float length = glm::length(tangent);
+						const glm::vec3 direction = length > 0.0f ? tangent / length : tangent;
+						const uint32_t packed = glm::packSnorm3x10_1x2(glm::vec4(direction, tangents[v].w < 0.0f ? -1.0f : 1.0f));
+						std::memcpy(_quantizedTangents.data.data() + v * _quantizedTangents.elementSize, &packed, sizeof(packed));
+						const glm::vec3 unpacked(glm::unpackSnorm3x10_1x2(packed));
+						error.tangent = std::max(error.tangent, angleBetween(tangent, glm::length(unpacked) > 0.0f ? glm::normalize(unpacked) : unpacked));
+					}
+					if (hasColors)
+					{
+						const uint32_t packed = glm::packUnorm4x8(colors[v]);
+						std::memcpy(_quantizedColors.data.data() + v * _quantizedColors.elementSize, &packed, sizeof(packed));
+						const glm::vec4 diff = glm::abs(glm::unpackUnorm4x8(packed) - colors[v]);
+						error.color = std::max({ error.color, diff.x, diff.y, diff.z, diff.w });
+					}
+					if (hasTexCoords)
+					{
+						const uint32_t packed = glm::packHalf2x16(texCoords[v]);
+						std::memcpy(_quantizedTexCoords.data.data() + v * _quantizedTexCoords.elementSize, &packed, sizeof(packed));
+						const glm::vec2 diff = glm::abs(glm::unpackHalf2x16(packed) - texCoords[v]);
+						error.texCoord = std::max({ error.texCoord, diff.x, diff.y });
+					}
+				}
+			}
+		});
+
+		EncodingError maxError;
+		for (const auto& error : errors)
+		{
+			maxError.position = std::max(maxError.position, error.position);
+			maxError.relativePosition = std::max(maxError.relativePosition, error.relativePosition);
+			maxError.normal = std::max(maxError.normal, error.normal);
+			maxError.tangent = std::max(maxError.tangent, error.tangent);
+			maxError.color = std::max(maxError.color, error.color);
+			maxError.texCoord = std::max(maxError.texCoord, error.texCoord);
+		}
+
+		std::clog << "[GLTFScene::CompressVertexAttributes] " << VertexHelper::GetSizeInBytes(format) << " -> "
+				  << VertexHelper::GetCompressedSizeInBytes(format) << " bytes per vertex, max errors :\n"
+				  << "\tposition  : " << maxError.position << " (" << maxError.relativePosition * 100.0f << "% of the primitive bounds)\n";
+		if (hasNormals)
+			std::clog << "\tnormal    : " << maxError.normal << " (deg)\n";
+		if (hasTangents)
+			std::clog << "\ttangent   : " << maxError.tangent << " (deg)\n";
+		if (hasColors)
+			std::clog << "\tcolor     : " << maxError.color << '\n';
+		if (hasTexCoords)
+			std::clog << "\ttexcoord  : " << maxError.texCoord << '\n';
+	}
+
+	const unsigned char* GLTFScene::GetAccessorData(const tinygltf::Model& model, const tinygltf::Accessor& accessor) const
+	{
+		const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+		return _bufferData[bufferView.buffer] + bufferView.byteOffset + accessor.byteOffset;
+	}
+
+	void GLTFScene::ProcessNode(const tinygltf::Model& model, int nodeIdx, int parentIndex)
+	{
+		const auto& node = model.nodes[nodeIdx];
+
+		GLTFNode newNode;
+		//! Gets transformation info from the given node
+		if (node.translation.empty() == false)
+			newNode.translation = glm::vec3(node.translation[0], node.translation[1], node.translation[2]);
+		if (node.scale.empty() == false)
+			newNode.scale = glm::vec3(node.scale[0], node.scale[1], node.scale[2]);
+		if (node.rotation.empty() == false)
+			newNode.rotation = glm::quat(node.rotation[3], node.rotation[0], node.rotation[1], node.rotation[2]);
+		if (node.matrix.empty() == false)
+		{
+			float* nodeMatPtr = glm::value_ptr(newNode.local);
+			for (int i = 0; i < 16; ++i)
+				nodeMatPtr[i] = static_cast<float>(node.matrix[i]);
+		}
+
+		//! Calculate world matrix
+		const glm::mat4 transform = GetLocalMatrix(newNode);
+		glm::mat4 worldMat = (parentIndex != -1 ? _nodeWorlds[parentIndex] : glm::mat4(1.0f)) * transform;
+
+		if (node.camera > -1)
+		{
+			GLTFCamera camera;
+			camera.world = worldMat;
+			camera.camera = model.cameras[model.nodes[nodeIdx].camera];
+
+			//! If the node has the Iray extension, extract the camera information
+			if (node.extensions.find("NV_attributes_iray") != node.extensions.end())
+			{
+				auto& iray_ext = node.extensions.find("NV_attributes_iray")->second;
+				auto& attributes = iray_ext.Get("attributes");
+				for (size_t idx = 0; idx < attributes.ArrayLen(); ++idx)
+				{
+					auto& attrib = attributes.Get(idx);
+					std::string attName = attrib.Get("name").Get<std::string>();
+					auto& attValue = attrib.Get("value");
+					if (attValue.IsArray())
+					{
+						auto vec = GetVector<float>(attValue);
+						if (attName == "ivew:position")
+							camera.eye = { vec[0], vec[1], vec[2] };
+						else if (attName == "iview:interest")
+							camera.center = { vec[0], vec[1], vec[2] };
+						else if (attName == "iview:up")
+							camera.up = { vec[0], vec[1], vec[2] };
+					}
+				}
+			}
+
+			_sceneCameras.emplace_back(camera);
+		}
+		else if (node.extensions.find(KHR_LIGHTS_PUNCTUAL_EXTENSION_NAME) != node.extensions.end())
+		{
+			GLTFLight light;
+			const auto& ext = node.extensions.find(KHR_LIGHTS_PUNCTUAL_EXTENSION_NAME)->second;
+			auto lightIdx = ext.Get("light").GetNumberAsInt();
+			light.light = model.lights[lightIdx];
+			light.world = worldMat;
+			_sceneLights.emplace_back(light);
+		}
+		else
+		{
+			if (node.mesh > -1)
 			{
-				//! Implementation in "Foundations of Game Engine Development : Volume2 Rendering"
-				std::vector<glm::vec3> tangents(resultMesh.vertexCount, glm::vec3(0.0f));
-				std::vector<glm::vec3> bitangents(resultMesh.vertexCount, glm::vec3(0.0f));
-				for (size_t i = 0; i < resultMesh.indexCount; i += 3)
+				newNode.primMeshes = std::move(_meshToPrimMap[node.mesh]);
+
+				//! Weights of the node override the default weights of the mesh, missing ones are zero
+				const auto& mesh = model.meshes[node.mesh];
+				for (const auto& prim : mesh.primitives)
+					newNode.weightCount = std::max(newNode.weightCount, static_cast<int>(prim.targets.size()));
+				if (newNode.weightCount > 0)
+				{
+					const auto& weights = node.weights.empty() ? mesh.weights : node.weights;
+					newNode.weightIndex = static_cast<int>(_morphWeights.size());
+					for (int t = 0; t < newNode.weightCount; ++t)
+						_morphWeights.push_back(t < static_cast<int>(weights.size()) ? static_cast<float>(weights[t]) : 0.0f);
+				}
+			}
+
+			newNode.nodeIndex = nodeIdx;
+			newNode.skin = node.skin;
+
+			//! Push newnode to both linear scene node array and parent child array
+			const int newNodeIndex = static_cast<int>(_sceneNodes.size());
+			_nodeRemap[nodeIdx] = newNodeIndex;
+			_sceneNodes.emplace_back(std::move(newNode));
+			_nodeWorlds.push_back(worldMat);
+			_nodeTransforms.push_back(transform);
+			_nodeParents.push_back(parentIndex);
+			if (parentIndex != -1)
+				_sceneNodes[parentIndex].childNodes.push_back(newNodeIndex);
+
+			//! Call ProcessNode recursively to the childs of this newNode
+			for (auto child : node.children)
+				ProcessNode(model, child, newNodeIndex);
+			_sceneNodes[newNodeIndex].subtreeEnd = static_cast<int>(_sceneNodes.size());
+		}
+	}
+
+	namespace
+	{
+		//! result = parent * local, the result must not alias the operands
+		inline void MultiplyMatrix(glm::mat4& result, const glm::mat4& parent, const glm::mat4& local)
+		{
+#if defined(SIMD_SSE2)
+			const float* lhs = &parent[0][0];
+			const float* rhs = &local[0][0];
+			const __m128 column0 = _mm_loadu_ps(lhs);
+			const __m128 column1 = _mm_loadu_ps(lhs + 4);
+			const __m128 column2 = _mm_loadu_ps(lhs + 8);
+			const __m128 column3 = _mm_loadu_ps(lhs + 12);
+			float* out = &result[0][0];
+			for (int c = 0; c < 4; ++c)
+			{
+				//! Each entry of the column is broadcast in the register instead of loaded four times
+				const __m128 column = _mm_loadu_ps(rhs + c * 4);
+				const __m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(column0, _mm_shuffle_ps(column, column, _MM_SHUFFLE(0, 0, 0, 0))),
+														 _mm_mul_ps(column1, _mm_shuffle_ps(column, column, _MM_SHUFFLE(1, 1, 1, 1)))),
+											  _mm_add_ps(_mm_mul_ps(column2, _mm_shuffle_ps(column, column, _MM_SHUFFLE(2, 2, 2, 2))),
+														 _mm_mul_ps(column3, _mm_shuffle_ps(column, column, _MM_SHUFFLE(3, 3, 3, 3)))));
+				_mm_storeu_ps(out + c * 4, sum);
+			}
+#else
+			result = parent * local;
+#endif
+		}
+	};
+
+	void GLTFScene::UpdateNodeTransforms()
+	{
+		//! Static frames end here
+		_updatedNodeRanges.clear();
+		if (_dirtyNodes.empty())
+			return;
+
+		//! The subtree of each dirty node is a contiguous range after it, and
+		//! the parent of each node in the range is updated before the node.
+		std::sort(_dirtyNodes.begin(), _dirtyNodes.end());
+		_dirtyNodes.erase(std::unique(_dirtyNodes.begin(), _dirtyNodes.end()), _dirtyNodes.end());
+
+		//! Local matrices of the other nodes are not changed
+		for (int nodeIndex : _dirtyNodes)
+			_nodeTransforms[nodeIndex] = GetLocalMatrix(_sceneNodes[nodeIndex]);
+
+		int updatedEnd = 0;
+		for (int root : _dirtyNodes)
+		{
+			//! Already updated as a descendant of the other dirty node
+			if (root < updatedEnd)
+				continue;
+
+			updatedEnd = _sceneNodes[root].subtreeEnd;
+			_updatedNodeRanges.emplace_back(root, updatedEnd);
+			for (int i = root; i < updatedEnd; ++i)
+			{
+				const int parentNode = _nodeParents[i];
+				if (parentNode == -1)
+					_nodeWorlds[i] = _nodeTransforms[i];
+				else
+					MultiplyMatrix(_nodeWorlds[i], _nodeWorlds[parentNode], _nodeTransforms[i]);
+			}
+		}
+
+		_dirtyNodes.clear();
+	}
+
+	bool GLTFScene::UpdateAnimation(int animIndex, float timeElapsed)
+	{
+		//! There is no animation corresponded to given index, therefore return.
+		if (_sceneAnims.size() <= animIndex)
+			return false;
+
+		bool sceneModified = false;
+		const auto& anim = _sceneAnims[animIndex];
+
+		//! Calculate timeElapsed modulo the clip duration
+		const float elapsed = anim.duration > 0.0f ? std::fmod(timeElapsed, anim.duration) : 0.0f;
+
+		//! The nodes of the same period are staggered by their index so that the reduced updates spread over the frames
+		const bool hasLod = !_nodeUpdatePeriods.empty();
+		const unsigned int frame = _animationFrame++;
+		_animationStats = AnimationStats();
+		for (int t = anim.trackIndex; t < anim.trackCount + anim.trackIndex; ++t)
+		{
+			auto& track = _sceneTracks[t];
+			std::size_t numActiveLanes = track.nodeIndices.size();
+			if (hasLod)
+			{
+				track.activeLanes.resize(track.nodeIndices.size());
+				numActiveLanes = 0;
+				for (std::size_t lane = 0; lane < track.nodeIndices.size(); ++lane)
+				{
+					const int nodeIndex = track.nodeIndices[lane];
+					const unsigned int period = static_cast<unsigned int>(std::max(_nodeUpdatePeriods[nodeIndex], 0));
+					track.activeLanes[lane] = period > 0 && (frame + static_cast<unsigned int>(nodeIndex)) % period == 0;
+					numActiveLanes += track.activeLanes[lane];
+				}
+			}
+
+			//! Channels of the weights span the lanes of their first target onwards
+			for (std::size_t lane = 0; lane < track.nodeIndices.size(); ++lane)
+			{
+				if (track.targetIndices[lane] != 0)
+					continue;
+				if (!hasLod || track.activeLanes[lane])
+					++_animationStats.evaluatedChannels;
+				else
+					++_animationStats.skippedChannels;
+			}
+			if (numActiveLanes == 0)
+				continue;
+
+			track.lanes.Evaluate(elapsed, hasLod ? track.activeLanes.data() : nullptr);
+			const float* x = track.lanes.GetResults(0);
+			const float* y = track.lanes.GetResults(1);
+			const float* z = track.lanes.GetResults(2);
+			const float* w = track.lanes.GetResults(3);
+
+			for (std::size_t lane = 0; lane < track.nodeIndices.size(); ++lane)
+			{
+				if (hasLod && !track.activeLanes[lane])
+					continue;
+				auto& node = _sceneNodes[track.nodeIndices[lane]];
+
+				//! Only the changed nodes are marked, holding keys cost nothing afterwards
+				bool nodeModified = false;
+				switch (track.path)
+				{
+				case GLTFChannel::Path::Translation:
+				{
+					const glm::vec3 translation(x[lane], y[lane], z[lane]);
+					nodeModified = translation != node.translation;
+					node.translation = translation;
+					break;
+				}
+				case GLTFChannel::Path::Rotation:
+				{
+					const glm::quat rotation(w[lane], x[lane], y[lane], z[lane]);
+					nodeModified = rotation != node.rotation;
+					node.rotation = rotation;
+					break;
+				}
+				case GLTFChannel::Path::Scale:
+				{
+					const glm::vec3 scale(x[lane], y[lane], z[lane]);
+					nodeModified = scale != node.scale;
+					node.scale = scale;
+					break;
+				}
+				case GLTFChannel::Path::Weights:
 				{
-					//! Local index
-					unsigned int idx0 = _indices[resultMesh.firstIndex + i + 0];
-					unsigned int idx1 = _indices[resultMesh.firstIndex + i + 1];
-					unsigned int idx2 = _indices[resultMesh.firstIndex + i + 2];
-					//! Global index
-					unsigned int gidx0 = idx0 + resultMesh.vertexOffset;
-					unsigned int gidx1 = idx1 + resultMesh.vertexOffset;
-					unsigned int gidx2 = idx2 + resultMesh.vertexOffset;
-
-					const auto& pos0 = _positions[gidx0];
-					const auto& pos1 = _positions[gidx1];
-					const auto& pos2 = _positions[gidx2];
-
-					const auto& uv0 = _texCoords[gidx0];
-					const auto& uv1 = _texCoords[gidx1];
-					const auto& uv2 = _texCoords[gidx2];
-
-					glm::vec3 e1 = pos1 - pos0, e2 = pos2 - pos0;
-					float x1 = uv1.x - uv0.x, x2 = uv2.x - uv0.x;
-					float y1 = uv1.y - uv0.y, y2 = uv2.y - uv0.y;
-
-					const float r = 1.0f / (x1 * y2 - x2 * y1);
-					glm::vec3 tangent = (e1 * y2 - e2 * y1) * r;
-					glm::vec3 bitangent = (e2 * x1 - e1 * x2) * r;
-
-					//! In case of degenerated UV coordinates
-					if (x1 == 0 || x2 == 0 || y1 == 0 || y2 == 0)
+					//! Weights do not change the transforms, the node is not marked
+					const int firstTarget = track.targetIndices[lane];
+					const float values[4] = { x[lane], y[lane], z[lane], w[lane] };
+					float* weights = _morphWeights.data() + node.weightIndex + firstTarget;
+					for (int k = 0; k < std::min(4, node.weightCount - firstTarget); ++k)
 					{
-						const auto& nrm0 = _normals[gidx0];
-						const auto& nrm1 = _normals[gidx1];
-						const auto& nrm2 = _normals[gidx2];
-						const auto N = (nrm0 + nrm1 + nrm2) / glm::vec3(3.0f);
-
-						if (std::abs(N.x) > std::abs(N.y))
-							tangent = glm::vec3(N.z, 0, -N.x) / std::sqrt(N.x * N.x + N.z * N.z);
-						else
-							tangent = glm::vec3(0, -N.z, N.y) / std::sqrt(N.y * N.y + N.z * N.z);
-						bitangent = glm::cross(N, tangent);
+						sceneModified |= weights[k] != values[k];
+						weights[k] = values[k];
 					}
-
-					tangents[idx0] += tangent;
-					tangents[idx1] += tangent;
-					tangents[idx2] += tangent;
-					bitangents[idx0] += bitangent;
-					bitangents[idx1] += bitangent;
-					bitangents[idx2] += bitangent;
+					break;
+				}
 				}
 
-				for (unsigned int i = 0; i < resultMesh.vertexCount; ++i)
+				if (nodeModified)
 				{
-					const auto& n = _normals[resultMesh.vertexOffset + i];
-					const auto& t = tangents[i];
-					const auto& b = bitangents[i];
-
-					//! Gram schmidt orthogonalize
-					glm::vec3 tangent = glm::normalize(t - n * glm::vec3(glm::dot(n, t)));
-					//! Calculate the handedness
-					float handedness = (glm::dot(glm::cross(t, b), n) > 0.0f) ? 1.0f : -1.0f;
-					_tangents.emplace_back(tangent.x, tangent.y, tangent.z, handedness);
+					_dirtyNodes.push_back(track.nodeIndices[lane]);
+					sceneModified = true;
 				}
 			}
 		}
 
-		//! COLOR
-		if (static_cast<int>(format & VertexFormat::Color4))
+		UpdateNodeTransforms();
+		if (sceneModified)
+			UpdateJointPalettes();
+
+		return sceneModified;
+	}
+
+	void GLTFScene::ImportSkins(const tinygltf::Model& model)
+	{
+		for (const auto& skin : model.skins)
 		{
-			if (!GetAttributes(model, mesh, _colors, "COLOR_0"))
+			GLTFSkin newSkin;
+			newSkin.name = skin.name;
+			newSkin.jointIndex = static_cast<int>(_jointNodes.size());
+			newSkin.jointCount = static_cast<int>(skin.joints.size());
+
+			//! Joints out of the scene keep the bind pose
+			for (int joint : skin.joints)
+				_jointNodes.push_back(joint >= 0 && joint < static_cast<int>(_nodeRemap.size()) ? _nodeRemap[joint] : -1);
+
+			//! Identity matrices if the inverse bind matrices are not given
+			_inverseBindMatrices.resize(_jointNodes.size(), glm::mat4(1.0f));
+			if (skin.inverseBindMatrices > -1)
 			{
-				_colors.insert(_colors.end(), resultMesh.vertexCount, glm::vec4(1.0f));
+				const tinygltf::Accessor& accessor = model.accessors[skin.inverseBindMatrices];
+				if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT && accessor.type == TINYGLTF_TYPE_MAT4)
+				{
+					const std::size_t count = std::min(accessor.count, skin.joints.size());
+					std::memcpy(_inverseBindMatrices.data() + newSkin.jointIndex, GetAccessorData(model, accessor), count * sizeof(glm::mat4));
+				}
+				else
+				{
+					std::cerr << "[GLTFScene::ImportSkins] Unknown inverse bind matrices type : " << accessor.type << '\n';
+				}
 			}
-		}
 
-		_scenePrimMeshes.emplace_back(resultMesh);
+			_sceneSkins.emplace_back(std::move(newSkin));
+		}
 	}
 
-	bool GLTFScene::LoadModel(tinygltf::Model* model, const std::string& filename)
+	void GLTFScene::UpdateJointPalettes()
 	{
-		tinygltf::TinyGLTF loader;
-		std::string err, warn;
+		constexpr std::size_t kJointGrainSize = 1024;
 
-		bool res = loader.LoadBinaryFromFile(model, &err, &warn, filename);
-		if (!res)
-			res = loader.LoadASCIIFromFile(model, &err, &warn, filename);
+		_jointPalette.resize(_jointNodes.size());
+		ThreadPool::GetInstance().ParallelFor(_jointNodes.size(), kJointGrainSize, [this](std::size_t begin, std::size_t end) {
+			for (std::size_t j = begin; j < end; ++j)
+			{
+				const int nodeIndex = _jointNodes[j];
+				_jointPalette[j] = nodeIndex == -1 ? _inverseBindMatrices[j] : _nodeWorlds[nodeIndex] * _inverseBindMatrices[j];
+			}
+		});
+	}
 
-		if (!res)
-			std::cerr << "Failed to load GLTF model : " << filename << std::endl;
+	bool GLTFScene::SkinPrimitive(unsigned int primMeshIndex, int skinIndex, glm::vec3* positions, glm::vec3* normals) const
+	{
+		const auto sourcePositions = GetPositions(), sourceNormals = GetNormals();
+		const auto skinJoints = GetSkinJoints(), skinWeights = GetSkinWeights();
+		if (primMeshIndex >= _scenePrimMeshes.size() || skinIndex < 0 || skinIndex >= static_cast<int>(_sceneSkins.size()) ||
+			skinJoints.empty() || sourcePositions.empty())
+			return false;
 
-		return res;
+		const auto& primMesh = _scenePrimMeshes[primMeshIndex];
+		const auto& skin = _sceneSkins[skinIndex];
+		const std::size_t offset = primMesh.vertexOffset;
+		SkinVertices(positions, normals, sourcePositions.data() + offset, sourceNormals.empty() ? nullptr : sourceNormals.data() + offset,
+					 skinJoints.data() + offset, skinWeights.data() + offset, primMesh.vertexCount,
+					 _jointPalette.data() + skin.jointIndex, static_cast<std::size_t>(skin.jointCount));
+		return true;
 	}
 
-	void GLTFScene::ProcessNode(const tinygltf::Model& model, int nodeIdx, int parentIndex)
+	bool GLTFScene::MorphPrimitive(int nodeIndex, unsigned int primMeshIndex, glm::vec3* positions, glm::vec3* normals, glm::vec4* tangents) const
 	{
-		const auto& node = model.nodes[nodeIdx];
+		const auto sourcePositions = GetPositions(), sourceNormals = GetNormals();
+		const auto sourceTangents = GetTangents();
+		const auto morphDeltas = GetMorphDeltas();
+		if (nodeIndex < 0 || nodeIndex >= static_cast<int>(_sceneNodes.size()) || primMeshIndex >= _scenePrimMeshes.size() || sourcePositions.empty())
+			return false;
 
-		GLTFNode newNode;
-		//! Gets transformation info from the given node
-		if (node.translation.empty() == false)
-			newNode.translation = glm::vec3(node.translation[0], node.translation[1], node.translation[2]);
-		if (node.scale.empty() == false)
-			newNode.scale = glm::vec3(node.scale[0], node.scale[1], node.scale[2]);
-		if (node.rotation.empty() == false)
-			newNode.rotation = glm::quat(node.rotation[3], node.rotation[0], node.rotation[1], node.rotation[2]);
-		if (node.matrix.empty() == false)
+		const auto& node = _sceneNodes[nodeIndex];
+		if (std::find(node.primMeshes.begin(), node.primMeshes.end(), primMeshIndex) == node.primMeshes.end())
+			return false;
+
+		const auto& primMesh = _scenePrimMeshes[primMeshIndex];
+		const std::size_t offset = primMesh.vertexOffset;
+		std::copy(sourcePositions.begin() + offset, sourcePositions.begin() + offset + primMesh.vertexCount, positions);
+		if (normals != nullptr && !sourceNormals.empty())
+			std::copy(sourceNormals.begin() + offset, sourceNormals.begin() + offset + primMesh.vertexCount, normals);
+		if (tangents != nullptr && !sourceTangents.empty())
+			std::copy(sourceTangents.begin() + offset, sourceTangents.begin() + offset + primMesh.vertexCount, tangents);
+
+		//! Only the targets with a non-zero weight are blended, the sparse ranges touch their vertices only
+		auto blend = [&](const GLTFMorphRange& range, float weight, auto&& apply) {
+			const GLTFMorphDelta* deltas = morphDeltas.data() + range.offset;
+			for (int i = 0; i < range.count; ++i)
+				apply(deltas[i].vertex - offset, weight * deltas[i].delta);
+		};
+		const int numTargets = std::min(primMesh.morphTargetCount, node.weightCount);
+		for (int t = 0; t < numTargets; ++t)
 		{
-			float* nodeMatPtr = glm::value_ptr(newNode.local);
-			for (int i = 0; i < 16; ++i)
-				nodeMatPtr[i] = static_cast<float>(node.matrix[i]);
+			const float weight = _morphWeights[node.weightIndex + t];
+			if (weight == 0.0f)
+				continue;
+
+			const auto& target = _morphTargets[primMesh.morphTargetIndex + t];
+			blend(target.position, weight, [positions](std::size_t v, const glm::vec3& delta) { positions[v] += delta; });
+			if (normals != nullptr && !sourceNormals.empty())
+				blend(target.normal, weight, [normals](std::size_t v, const glm::vec3& delta) { normals[v] += delta; });
+			if (tangents != nullptr && !sourceTangents.empty())
+				blend(target.tangent, weight, [tangents](std::size_t v, const glm::vec3& delta) { tangents[v] += glm::vec4(delta, 0.0f); });
 		}
 
-		//! Calculate world matrix
-		glm::mat4 worldMat = (parentIndex != -1 ? _sceneNodes[parentIndex].world : glm::mat4(1.0f)) * GetLocalMatrix(newNode);
-
-		if (node.camera > -1)
+		//! The blended normals and tangents are normalized, the handedness of the tangents is kept
+		for (unsigned int v = 0; v < primMesh.vertexCount; ++v)
 		{
-			GLTFCamera camera;
-			camera.world = worldMat;
-			camera.camera = model.cameras[model.nodes[nodeIdx].camera];
+			if (normals != nullptr && !sourceNormals.empty())
+				normals[v] = glm::normalize(normals[v]);
+			if (tangents != nullptr && !sourceTangents.empty())
+				tangents[v] = glm::vec4(glm::normalize(glm::vec3(tangents[v])), tangents[v].w);
+		}
+		return true;
+	}
 
-			//! If the node has the Iray extension, extract the camera information
-			if (node.extensions.find("NV_attributes_iray") != node.extensions.end())
+	void GLTFScene::BuildAnimationTracks()
+	{
+		_sceneTracks.clear();
+		_animatedNodes.clear();
+		for (auto& sampler : _sceneSamplers)
+			sampler.packedWeights.clear();
+		for (auto& anim : _sceneAnims)
+		{
+			anim.trackIndex = static_cast<int>(_sceneTracks.size());
+			for (int ch = anim.channelIndex; ch < anim.channelCount + anim.channelIndex; ++ch)
 			{
-				auto& iray_ext = node.extensions.find("NV_attributes_iray")->second;
-				auto& attributes = iray_ext.Get("attributes");
-				for (size_t idx = 0; idx < attributes.ArrayLen(); ++idx)
+				const auto& channel = _sceneChannels[ch];
+				if (channel.samplerIndex < 0 || channel.samplerIndex >= static_cast<int>(_sceneSamplers.size()))
+					continue;
+				auto& sampler = _sceneSamplers[channel.samplerIndex];
+				const std::size_t numKeys = sampler.GetNumKeys();
+				if (numKeys == 0 || (sampler.packedKeys.empty() && sampler.outputs.size() < numKeys * sampler.GetKeyStride()))
+					continue;
+
+				//! Weights keys hold every morph target of the node, four targets are evaluated per lane
+				const auto& node = _sceneNodes[channel.nodeIndex];
+				if (channel.path == GLTFChannel::Path::Weights && !PackWeightsKeys(sampler, node.weightCount))
 				{
-					auto& attrib = attributes.Get(idx);
-					std::string attName = attrib.Get("name").Get<std::string>();
-					auto& attValue = attrib.Get("value");
-					if (attValue.IsArray())
+					std::cerr << "[GLTFScene::BuildAnimationTracks] Weights keys do not match the morph targets of the node : " << node.nodeIndex << std::endl;
+					continue;
+				}
+
+				AnimationTrack::Kernel kernel = AnimationTrack::Kernel::Lerp;
+				if (sampler.interpolation == GLTFSampler::Interpolation::Step)
+					kernel = AnimationTrack::Kernel::Step;
+				else if (sampler.interpolation == GLTFSampler::Interpolation::Cubicspline)
+					kernel = channel.path == GLTFChannel::Path::Rotation ? AnimationTrack::Kernel::NCubic : AnimationTrack::Kernel::Cubic;
+				else if (channel.path == GLTFChannel::Path::Rotation)
+				{
+					std::vector<glm::vec4> decodedKeys;
+					if (!sampler.packedKeys.empty())
 					{
-						auto vec = GetVector<float>(attValue);
-						if (attName == "ivew:position")
-							camera.eye = { vec[0], vec[1], vec[2] };
-						else if (attName == "iview:interest")
-							camera.center = { vec[0], vec[1], vec[2] };
-						else if (attName == "iview:up")
-							camera.up = { vec[0], vec[1], vec[2] };
+						AnimationTrack::PackedKeys keys = sampler.packedEncoding;
+						keys.keys = sampler.packedKeys.data();
+						decodedKeys.resize(numKeys);
+						for (std::size_t i = 0; i < numKeys; ++i)
+							decodedKeys[i] = AnimationTrack::DecodeKey(keys, i);
 					}
+					const glm::vec4* keys = decodedKeys.empty() ? sampler.outputs.data() : decodedKeys.data();
+					kernel = AnimationTrack::IsNLerpExact(keys, numKeys) ? AnimationTrack::Kernel::NLerp : AnimationTrack::Kernel::SLerp;
+				}
+
+				auto track = std::find_if(_sceneTracks.begin() + anim.trackIndex, _sceneTracks.end(), [&](const GLTFTrack& track) {
+					return track.path == channel.path && track.lanes.GetKernel() == kernel;
+				});
+				if (track == _sceneTracks.end())
+				{
+					GLTFTrack newTrack;
+					newTrack.path = channel.path;
+					newTrack.lanes = AnimationTrack(kernel);
+					track = _sceneTracks.emplace(_sceneTracks.end(), std::move(newTrack));
+				}
+				const int numTargets = channel.path == GLTFChannel::Path::Weights ? node.weightCount : 0;
+				const int numLanes = AddSamplerLanes(track->lanes, sampler, numTargets);
+				for (int lane = 0; lane < numLanes; ++lane)
+				{
+					track->nodeIndices.push_back(channel.nodeIndex);
+					track->targetIndices.push_back(lane * 4);
 				}
 			}
+			anim.trackCount = static_cast<int>(_sceneTracks.size()) - anim.trackIndex;
 
-			_sceneCameras.emplace_back(camera);
+			//! Paths of each node merged from the lanes of every track of the clip
+			std::vector<GLTFAnimatedNode> animatedNodes;
+			for (int t = anim.trackIndex; t < anim.trackCount + anim.trackIndex; ++t)
+			{
+				for (int nodeIndex : _sceneTracks[t].nodeIndices)
+					animatedNodes.push_back({ nodeIndex, 1u << static_cast<unsigned int>(_sceneTracks[t].path) });
+			}
+			std::sort(animatedNodes.begin(), animatedNodes.end(), [](const GLTFAnimatedNode& lhs, const GLTFAnimatedNode& rhs) {
+				return lhs.nodeIndex < rhs.nodeIndex;
+			});
+			anim.animatedNodeIndex = static_cast<int>(_animatedNodes.size());
+			for (const auto& animatedNode : animatedNodes)
+			{
+				if (static_cast<int>(_animatedNodes.size()) > anim.animatedNodeIndex && _animatedNodes.back().nodeIndex == animatedNode.nodeIndex)
+					_animatedNodes.back().paths |= animatedNode.paths;
+				else
+					_animatedNodes.push_back(animatedNode);
+			}
+			anim.animatedNodeCount = static_cast<int>(_animatedNodes.size()) - anim.animatedNodeIndex;
+
+			const auto firstNode = _animatedNodes.begin() + anim.animatedNodeIndex;
+			for (int t = anim.trackIndex; t < anim.trackCount + anim.trackIndex; ++t)
+			{
+				auto& track = _sceneTracks[t];
+				track.poseIndices.resize(track.nodeIndices.size());
+				for (std::size_t lane = 0; lane < track.nodeIndices.size(); ++lane)
+				{
+					const auto entry = std::lower_bound(firstNode, _animatedNodes.end(), track.nodeIndices[lane], [](const GLTFAnimatedNode& animatedNode, int nodeIndex) {
+						return animatedNode.nodeIndex < nodeIndex;
+					});
+					track.poseIndices[lane] = static_cast<int>(entry - firstNode);
+				}
+			}
 		}
-		else if (node.extensions.find(KHR_LIGHTS_PUNCTUAL_EXTENSION_NAME) != node.extensions.end())
+
+		//! Captured before the first update, the missing rotation is the zero quaternion which acts as the identity
+		if (_restPose.translations.size() != _sceneNodes.size())
 		{
-			GLTFLight light;
-			const auto& ext = node.extensions.find(KHR_LIGHTS_PUNCTUAL_EXTENSION_NAME)->second;
-			auto lightIdx = ext.Get("light").GetNumberAsInt();
-			light.light = model.lights[lightIdx];
-			light.world = worldMat;
-			_sceneLights.emplace_back(light);
+			_restPose.translations.resize(_sceneNodes.size());
+			_restPose.rotations.resize(_sceneNodes.size());
+			_restPose.scales.resize(_sceneNodes.size());
+			for (std::size_t i = 0; i < _sceneNodes.size(); ++i)
+			{
+				const auto& node = _sceneNodes[i];
+				const glm::quat rotation = node.rotation == glm::quat(0.0f, 0.0f, 0.0f, 0.0f) ? glm::quat(1.0f, 0.0f, 0.0f, 0.0f) : node.rotation;
+				_restPose.translations[i] = glm::vec4(node.translation, 0.0f);
+				_restPose.rotations[i] = glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w);
+				_restPose.scales[i] = glm::vec4(node.scale, 0.0f);
+			}
+			_restPose.weights = _morphWeights;
 		}
-		else
+
+		//! First frame of every clip for the additive layers
+		_referencePoses.assign(_sceneAnims.size(), GLTFPose());
+		for (std::size_t a = 0; a < _sceneAnims.size(); ++a)
 		{
-			if (node.mesh > -1)
-				newNode.primMeshes = std::move(_meshToPrimMap[node.mesh]);
+			const auto& anim = _sceneAnims[a];
+			ResizePose(anim, &_referencePoses[a]);
+			for (int t = anim.trackIndex; t < anim.trackCount + anim.trackIndex; ++t)
+			{
+				_sceneTracks[t].lanes.Evaluate(0.0f);
+				ScatterTrack(_sceneTracks[t], &_referencePoses[a]);
+			}
+		}
+	}
 
-			newNode.world = std::move(worldMat);
-			newNode.nodeIndex = nodeIdx;
-			newNode.parentNode = parentIndex;
+	bool GLTFScene::PackWeightsKeys(GLTFSampler& sampler, int numTargets)
+	{
+		//! Every key holds the weights of all targets, cubic spline keys are the in-tangents, the values and the out-tangents
+		const std::size_t numKeys = sampler.GetNumKeys();
+		const std::size_t stride = sampler.GetKeyStride();
+		if (numTargets <= 0 || sampler.outputs.size() < numKeys * numTargets * stride)
+			return false;
 
-			//! Push newnode to both linear scene node array and parent child array
-			const int newNodeIndex = static_cast<int>(_sceneNodes.size());
-			_sceneNodes.emplace_back(std::move(newNode));
-			if (parentIndex != -1)
-				_sceneNodes[parentIndex].childNodes.push_back(newNodeIndex);
+		//! Already packed for the other channel of the sampler, whose lanes reference the keys
+		const std::size_t numLanes = (static_cast<std::size_t>(numTargets) + 3) / 4;
+		const std::size_t laneSize = numKeys * stride;
+		if (!sampler.packedWeights.empty())
+			return sampler.packedWeights.size() == numLanes * laneSize;
 
-			//! Call ProcessNode recursively to the childs of this newNode
-			for (auto child : node.children)
-				ProcessNode(model, child, newNodeIndex);
+		sampler.packedWeights.assign(numLanes * laneSize, glm::vec4(0.0f));
+		for (std::size_t i = 0; i < laneSize; ++i)
+		{
+			const glm::vec4* values = sampler.outputs.data() + i * numTargets;
+			for (int t = 0; t < numTargets; ++t)
+				sampler.packedWeights[t / 4 * laneSize + i][t % 4] = values[t].x;
 		}
+		return true;
 	}
 
-	void GLTFScene::UpdateNode(int nodeIndex)	
+	int GLTFScene::AddSamplerLanes(AnimationTrack& track, const GLTFSampler& sampler, int numTargets)
 	{
-		auto& node = _sceneNodes[nodeIndex];
-		if (!node.primMeshes.empty())
+		//! Lanes of the weights sample the packed keys of four targets each
+		const std::size_t numKeys = sampler.GetNumKeys();
+		const int numLanes = numTargets > 0 ? (numTargets + 3) / 4 : 1;
+		for (int lane = 0; lane < numLanes; ++lane)
 		{
-			node.world = GetLocalMatrix(node);
-			int parentNode = node.parentNode;
-			while (parentNode != -1)
+			const glm::vec4* values = numTargets > 0 ? sampler.packedWeights.data() + lane * numKeys * sampler.GetKeyStride() : sampler.outputs.data();
+			if (!sampler.packedKeys.empty())
 			{
-				node.world = GetLocalMatrix(_sceneNodes[parentNode]) * node.world;
-				parentNode = _sceneNodes[parentNode].parentNode;
+				AnimationTrack::PackedKeys keys = sampler.packedEncoding;
+				keys.keys = sampler.packedKeys.data();
+				track.AddLane(sampler.sampleRate, keys, numKeys);
 			}
+			else if (sampler.sampleRate > 0.0f)
+				track.AddLane(sampler.sampleRate, values, numKeys);
+			else
+				track.AddLane(sampler.inputs.data(), values, numKeys);
 		}
+		return numLanes;
+	}
 
-		for (int child : node.childNodes)
-			UpdateNode(child);
+	bool GLTFScene::GetSamplerTarget(const GLTFAnimation& anim, int samplerIndex, GLTFChannel::Path* path, int* numTargets) const
+	{
+		int numChannels = 0;
+		for (int ch = anim.channelIndex; ch < anim.channelIndex + anim.channelCount; ++ch)
+		{
+			const auto& channel = _sceneChannels[ch];
+			if (channel.samplerIndex != samplerIndex)
+				continue;
+			const int targets = channel.path == GLTFChannel::Path::Weights ? _sceneNodes[channel.nodeIndex].weightCount : 0;
+			if (numChannels++ > 0 && (*path != channel.path || *numTargets != targets))
+				return false;
+			*path = channel.path;
+			*numTargets = targets;
+		}
+		return numChannels > 0;
 	}
 
-	bool GLTFScene::UpdateAnimation(int animIndex, float timeElapsed)
+	namespace
 	{
-		//! There is no animation corresponded to given index, therefore return.
-		if (_sceneAnims.size() <= animIndex)
-			return false;
+		//! Tolerance of the last key time against the sample grid, avoids a nearly duplicated last key
+		constexpr float kBakeTimeEpsilon = 1e-4f;
+		constexpr float kVector48Steps = 65535.0f;
+	};
 
-		bool sceneModified = false;
-		const auto& anim = _sceneAnims[animIndex];
+	void GLTFScene::BakeAnimations(const GLTFLoadOptions& options)
+	{
+		const float rate = options.animationSampleRate;
+		if (rate <= 0.0f)
+			return;
 
-		//! Get maximum interval from scene samplers
-		//! TODO(snowapril) : this can be precalculated
-		float maxAnimInterval = 0.0f;
-		for (int s = anim.samplerIndex; s < anim.samplerIndex + anim.samplerCount; ++s)
-			maxAnimInterval = std::max(maxAnimInterval, _sceneSamplers[s].inputs.back());
-		//! Calculate timeElapsed modulo max interval
-		const float elapsed = std::fmod(timeElapsed, maxAnimInterval);
+		const auto GetSamplerSize = [](const GLTFSampler& sampler) {
+			return sampler.inputs.size() * sizeof(float) + sampler.outputs.size() * sizeof(glm::vec4) + sampler.packedKeys.size() * sizeof(glm::u16vec3);
+		};
 
-		for (int ch = anim.channelIndex; ch < anim.channelCount + anim.channelIndex; ++ch)
+		//! Outcome of each sampler, which are baked independently
+		enum class BakeResult
 		{
-			const auto& channel = _sceneChannels[ch];
-			const auto& sampler = _sceneSamplers[channel.samplerIndex];
-			auto& node = _sceneNodes[channel.nodeIndex];
-
-			for (size_t i = 0; i < sampler.inputs.size() - 1; ++i)
-			{
-				if (sampler.inputs[i] <= elapsed && elapsed < sampler.inputs[i + 1])
+			Kept = 0,
+			Baked = 1,
+			Packed = 2
+		};
+		std::vector<BakeResult> results;
+		std::vector<float> errors;
+		for (const auto& anim : _sceneAnims)
+		{
+			std::size_t bytesBefore = 0;
+			for (int s = anim.samplerIndex; s < anim.samplerIndex + anim.samplerCount; ++s)
+				bytesBefore += GetSamplerSize(_sceneSamplers[s]);
+
+			results.assign(anim.samplerCount, BakeResult::Kept);
+			errors.assign(anim.samplerCount, 0.0f);
+			ThreadPool::GetInstance().ParallelFor(anim.samplerCount, 1, [&](std::size_t begin, std::size_t end) {
+				for (std::size_t i = begin; i < end; ++i)
 				{
-					const float keyframe = std::max(0.0f, (elapsed - sampler.inputs[i]) / (sampler.inputs[i + 1] - sampler.inputs[i]));
-					if (keyframe <= 1.0f)
+					const int s = anim.samplerIndex + static_cast<int>(i);
+					auto& sampler = _sceneSamplers[s];
+
+					//! Step keys are kept as they are, the cubic splines are baked into linear keys
+					GLTFChannel::Path path;
+					int numTargets;
+					GLTFSampler source = sampler;
+					if (!GetSamplerTarget(anim, s, &path, &numTargets) || sampler.interpolation == GLTFSampler::Interpolation::Step || sampler.sampleRate > 0.0f ||
+						sampler.inputs.empty() || sampler.outputs.size() < sampler.inputs.size() * sampler.GetKeyStride() ||
+						(numTargets > 0 && !PackWeightsKeys(source, numTargets)))
+						continue;
+
+					//! The source curves are the reference of the baked keys and of the errors
+					const bool isRotation = path == GLTFChannel::Path::Rotation;
+					const bool isCubic = sampler.interpolation == GLTFSampler::Interpolation::Cubicspline;
+					const AnimationTrack::Kernel referenceKernel = isCubic ? (isRotation ? AnimationTrack::Kernel::NCubic : AnimationTrack::Kernel::Cubic)
+																		   : (isRotation ? AnimationTrack::Kernel::SLerp : AnimationTrack::Kernel::Lerp);
+					const AnimationTrack::Kernel kernel = isRotation ? AnimationTrack::Kernel::SLerp : AnimationTrack::Kernel::Lerp;
+					AnimationTrack reference(referenceKernel);
+					const int numLanes = AddSamplerLanes(reference, source, numTargets);
+
+					//! Keys from time zero up to the last key, the keys before the first one hold its value
+					const std::size_t numKeys = static_cast<std::size_t>(std::ceil(std::max(sampler.inputs.back() * rate - kBakeTimeEpsilon, 0.0f))) + 1;
+					GLTFSampler baked;
+					baked.sampleRate = rate;
+					baked.numBakedKeys = numKeys;
+					baked.outputs.assign(numKeys * std::max(numTargets, 1), glm::vec4(0.0f));
+					for (std::size_t k = 0; k < numKeys; ++k)
+					{
+						reference.Evaluate(static_cast<float>(k) / rate);
+						for (int lane = 0; lane < numLanes; ++lane)
+						{
+							glm::vec4 value;
+							for (int c = 0; c < 4; ++c)
+								value[c] = reference.GetResults(c)[lane];
+							if (numTargets == 0)
+								baked.outputs[k] = value;
+							for (int c = 0; c < 4 && lane * 4 + c < numTargets; ++c)
+								baked.outputs[k * numTargets + lane * 4 + c].x = value[c];
+						}
+					}
+
+					//! Translations and scales are quantized in the range of the sampler, the weights are kept in floats
+					GLTFSampler packed;
+					if (options.compressAnimations && numTargets == 0)
 					{
-						switch (channel.path)
+						packed.sampleRate = rate;
+						packed.numBakedKeys = numKeys;
+						packed.packedKeys.resize(numKeys);
+						packed.packedEncoding.encoding = isRotation ? AnimationTrack::KeyEncoding::Quaternion48 : AnimationTrack::KeyEncoding::Vector48;
+						glm::vec3 lower(std::numeric_limits<float>::max()), upper(std::numeric_limits<float>::lowest());
+						for (const auto& value : baked.outputs)
+						{
+							lower = glm::min(lower, glm::vec3(value));
+							upper = glm::max(upper, glm::vec3(value));
+						}
+						if (!isRotation)
+						{
+							packed.packedEncoding.offset = lower;
+							packed.packedEncoding.scale = (upper - lower) / kVector48Steps;
+						}
+						for (std::size_t k = 0; k < numKeys; ++k)
+						{
+							if (isRotation)
+							{
+								packed.packedKeys[k] = EncodeSmallestThree(glm::normalize(baked.outputs[k]));
+								continue;
+							}
+							const glm::vec3 range = upper - lower;
+							for (int c = 0; c < 3; ++c)
+							{
+								const float unit = range[c] > 0.0f ? (baked.outputs[k][c] - lower[c]) / range[c] : 0.0f;
+								packed.packedKeys[k][c] = static_cast<uint16_t>(glm::clamp(unit * kVector48Steps + 0.5f, 0.0f, kVector48Steps));
+							}
+						}
+					}
+
+					//! Largest component error against the source curves at the source keys, the baked keys and between them
+					const int numComponents = isRotation ? 4 : 3;
+					const auto MeasureError = [&](GLTFSampler& candidate) {
+						if (numTargets > 0 && !PackWeightsKeys(candidate, numTargets))
+							return std::numeric_limits<float>::max();
+						AnimationTrack track(kernel);
+						AddSamplerLanes(track, candidate, numTargets);
+						float error = 0.0f;
+						const auto Compare = [&](float time) {
+							reference.Evaluate(time);
+							track.Evaluate(time);
+							for (int lane = 0; lane < numLanes; ++lane)
+							{
+								glm::vec4 expected, result;
+								for (int c = 0; c < 4; ++c)
+								{
+									expected[c] = reference.GetResults(c)[lane];
+									result[c] = track.GetResults(c)[lane];
+								}
+								//! q and -q are the same rotation
+								if (isRotation && glm::dot(expected, result) < 0.0f)
+									result = -result;
+								const int count = numTargets > 0 ? std::min(4, numTargets - lane * 4) : numComponents;
+								for (int c = 0; c < count; ++c)
+									error = std::max(error, std::abs(expected[c] - result[c]));
+							}
+						};
+						for (const float time : sampler.inputs)
+							Compare(time);
+						for (std::size_t k = 0; k < numKeys; ++k)
 						{
-						case GLTFChannel::Path::Translation:
-							node.translation = Interpolation::Lerp(sampler.outputs[i], sampler.outputs[i + 1], keyframe);
-							break;
-						case GLTFChannel::Path::Rotation:
-							node.rotation = glm::normalize(Interpolation::SLerp(
-								glm::quat(sampler.outputs[i].w, sampler.outputs[i].x, sampler.outputs[i].y, sampler.outputs[i].z),
-								glm::quat(sampler.outputs[i + 1].w, sampler.outputs[i + 1].x, sampler.outputs[i + 1].y, sampler.outputs[i + 1].z),
-								keyframe));
-							break;
-						case GLTFChannel::Path::Scale:
-							node.scale = Interpolation::Lerp(sampler.outputs[i], sampler.outputs[i + 1], keyframe);
-							break;
-						case GLTFChannel::Path::Weights:
-							std::cerr << "[GLTFScene::UpdateAnimation] Weights not implemented yet" << std::endl;
-							return false;
-							break;
+							Compare(static_cast<float>(k) / rate);
+							Compare((static_cast<float>(k) + 0.5f) / rate);
 						}
+						return error;
+					};
 
-						sceneModified = true;
+					const float packedError = packed.packedKeys.empty() ? std::numeric_limits<float>::max() : MeasureError(packed);
+					const float bakedError = MeasureError(baked);
+					if (packedError <= options.animationErrorBound)
+					{
+						sampler = std::move(packed);
+						results[i] = BakeResult::Packed;
+						errors[i] = packedError;
+					}
+					else if (bakedError <= options.animationErrorBound)
+					{
+						sampler = std::move(baked);
+						results[i] = BakeResult::Baked;
+						errors[i] = bakedError;
 					}
 				}
+			});
+
+			std::size_t numBaked = 0, numPacked = 0, numKept = 0, bytesAfter = 0;
+			for (int s = anim.samplerIndex; s < anim.samplerIndex + anim.samplerCount; ++s)
+				bytesAfter += GetSamplerSize(_sceneSamplers[s]);
+			for (const BakeResult result : results)
+			{
+				numBaked += result == BakeResult::Baked ? 1 : 0;
+				numPacked += result == BakeResult::Packed ? 1 : 0;
+				numKept += result == BakeResult::Kept ? 1 : 0;
 			}
+			const float maxError = errors.empty() ? 0.0f : *std::max_element(errors.begin(), errors.end());
+			std::clog << "[GLTFScene::BakeAnimations] " << anim.name << " : " << numBaked << " baked, " << numPacked << " packed, "
+					  << numKept << " kept samplers, " << bytesBefore << " -> " << bytesAfter << " bytes, max error : " << maxError << std::endl;
 		}
+	}
 
-		if (sceneModified)
+	namespace
+	{
+		//! Hermite tangents of one segment of the fitted spline and its largest error against the linear keys
+		struct SegmentFit
+		{
+			glm::vec4 outTangent{ 0.0f };
+			glm::vec4 inTangent{ 0.0f };
+			float error{ 0.0f };
+			std::size_t worstKey{ 0 };
+		};
+
+		//! Least squares tangents of the segment [first, last] through its end keys, the keys between them and
+		//! the midpoints of the linear intervals are the samples. The segment of two keys becomes their line.
+		SegmentFit FitSegment(const std::vector<float>& times, const std::vector<glm::vec4>& values, std::size_t first, std::size_t last, bool isRotation)
 		{
-			for (int i = 0; i < _sceneNodes.size(); ++i)
-				UpdateNode(i);
+			SegmentFit fit;
+			const float interval = times[last] - times[first];
+			const glm::vec4 slope = interval > 0.0f ? (values[last] - values[first]) / interval : glm::vec4(0.0f);
+			fit.outTangent = fit.inTangent = slope;
+
+			if (last - first > 1 && interval > 0.0f)
+			{
+				//! Normal equations of the two tangents, scaled by the interval, for every component at once
+				float a11 = 0.0f, a12 = 0.0f, a22 = 0.0f;
+				glm::vec4 b1(0.0f), b2(0.0f);
+				for (std::size_t j = first + 1; j < last; ++j)
+				{
+					const float t = (times[j] - times[first]) / interval;
+					const float t2 = t * t, t3 = t2 * t;
+					const float h10 = t3 - 2.0f * t2 + t, h11 = t3 - t2;
+					const glm::vec4 residual = values[j] - (2.0f * t3 - 3.0f * t2 + 1.0f) * values[first] - (-2.0f * t3 + 3.0f * t2) * values[last];
+					a11 += h10 * h10;
+					a12 += h10 * h11;
+					a22 += h11 * h11;
+					b1 += h10 * residual;
+					b2 += h11 * residual;
+				}
+				const float determinant = a11 * a22 - a12 * a12;
+				if (std::abs(determinant) > std::numeric_limits<float>::epsilon() * a11 * a22)
+				{
+					fit.outTangent = (a22 * b1 - a12 * b2) / (determinant * interval);
+					fit.inTangent = (a11 * b2 - a12 * b1) / (determinant * interval);
+				}
+			}
+
+			//! q and -q are the same rotation, the keys are aligned beforehand
+			const int numComponents = isRotation ? 4 : 3;
+			const auto Measure = [&](float time, const glm::vec4& expected, std::size_t key) {
+				glm::vec4 result = Interpolation::CubicSpline(values[first], fit.outTangent, fit.inTangent, values[last], (time - times[first]) / interval, interval);
+				if (isRotation)
+					result = glm::normalize(result);
+				for (int c = 0; c < numComponents; ++c)
+				{
+					const float error = std::abs(result[c] - expected[c]);
+					if (error > fit.error)
+					{
+						fit.error = error;
+						fit.worstKey = key;
+					}
+				}
+			};
+			if (interval <= 0.0f)
+				return fit;
+			for (std::size_t j = first; j < last; ++j)
+			{
+				const glm::vec4 midpoint = isRotation ? Interpolation::SLerp(values[j], values[j + 1], 0.5f) : Interpolation::Lerp(values[j], values[j + 1], 0.5f);
+				Measure(times[j], values[j], j);
+				Measure((times[j] + times[j + 1]) * 0.5f, midpoint, j + 1 < last ? j + 1 : j);
+			}
+			return fit;
 		}
+	};
 
-		return sceneModified;
+	void GLTFScene::ReduceKeyframes(float errorBound)
+	{
+		const auto GetSamplerSize = [](const GLTFSampler& sampler) {
+			return sampler.inputs.size() * sizeof(float) + sampler.outputs.size() * sizeof(glm::vec4);
+		};
+
+		std::vector<float> errors;
+		for (const auto& anim : _sceneAnims)
+		{
+			std::size_t numKeysBefore = 0, bytesBefore = 0;
+			for (int s = anim.samplerIndex; s < anim.samplerIndex + anim.samplerCount; ++s)
+			{
+				numKeysBefore += _sceneSamplers[s].GetNumKeys();
+				bytesBefore += GetSamplerSize(_sceneSamplers[s]);
+			}
+
+			errors.assign(anim.samplerCount, -1.0f);
+			ThreadPool::GetInstance().ParallelFor(anim.samplerCount, 1, [&](std::size_t begin, std::size_t end) {
+				for (std::size_t i = begin; i < end; ++i)
+				{
+					//! Only the linear translations, rotations and scales are fitted, the weights are kept
+					const int s = anim.samplerIndex + static_cast<int>(i);
+					auto& sampler = _sceneSamplers[s];
+					GLTFChannel::Path path;
+					int numTargets;
+					if (!GetSamplerTarget(anim, s, &path, &numTargets) || numTargets > 0 || sampler.interpolation != GLTFSampler::Interpolation::Linear ||
+						sampler.sampleRate > 0.0f || sampler.inputs.size() < 3 || sampler.outputs.size() < sampler.inputs.size())
+						continue;
+
+					//! Consecutive quaternions on the same hemisphere, so that the spline does not cross the origin
+					const bool isRotation = path == GLTFChannel::Path::Rotation;
+					const std::vector<float>& times = sampler.inputs;
+					std::vector<glm::vec4> values(sampler.outputs.begin(), sampler.outputs.begin() + times.size());
+					for (std::size_t k = 1; isRotation && k < values.size(); ++k)
+						values[k] = glm::dot(values[k - 1], values[k]) < 0.0f ? -values[k] : values[k];
+
+					//! Split the segments at their worst key until every segment is within the bound
+					std::vector<SegmentFit> fits(times.size());
+					std::vector<bool> isKept(times.size(), false);
+					std::vector<std::pair<std::size_t, std::size_t>> segments{ { 0, times.size() - 1 } };
+					isKept.front() = isKept.back() = true;
+					float maxError = 0.0f;
+					while (!segments.empty())
+					{
+						const auto segment = segments.back();
+						segments.pop_back();
+						const SegmentFit fit = FitSegment(times, values, segment.first, segment.second, isRotation);
+						if (fit.error > errorBound && segment.second - segment.first > 1)
+						{
+							const std::size_t split = std::min(std::max(fit.worstKey, segment.first + 1), segment.second - 1);
+							isKept[split] = true;
+							segments.emplace_back(segment.first, split);
+							segments.emplace_back(split, segment.second);
+							continue;
+						}
+						fits[segment.first] = fit;
+						maxError = std::max(maxError, fit.error);
+					}
+
+					//! The fitted keys are the in-tangent, value and out-tangent triplets, kept only if they are within
+					//! the bound and smaller than the linear keys
+					const std::size_t numKeys = static_cast<std::size_t>(std::count(isKept.begin(), isKept.end(), true));
+					if (maxError > errorBound || numKeys * (sizeof(float) + 3 * sizeof(glm::vec4)) >= times.size() * (sizeof(float) + sizeof(glm::vec4)))
+						continue;
+
+					GLTFSampler reduced;
+					reduced.interpolation = GLTFSampler::Interpolation::Cubicspline;
+					reduced.inputs.reserve(numKeys);
+					reduced.outputs.reserve(numKeys * 3);
+					glm::vec4 inTangent(0.0f);
+					for (std::size_t k = 0; k < times.size(); ++k)
+					{
+						if (!isKept[k])
+							continue;
+						const bool isLast = k + 1 == times.size();
+						reduced.inputs.push_back(times[k]);
+						reduced.outputs.push_back(inTangent);
+						reduced.outputs.push_back(values[k]);
+						reduced.outputs.push_back(isLast ? glm::vec4(0.0f) : fits[k].outTangent);
+						inTangent = fits[k].inTangent;
+					}
+					sampler = std::move(reduced);
+					errors[i] = maxError;
+				}
+			});
+
+			std::size_t numReduced = 0, numKeysAfter = 0, bytesAfter = 0;
+			float maxError = 0.0f;
+			for (int s = anim.samplerIndex; s < anim.samplerIndex + anim.samplerCount; ++s)
+			{
+				numKeysAfter += _sceneSamplers[s].GetNumKeys();
+				bytesAfter += GetSamplerSize(_sceneSamplers[s]);
+			}
+			for (const float error : errors)
+			{
+				numReduced += error >= 0.0f ? 1 : 0;
+				maxError = std::max(maxError, error);
+			}
+
+			std::clog << "[GLTFScene::ReduceKeyframes] " << anim.name << " : " << numReduced << " of " << anim.samplerCount << " samplers reduced, "
+					  << numKeysBefore << " -> " << numKeysAfter << " keys, " << bytesBefore << " -> " << bytesAfter << " bytes, max error : " << maxError << std::endl;
+		}
 	}
 
 	void GLTFScene::ProcessAnimation(const tinygltf::Model& model, const tinygltf::Animation& anim, std::size_t channelOffset, std::size_t samplerOffset)
@@ -602,27 +2207,40 @@ namespace Core {
 		GLTFAnimation animation;
 		animation.name = anim.name;
 		animation.channelIndex = channelOffset;
-		animation.channelCount = static_cast<int>(anim.channels.size());
 		animation.samplerIndex = samplerOffset;
 		animation.samplerCount = static_cast<int>(anim.samplers.size());
 
 		for (const auto& channel : anim.channels)
-			ProcessChannel(model, channel);
+			ProcessChannel(model, channel, samplerOffset);
+		//! Unsupported channels are skipped
+		animation.channelCount = static_cast<int>(_sceneChannels.size() - channelOffset);
 
 		for (const auto& sampler : anim.samplers)
 			ProcessSampler(model, sampler);
 
+		//! Precalculate the clip duration instead of scanning the samplers every update
+		for (std::size_t s = samplerOffset; s < _sceneSamplers.size(); ++s)
+		{
+			if (!_sceneSamplers[s].inputs.empty())
+				animation.duration = std::max(animation.duration, _sceneSamplers[s].inputs.back());
+		}
+
 		_sceneAnims.emplace_back(std::move(animation));
 	}
 
-	void GLTFScene::ProcessChannel(const tinygltf::Model& model, const tinygltf::AnimationChannel& channel)
+	void GLTFScene::ProcessChannel(const tinygltf::Model& model, const tinygltf::AnimationChannel& channel, std::size_t samplerOffset)
 	{
 		GLTFChannel newChannel;
-		newChannel.samplerIndex = channel.sampler;
+		//! Sampler index of the channel is local to its animation
+		newChannel.samplerIndex = static_cast<int>(samplerOffset) + channel.sampler;
 		//! Remapping gltf::channel::node_index to our node index
-		for (int i = 0; i < static_cast<int>(_sceneNodes.size()); ++i)
-			if (_sceneNodes[i].nodeIndex == channel.target_node)
-				newChannel.nodeIndex = i;
+		if (channel.target_node < 0 || channel.target_node >= static_cast<int>(_nodeRemap.size()) || _nodeRemap[channel.target_node] == -1)
+		{
+			//! Cameras, lights and the nodes out of the default scene are not animated
+			std::cerr << "[GLTFScene::ProcessAnimation] Channel target is not a scene node : " << channel.target_node << '\n';
+			return;
+		}
+		newChannel.nodeIndex = _nodeRemap[channel.target_node];
 		//! Assign matched channel path by comparing target_path string
 		if (channel.target_path == "translation")
 			newChannel.path = GLTFChannel::Path::Translation;
@@ -662,12 +2280,10 @@ namespace Core {
 		//! Process sampler inputs
 		{
 			const tinygltf::Accessor& accessor = model.accessors[sampler.input];
-			const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
-			const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
 
 			assert(accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT);
 
-			const void* dataPtr = &buffer.data[accessor.byteOffset + bufferView.byteOffset];
+			const void* dataPtr = GetAccessorData(model, accessor);
 
 			const float* buf = static_cast<const float*>(dataPtr);
 			for (size_t i = 0; i < accessor.count; ++i)
@@ -677,12 +2293,10 @@ namespace Core {
 		//! Process sampler outputs
 		{
 			const tinygltf::Accessor& accessor = model.accessors[sampler.output];
-			const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
-			const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
 
 			assert(accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT);
 
-			const void* dataPtr = &buffer.data[accessor.byteOffset + bufferView.byteOffset];
+			const void* dataPtr = GetAccessorData(model, accessor);
 
 			if (accessor.type == TINYGLTF_TYPE_SCALAR)
 			{
@@ -715,31 +2329,39 @@ namespace Core {
 
 	glm::mat4 GLTFScene::GetLocalMatrix(const GLTFNode& node)
 	{
-		return glm::translate(glm::mat4(1.0f), node.translation) * 
-			   glm::toMat4(node.rotation) *
-			   glm::scale(glm::mat4(1.0f), node.scale) *
-			   node.local;
+		//! T * R * S without the full matrix products
+		glm::mat4 trs = glm::toMat4(node.rotation);
+		trs[0] *= node.scale.x;
+		trs[1] *= node.scale.y;
+		trs[2] *= node.scale.z;
+		trs[3] = glm::vec4(node.translation, 1.0f);
+		return trs * node.local;
 	}
 
 	void GLTFScene::CalculateSceneDimension()
 	{
 		auto bbMin = glm::vec3(std::numeric_limits<float>::max());
-		auto bbMax = glm::vec3(std::numeric_limits<float>::min());
-		for (const auto& node : _sceneNodes)
+		auto bbMax = glm::vec3(std::numeric_limits<float>::lowest());
+		for (std::size_t i = 0; i < _sceneNodes.size(); ++i)
 		{
-			for (unsigned int meshIdx : node.primMeshes)
+			for (unsigned int meshIdx : _sceneNodes[i].primMeshes)
 			{
 				const auto& mesh = _scenePrimMeshes[meshIdx];
 
-				auto localMin = node.world * glm::vec4(mesh.min, 1.0f);
-				auto localMax = node.world * glm::vec4(mesh.max, 1.0f);
-
-				bbMin = { std::min(bbMin.x, localMin.x), std::min(bbMin.z, localMin.z), std::min(bbMin.z, localMin.z) };
-				bbMax = { std::max(bbMax.x, localMax.x), std::max(bbMax.z, localMax.z), std::max(bbMax.z, localMax.z) };
+				//! Rotated boxes reach past the transformed min and max, every corner is transformed
+				for (int corner = 0; corner < 8; ++corner)
+				{
+					const glm::vec3 local((corner & 1) ? mesh.max.x : mesh.min.x,
+										  (corner & 2) ? mesh.max.y : mesh.min.y,
+										  (corner & 4) ? mesh.max.z : mesh.min.z);
+					const glm::vec3 world(_nodeWorlds[i] * glm::vec4(local, 1.0f));
+					bbMin = glm::min(bbMin, world);
+					bbMax = glm::max(bbMax, world);
+				}
 			}
 		}
 
-		if (bbMin == bbMax)
+		if (bbMin.x > bbMax.x || bbMin == bbMax)
 		{
 			bbMin = glm::vec3(-1.0f);
 			bbMax = glm::vec3(1.0f);
@@ -864,11 +2486,83 @@ namespace Core {
 
 	void GLTFScene::ReleaseSourceData()
 	{
-		_positions.clear();
-		_normals.clear();
-		_tangents.clear();
-		_colors.clear();
-		_texCoords.clear();
-		_indices.clear();
+		//! Swap with the empty vectors to actually free the memory
+		std::vector<glm::vec3>().swap(_positions);
+		std::vector<glm::vec3>().swap(_normals);
+		std::vector<glm::vec4>().swap(_tangents);
+		std::vector<glm::vec4>().swap(_colors);
+		std::vector<glm::vec2>().swap(_texCoords);
+		std::vector<unsigned int>().swap(_indices);
+		std::vector<glm::u16vec4>().swap(_skinJoints);
+		std::vector<glm::u16vec4>().swap(_skinWeights);
+		std::vector<GLTFMorphDelta>().swap(_morphDeltas);
+		for (auto* stream : { &_quantizedPositions, &_quantizedNormals, &_quantizedTangents, &_quantizedColors, &_quantizedTexCoords })
+			*stream = GLTFQuantizedStream();
+
+		_mappedPositions = {};
+		_mappedNormals = {};
+		_mappedTangents = {};
+		_mappedColors = {};
+		_mappedTexCoords = {};
+		_mappedIndices = {};
+		_mappedSkinJoints = {};
+		_mappedSkinWeights = {};
+		_mappedMorphDeltas = {};
+		_sceneCacheFile.Close();
+	}
+
+	namespace
+	{
+		//! The vector is filled by a cold load or a later pass, the mapped range by a warm start
+		template <typename Type>
+		ArrayView<Type> SelectStream(const std::vector<Type>& values, const ArrayView<Type>& mapped)
+		{
+			return values.empty() ? mapped : ArrayView<Type>(values);
+		}
+	};
+
+	ArrayView<glm::vec3> GLTFScene::GetPositions() const
+	{
+		return SelectStream(_positions, _mappedPositions);
+	}
+
+	ArrayView<glm::vec3> GLTFScene::GetNormals() const
+	{
+		return SelectStream(_normals, _mappedNormals);
+	}
+
+	ArrayView<glm::vec4> GLTFScene::GetTangents() const
+	{
+		return SelectStream(_tangents, _mappedTangents);
+	}
+
+	ArrayView<glm::vec4> GLTFScene::GetColors() const
+	{
+		return SelectStream(_colors, _mappedColors);
+	}
+
+	ArrayView<glm::vec2> GLTFScene::GetTexCoords() const
+	{
+		return SelectStream(_texCoords, _mappedTexCoords);
+	}
+
+	ArrayView<unsigned int> GLTFScene::GetIndices() const
+	{
+		return SelectStream(_indices, _mappedIndices);
+	}
+
+	ArrayView<glm::u16vec4> GLTFScene::GetSkinJoints() const
+	{
+		return SelectStream(_skinJoints, _mappedSkinJoints);
+	}
+
+	ArrayView<glm::u16vec4> GLTFScene::GetSkinWeights() const
+	{
+		return SelectStream(_skinWeights, _mappedSkinWeights);
+	}
+
+	ArrayView<GLTFScene::GLTFMorphDelta> GLTFScene::GetMorphDeltas() const
+	{
+		return SelectStream(_morphDeltas, _mappedMorphDeltas);
 	}
 };
\ No newline at end of file
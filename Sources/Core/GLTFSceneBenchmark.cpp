@@ -0,0 +1,710 @@
+#include <Core/GLTFScene.hpp>
+#include <Core/MathUtils.hpp>
+#include <Core/Skinning.hpp>
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+
+namespace Core {
+
+	namespace
+	{
+		constexpr float kKeyInterval = 1.0f / 30.0f;
+		constexpr float kPlaybackInterval = 1.0f / 60.0f;
+		//! The linear scan of every key is too slow to run for all frames
+		constexpr int kMaxLinearScanFrames = 30;
+		//! The random keys cross the whole range between two keys, which amplifies the rounding of the late key times
+		constexpr float kBakeErrorBound = 1e-2f;
+		//! Frames between the updates of the distant nodes in the animation LOD run
+		constexpr int kLodReducedPeriod = 4;
+		//! Clips of the layered update, the last one is additive
+		constexpr int kNumBenchmarkLayers = 4;
+
+		//! Keyframe lookup before the cursors, every interval of the sampler is tested
+		std::size_t FindKeyframeLinear(const std::vector<float>& times, float time)
+		{
+			std::size_t result = 0;
+			for (std::size_t i = 0; i + 1 < times.size(); ++i)
+			{
+				if (times[i] <= time && time < times[i + 1])
+					result = i;
+			}
+			return result;
+		}
+
+		//! Children of each node in the synthetic hierarchy
+		constexpr std::size_t kBranchingFactor = 4;
+		//! Fraction of the nodes animated in the partially dirty frames
+		constexpr float kDirtyFraction = 0.01f;
+
+		//! Fraction of the vertices moved by each synthetic morph target, as the regions of a facial rig
+		constexpr float kMorphRegionFraction = 0.05f;
+		//! Number of keys each morph target stays non-zero in the synthetic weights animation
+		constexpr std::size_t kMorphActiveKeys = 8;
+
+		//! Sample rate of the synthetic motion capture clip and the largest allowed error of the fitted keys
+		constexpr float kCaptureInterval = 1.0f / 120.0f;
+		constexpr float kReductionErrorBound = 1e-3f;
+	};
+
+	void GLTFScene::BenchmarkAnimation(std::size_t numChannels, std::size_t numKeys, int numFrames)
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		auto elapsedMicroseconds = [](Clock::time_point start) {
+			return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+		};
+
+		//! One node per channel, the paths alternate among translation, rotation and scale
+		GLTFScene scene;
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+		scene._sceneNodes.resize(numChannels);
+		scene._nodeWorlds.assign(numChannels, glm::mat4(1.0f));
+		scene._nodeTransforms.assign(numChannels, glm::mat4(1.0f));
+		scene._nodeParents.assign(numChannels, -1);
+		scene._sceneChannels.resize(numChannels);
+		scene._sceneSamplers.resize(numChannels);
+		for (std::size_t i = 0; i < numChannels; ++i)
+		{
+			auto& channel = scene._sceneChannels[i];
+			channel.path = static_cast<GLTFChannel::Path>(i % 3);
+			channel.samplerIndex = static_cast<int>(i);
+			channel.nodeIndex = static_cast<int>(i);
+			scene._sceneNodes[i].nodeIndex = static_cast<int>(i);
+
+			auto& sampler = scene._sceneSamplers[i];
+			sampler.inputs.resize(numKeys);
+			sampler.outputs.resize(numKeys);
+			for (std::size_t k = 0; k < numKeys; ++k)
+			{
+				sampler.inputs[k] = static_cast<float>(k) * kKeyInterval;
+				const glm::vec4 value(distribution(random), distribution(random), distribution(random), distribution(random));
+				sampler.outputs[k] = channel.path == GLTFChannel::Path::Rotation ? glm::normalize(value) : value;
+			}
+		}
+
+		GLTFAnimation animation;
+		animation.name = "benchmark";
+		animation.channelCount = static_cast<int>(numChannels);
+		animation.samplerCount = static_cast<int>(numChannels);
+		animation.duration = numKeys > 0 ? scene._sceneSamplers.front().inputs.back() : 0.0f;
+		scene._sceneAnims.push_back(animation);
+		scene.BuildAnimationTracks();
+
+		std::cout << "[Animation Benchmark] " << numChannels << " channels x " << numKeys << " keys, " << numFrames << " frames" << std::endl;
+
+		//! Forward playback hits the cursors
+		auto start = Clock::now();
+		for (int frame = 0; frame < numFrames; ++frame)
+			scene.UpdateAnimation(0, frame * kPlaybackInterval);
+		std::cout << "\tplayback : " << elapsedMicroseconds(start) / numFrames << " (us) per update" << std::endl;
+
+		//! Random seeks fall back to the binary search
+		std::vector<float> seekTimes(numFrames);
+		std::uniform_real_distribution<float> seekDistribution(0.0f, animation.duration);
+		for (auto& time : seekTimes)
+			time = seekDistribution(random);
+		start = Clock::now();
+		for (int frame = 0; frame < numFrames; ++frame)
+			scene.UpdateAnimation(0, seekTimes[frame]);
+		std::cout << "\tseek     : " << elapsedMicroseconds(start) / numFrames << " (us) per update" << std::endl;
+
+		//! Batch evaluation compared with the channel by channel interpolation it replaced
+		std::vector<std::size_t> channelCursors(numChannels, 0);
+		std::vector<glm::vec4> channelValues(numChannels);
+		float maxDifference = 0.0f;
+		start = Clock::now();
+		for (int frame = 0; frame < numFrames; ++frame)
+		{
+			const float time = std::fmod(frame * kPlaybackInterval, animation.duration);
+			for (std::size_t i = 0; i < numChannels; ++i)
+			{
+				const auto& sampler = scene._sceneSamplers[i];
+				const std::size_t key = FindKeyframe(sampler.inputs.data(), sampler.inputs.size(), time, channelCursors[i]);
+				const std::size_t next = std::min(key + 1, sampler.inputs.size() - 1);
+				const float interval = sampler.inputs[next] - sampler.inputs[key];
+				const float keyframe = interval > 0.0f ? glm::clamp((time - sampler.inputs[key]) / interval, 0.0f, 1.0f) : 0.0f;
+				channelCursors[i] = key;
+				if (scene._sceneChannels[i].path == GLTFChannel::Path::Rotation)
+				{
+					const glm::quat rotation = glm::normalize(Interpolation::SLerp(
+						glm::quat(sampler.outputs[key].w, sampler.outputs[key].x, sampler.outputs[key].y, sampler.outputs[key].z),
+						glm::quat(sampler.outputs[next].w, sampler.outputs[next].x, sampler.outputs[next].y, sampler.outputs[next].z), keyframe));
+					channelValues[i] = glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w);
+				}
+				else
+				{
+					channelValues[i] = Interpolation::Lerp(sampler.outputs[key], sampler.outputs[next], keyframe);
+				}
+			}
+		}
+		const double channelTime = elapsedMicroseconds(start);
+		start = Clock::now();
+		for (int frame = 0; frame < numFrames; ++frame)
+		{
+			for (auto& track : scene._sceneTracks)
+				track.lanes.Evaluate(std::fmod(frame * kPlaybackInterval, animation.duration));
+		}
+		const double trackTime = elapsedMicroseconds(start);
+		for (const auto& track : scene._sceneTracks)
+		{
+			for (std::size_t lane = 0; lane < track.nodeIndices.size(); ++lane)
+			{
+				const glm::vec4 value(track.lanes.GetResults(0)[lane], track.lanes.GetResults(1)[lane], track.lanes.GetResults(2)[lane],
+									  track.lanes.GetResults(3)[lane]);
+				const glm::vec4 difference = glm::abs(value - channelValues[track.nodeIndices[lane]]);
+				const int componentCount = track.path == GLTFChannel::Path::Rotation ? 4 : 3;
+				for (int c = 0; c < componentCount; ++c)
+					maxDifference = std::max(maxDifference, difference[c]);
+			}
+		}
+		std::cout << "\tevaluate : tracks " << trackTime / numFrames << " (us), per channel " << channelTime / numFrames
+				  << " (us) per frame, max difference " << maxDifference << std::endl;
+
+		//! Lookup only, compared with the linear scan over the same playback
+		const int numLinearFrames = std::min(numFrames, kMaxLinearScanFrames);
+		std::size_t numMismatches = 0;
+		std::vector<std::size_t> cursors(numChannels, 0), results(numChannels * numLinearFrames);
+		start = Clock::now();
+		for (int frame = 0; frame < numLinearFrames; ++frame)
+		{
+			for (std::size_t i = 0; i < numChannels; ++i)
+			{
+				const auto& times = scene._sceneSamplers[i].inputs;
+				cursors[i] = FindKeyframe(times.data(), times.size(), frame * kPlaybackInterval, cursors[i]);
+				results[frame * numChannels + i] = cursors[i];
+			}
+		}
+		const double cursorTime = elapsedMicroseconds(start);
+		start = Clock::now();
+		for (int frame = 0; frame < numLinearFrames; ++frame)
+		{
+			for (std::size_t i = 0; i < numChannels; ++i)
+			{
+				const std::size_t result = FindKeyframeLinear(scene._sceneSamplers[i].inputs, frame * kPlaybackInterval);
+				numMismatches += result != results[frame * numChannels + i] ? 1 : 0;
+			}
+		}
+		const double linearTime = elapsedMicroseconds(start);
+		std::cout << "\tlookup   : cursor " << cursorTime / numLinearFrames << " (us), linear scan " << linearTime / numLinearFrames
+				  << " (us) per frame, " << numMismatches << " mismatches" << std::endl;
+
+		//! Animation LOD : a tenth of the nodes on screen, a fifth updated every fourth frame and the others frozen
+		scene._nodeUpdatePeriods.assign(numChannels, 0);
+		for (std::size_t i = 0; i < numChannels; ++i)
+			scene._nodeUpdatePeriods[i] = i % 10 == 0 ? 1 : (i % 5 == 1 ? kLodReducedPeriod : 0);
+		AnimationStats lodStats;
+		start = Clock::now();
+		for (int frame = 0; frame < numFrames; ++frame)
+		{
+			scene.UpdateAnimation(0, frame * kPlaybackInterval);
+			lodStats.evaluatedChannels += scene.GetAnimationStats().evaluatedChannels;
+			lodStats.skippedChannels += scene.GetAnimationStats().skippedChannels;
+		}
+		std::cout << "\tlod      : " << elapsedMicroseconds(start) / numFrames << " (us) per update, "
+				  << static_cast<double>(lodStats.evaluatedChannels) / numFrames << " channels evaluated, "
+				  << static_cast<double>(lodStats.skippedChannels) / numFrames << " skipped per update" << std::endl;
+		scene._nodeUpdatePeriods.clear();
+
+		//! Layers : three clips crossfaded and one additive clip sampled on the workers, every clip animates every node
+		for (int i = 1; i < kNumBenchmarkLayers; ++i)
+			scene._sceneAnims.push_back(animation);
+		scene.BuildAnimationTracks();
+		std::vector<GLTFAnimationLayer> layers(kNumBenchmarkLayers);
+		const float blendWeights[kNumBenchmarkLayers - 1] = { 0.5f, 0.3f, 0.2f };
+		for (int i = 0; i < kNumBenchmarkLayers; ++i)
+		{
+			layers[i].animIndex = i;
+			layers[i].weight = i + 1 < kNumBenchmarkLayers ? blendWeights[i] : 1.0f;
+			layers[i].mode = i + 1 < kNumBenchmarkLayers ? GLTFAnimationLayer::Mode::Blend : GLTFAnimationLayer::Mode::Additive;
+		}
+		start = Clock::now();
+		for (int frame = 0; frame < numFrames; ++frame)
+		{
+			for (int i = 0; i < kNumBenchmarkLayers; ++i)
+				layers[i].timeElapsed = (frame + i * numFrames / kNumBenchmarkLayers) * kPlaybackInterval;
+			scene.UpdateAnimation(layers);
+		}
+		std::cout << "\tlayers   : " << elapsedMicroseconds(start) / numFrames << " (us) per update of " << kNumBenchmarkLayers << " layers, "
+				  << scene.GetAnimationStats().evaluatedChannels << " channels evaluated" << std::endl;
+		scene._sceneAnims.resize(1);
+
+		//! Baked at the key rate, the keys are found by an index and packed into 48 bits
+		GLTFLoadOptions options;
+		options.animationSampleRate = 1.0f / kKeyInterval;
+		options.compressAnimations = true;
+		options.animationErrorBound = kBakeErrorBound;
+		scene.BakeAnimations(options);
+		scene.BuildAnimationTracks();
+		start = Clock::now();
+		for (int frame = 0; frame < numFrames; ++frame)
+			scene.UpdateAnimation(0, frame * kPlaybackInterval);
+		const double bakedPlaybackTime = elapsedMicroseconds(start);
+		start = Clock::now();
+		for (int frame = 0; frame < numFrames; ++frame)
+			scene.UpdateAnimation(0, seekTimes[frame]);
+		std::cout << "\tbaked    : playback " << bakedPlaybackTime / numFrames << " (us), seek " << elapsedMicroseconds(start) / numFrames
+				  << " (us) per update" << std::endl;
+	}
+
+	void GLTFScene::BenchmarkTransforms(std::size_t numNodes, int numFrames)
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		auto elapsedMicroseconds = [](Clock::time_point start) {
+			return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+		};
+
+		//! Complete tree with the parent of node i at (i - 1) / kBranchingFactor,
+		//! laid out in the pre-order like ProcessNode does
+		GLTFScene scene;
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+		scene._sceneNodes.resize(numNodes);
+		scene._nodeWorlds.assign(numNodes, glm::mat4(1.0f));
+		scene._nodeTransforms.assign(numNodes, glm::mat4(1.0f));
+		scene._nodeParents.resize(numNodes);
+		std::vector<int> order;
+		order.reserve(numNodes);
+		std::vector<std::pair<std::size_t, int>> stack;
+		if (numNodes > 0)
+			stack.emplace_back(0, -1);
+		while (!stack.empty())
+		{
+			const std::size_t treeIndex = stack.back().first;
+			const int parentNode = stack.back().second;
+			stack.pop_back();
+
+			const int nodeIndex = static_cast<int>(order.size());
+			order.push_back(static_cast<int>(treeIndex));
+			auto& node = scene._sceneNodes[nodeIndex];
+			node.nodeIndex = nodeIndex;
+			scene._nodeParents[nodeIndex] = parentNode;
+			node.translation = glm::vec3(distribution(random), distribution(random), distribution(random));
+			node.rotation = glm::normalize(glm::quat(distribution(random), distribution(random), distribution(random), distribution(random)));
+			scene._nodeTransforms[nodeIndex] = GetLocalMatrix(node);
+			if (parentNode != -1)
+				scene._sceneNodes[parentNode].childNodes.push_back(nodeIndex);
+
+			//! Pushed in reverse so that the first child is visited first
+			for (std::size_t c = kBranchingFactor; c > 0; --c)
+			{
+				const std::size_t child = treeIndex * kBranchingFactor + c;
+				if (child < numNodes)
+					stack.emplace_back(child, nodeIndex);
+			}
+		}
+		//! Subtrees end where the next node outside of them starts, resolved from the leaves
+		for (std::size_t i = numNodes; i-- > 0;)
+		{
+			auto& node = scene._sceneNodes[i];
+			node.subtreeEnd = node.childNodes.empty() ? static_cast<int>(i) + 1 : scene._sceneNodes[node.childNodes.back()].subtreeEnd;
+		}
+		scene._dirtyNodes.push_back(0);
+		scene.UpdateNodeTransforms();
+
+		std::cout << "[Transform Benchmark] " << numNodes << " nodes, " << numFrames << " frames" << std::endl;
+
+		//! Nothing is animated, only the dirty check remains
+		auto start = Clock::now();
+		for (int frame = 0; frame < numFrames; ++frame)
+			scene.UpdateNodeTransforms();
+		std::cout << "\tstatic   : " << elapsedMicroseconds(start) / numFrames << " (us) per update" << std::endl;
+
+		//! Random nodes are animated, mostly the leaves
+		const std::size_t numDirtyNodes = std::max<std::size_t>(1, static_cast<std::size_t>(numNodes * kDirtyFraction));
+		std::uniform_int_distribution<int> nodeDistribution(0, static_cast<int>(numNodes) - 1);
+		std::vector<int> dirtyNodes(numDirtyNodes * numFrames);
+		for (auto& nodeIndex : dirtyNodes)
+			nodeIndex = nodeDistribution(random);
+		std::size_t numUpdatedNodes = 0;
+		start = Clock::now();
+		for (int frame = 0; frame < numFrames; ++frame)
+		{
+			for (std::size_t i = 0; i < numDirtyNodes; ++i)
+			{
+				const int nodeIndex = dirtyNodes[frame * numDirtyNodes + i];
+				scene._sceneNodes[nodeIndex].translation.x += 1e-3f;
+				scene._dirtyNodes.push_back(nodeIndex);
+				numUpdatedNodes += scene._sceneNodes[nodeIndex].subtreeEnd - nodeIndex;
+			}
+			scene.UpdateNodeTransforms();
+		}
+		std::cout << "\tpartial  : " << elapsedMicroseconds(start) / numFrames << " (us) per update, " << numDirtyNodes
+				  << " dirty nodes, up to " << numUpdatedNodes / numFrames << " world matrices" << std::endl;
+
+		//! The whole hierarchy is recomputed
+		start = Clock::now();
+		for (int frame = 0; frame < numFrames; ++frame)
+		{
+			scene._sceneNodes[0].translation.x += 1e-3f;
+			scene._dirtyNodes.push_back(0);
+			scene.UpdateNodeTransforms();
+		}
+		std::cout << "\tfull     : " << elapsedMicroseconds(start) / numFrames << " (us) per update" << std::endl;
+
+		//! The linear pass must match the recursive composition of the local matrices
+		float maxError = 0.0f;
+		for (std::size_t i = 0; i < numNodes; i += 997)
+		{
+			glm::mat4 world = GetLocalMatrix(scene._sceneNodes[i]);
+			for (int parentNode = scene._nodeParents[i]; parentNode != -1; parentNode = scene._nodeParents[parentNode])
+				world = GetLocalMatrix(scene._sceneNodes[parentNode]) * world;
+			for (int c = 0; c < 4; ++c)
+			{
+				const glm::vec4 difference = glm::abs(world[c] - scene._nodeWorlds[i][c]);
+				maxError = std::max(maxError, std::max(std::max(difference.x, difference.y), std::max(difference.z, difference.w)));
+			}
+		}
+		std::cout << "\tmax error against the recursive update : " << maxError << std::endl;
+	}
+
+	void GLTFScene::BenchmarkSkinning(std::size_t numVertices, std::size_t numJoints, int numFrames)
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		auto elapsedMicroseconds = [](Clock::time_point start) {
+			return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+		};
+
+		//! Chain of joints bound in the rest pose, each vertex is weighted by four random joints
+		GLTFScene scene;
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+		std::uniform_int_distribution<int> jointDistribution(0, static_cast<int>(numJoints) - 1);
+		scene._sceneNodes.resize(numJoints);
+		scene._nodeWorlds.assign(numJoints, glm::mat4(1.0f));
+		scene._nodeTransforms.assign(numJoints, glm::mat4(1.0f));
+		scene._nodeParents.resize(numJoints);
+		for (std::size_t j = 0; j < numJoints; ++j)
+		{
+			auto& node = scene._sceneNodes[j];
+			node.nodeIndex = static_cast<int>(j);
+			scene._nodeParents[j] = static_cast<int>(j) - 1;
+			node.subtreeEnd = static_cast<int>(numJoints);
+			node.translation = glm::vec3(0.0f, 1.0f, 0.0f);
+			node.rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+			scene._jointNodes.push_back(static_cast<int>(j));
+		}
+		scene._dirtyNodes.push_back(0);
+		scene.UpdateNodeTransforms();
+		for (const auto& world : scene._nodeWorlds)
+			scene._inverseBindMatrices.push_back(glm::inverse(world));
+
+		GLTFSkin skin;
+		skin.jointCount = static_cast<int>(numJoints);
+		scene._sceneSkins.push_back(skin);
+
+		std::vector<glm::vec3> positions(numVertices), normals(numVertices);
+		std::vector<glm::u16vec4> joints(numVertices), weights(numVertices);
+		for (std::size_t v = 0; v < numVertices; ++v)
+		{
+			positions[v] = glm::vec3(distribution(random), distribution(random) * numJoints, distribution(random));
+			normals[v] = glm::normalize(glm::vec3(distribution(random), distribution(random), distribution(random)) + glm::vec3(0.0f, 0.0f, 2.0f));
+			int remaining = 65535;
+			for (int k = 0; k < 3; ++k)
+			{
+				joints[v][k] = static_cast<glm::u16>(jointDistribution(random));
+				weights[v][k] = static_cast<glm::u16>(std::uniform_int_distribution<int>(0, remaining)(random));
+				remaining -= weights[v][k];
+			}
+			joints[v][3] = static_cast<glm::u16>(jointDistribution(random));
+			weights[v][3] = static_cast<glm::u16>(remaining);
+		}
+
+		std::cout << "[Skinning Benchmark] " << numVertices << " vertices, " << numJoints << " joints, " << numFrames << " frames" << std::endl;
+
+		//! Every joint bends a little each frame
+		double paletteTime = 0.0;
+		for (int frame = 0; frame < numFrames; ++frame)
+		{
+			for (auto& node : scene._sceneNodes)
+				node.rotation = glm::angleAxis(0.01f * (frame + 1), glm::vec3(0.0f, 0.0f, 1.0f));
+			scene._dirtyNodes.push_back(0);
+			scene.UpdateNodeTransforms();
+			const auto start = Clock::now();
+			scene.UpdateJointPalettes();
+			paletteTime += elapsedMicroseconds(start);
+		}
+		std::cout << "\tpalette  : " << paletteTime / numFrames << " (us) per update" << std::endl;
+
+		std::vector<glm::vec3> skinnedPositions(numVertices), skinnedNormals(numVertices);
+		auto start = Clock::now();
+		for (int frame = 0; frame < numFrames; ++frame)
+		{
+			SkinVertices(skinnedPositions.data(), skinnedNormals.data(), positions.data(), normals.data(), joints.data(), weights.data(),
+						 numVertices, scene._jointPalette.data(), numJoints);
+		}
+		const double simdTime = elapsedMicroseconds(start);
+
+		//! Straightforward blending of the glm matrices as the reference
+		std::vector<glm::vec3> referencePositions(numVertices), referenceNormals(numVertices);
+		start = Clock::now();
+		for (int frame = 0; frame < numFrames; ++frame)
+		{
+			for (std::size_t v = 0; v < numVertices; ++v)
+			{
+				glm::mat4 matrix(0.0f);
+				for (int k = 0; k < 4; ++k)
+					matrix += scene._jointPalette[joints[v][k]] * (weights[v][k] / 65535.0f);
+				referencePositions[v] = glm::vec3(matrix * glm::vec4(positions[v], 1.0f));
+				referenceNormals[v] = glm::normalize(glm::mat3(matrix) * normals[v]);
+			}
+		}
+		const double referenceTime = elapsedMicroseconds(start);
+
+		float maxPositionError = 0.0f, maxNormalError = 0.0f;
+		for (std::size_t v = 0; v < numVertices; ++v)
+		{
+			maxPositionError = std::max(maxPositionError, glm::length(skinnedPositions[v] - referencePositions[v]));
+			maxNormalError = std::max(maxNormalError, glm::length(skinnedNormals[v] - referenceNormals[v]));
+		}
+		std::cout << "\tskinning : " << simdTime / numFrames << " (us), reference " << referenceTime / numFrames << " (us) per frame, max error position "
+				  << maxPositionError << ", normal " << maxNormalError << std::endl;
+	}
+
+	void GLTFScene::BenchmarkMorphTargets(std::size_t numVertices, std::size_t numTargets, int numFrames)
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		auto elapsedMicroseconds = [](Clock::time_point start) {
+			return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+		};
+
+		//! One primitive whose targets move their own contiguous region in the sparse ranges
+		GLTFScene scene;
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+		const std::size_t regionSize = std::max<std::size_t>(static_cast<std::size_t>(numVertices * kMorphRegionFraction), 1);
+		std::uniform_int_distribution<std::size_t> regionDistribution(0, numVertices - regionSize);
+		scene._positions.resize(numVertices);
+		scene._normals.resize(numVertices);
+		for (std::size_t v = 0; v < numVertices; ++v)
+		{
+			scene._positions[v] = glm::vec3(distribution(random), distribution(random), distribution(random));
+			scene._normals[v] = glm::normalize(scene._positions[v] + glm::vec3(0.0f, 0.0f, 2.0f));
+		}
+
+		GLTFPrimMesh primMesh;
+		primMesh.vertexCount = static_cast<unsigned int>(numVertices);
+		primMesh.morphTargetCount = static_cast<int>(numTargets);
+		scene._scenePrimMeshes.push_back(primMesh);
+		for (std::size_t t = 0; t < numTargets; ++t)
+		{
+			GLTFMorphTarget target;
+			const std::size_t regionBegin = regionDistribution(random);
+			for (GLTFMorphRange* range : { &target.position, &target.normal })
+			{
+				range->offset = static_cast<int>(scene._morphDeltas.size());
+				range->count = static_cast<int>(regionSize);
+				range->sparse = 1;
+				for (std::size_t v = regionBegin; v < regionBegin + regionSize; ++v)
+				{
+					const glm::vec3 delta(distribution(random), distribution(random), distribution(random));
+					scene._morphDeltas.push_back({ delta * 0.1f, static_cast<unsigned int>(v) });
+				}
+			}
+			scene._morphTargets.push_back(target);
+		}
+
+		GLTFNode node;
+		node.primMeshes.push_back(0);
+		node.subtreeEnd = 1;
+		node.weightCount = static_cast<int>(numTargets);
+		scene._sceneNodes.push_back(node);
+		scene._nodeWorlds.emplace_back(1.0f);
+		scene._nodeTransforms.emplace_back(1.0f);
+		scene._nodeParents.push_back(-1);
+		scene._morphWeights.assign(numTargets, 0.0f);
+
+		//! Targets fade in and out one after another, a few of them are non-zero at any time
+		const std::size_t numKeys = numTargets * 2 + kMorphActiveKeys;
+		GLTFSampler sampler;
+		sampler.inputs.resize(numKeys);
+		sampler.outputs.assign(numKeys * numTargets, glm::vec4(0.0f));
+		for (std::size_t k = 0; k < numKeys; ++k)
+		{
+			sampler.inputs[k] = static_cast<float>(k) * kKeyInterval;
+			for (std::size_t t = 0; t < numTargets; ++t)
+			{
+				const std::size_t firstKey = t * 2;
+				if (k > firstKey && k < firstKey + kMorphActiveKeys)
+					sampler.outputs[k * numTargets + t].x = 1.0f - std::abs(static_cast<float>(k - firstKey) / (kMorphActiveKeys / 2) - 1.0f);
+			}
+		}
+		scene._sceneSamplers.push_back(sampler);
+
+		GLTFChannel channel;
+		channel.path = GLTFChannel::Path::Weights;
+		scene._sceneChannels.push_back(channel);
+
+		GLTFAnimation animation;
+		animation.name = "benchmark";
+		animation.channelCount = 1;
+		animation.samplerCount = 1;
+		animation.duration = sampler.inputs.back();
+		scene._sceneAnims.push_back(animation);
+		scene.BuildAnimationTracks();
+
+		const std::size_t expandedDeltas = numTargets * numVertices * 2;
+		std::cout << "[Morph Target Benchmark] " << numVertices << " vertices, " << numTargets << " targets, " << numFrames << " frames\n"
+				  << "\tdeltas   : " << scene._morphDeltas.size() * sizeof(GLTFMorphDelta) / 1024 << " (KB) sparse, "
+				  << expandedDeltas * sizeof(GLTFMorphDelta) / 1024 << " (KB) expanded" << std::endl;
+
+		//! Weights evaluation and the blending of the non-zero targets, the sum of the active targets is reported
+		std::vector<glm::vec3> positions(numVertices), normals(numVertices);
+		std::size_t numActiveTargets = 0;
+		double weightsTime = 0.0, blendTime = 0.0;
+		for (int frame = 0; frame < numFrames; ++frame)
+		{
+			auto start = Clock::now();
+			scene.UpdateAnimation(0, frame * kPlaybackInterval);
+			weightsTime += elapsedMicroseconds(start);
+			numActiveTargets += std::count_if(scene._morphWeights.begin(), scene._morphWeights.end(), [](float weight) { return weight != 0.0f; });
+
+			start = Clock::now();
+			scene.MorphPrimitive(0, 0, positions.data(), normals.data(), nullptr);
+			blendTime += elapsedMicroseconds(start);
+		}
+
+		//! Every target expanded to all vertices and blended regardless of its weight as the reference
+		std::vector<glm::vec3> expandedPositions(numTargets * numVertices, glm::vec3(0.0f)), expandedNormals(expandedPositions);
+		for (std::size_t t = 0; t < numTargets; ++t)
+		{
+			const auto& target = scene._morphTargets[t];
+			for (int i = 0; i < target.position.count; ++i)
+			{
+				const auto& delta = scene._morphDeltas[target.position.offset + i];
+				expandedPositions[t * numVertices + delta.vertex] = delta.delta;
+				const auto& normalDelta = scene._morphDeltas[target.normal.offset + i];
+				expandedNormals[t * numVertices + normalDelta.vertex] = normalDelta.delta;
+			}
+		}
+		std::vector<glm::vec3> referencePositions(numVertices), referenceNormals(numVertices);
+		const int numReferenceFrames = std::min(numFrames, kMaxLinearScanFrames);
+		auto start = Clock::now();
+		for (int frame = 0; frame < numReferenceFrames; ++frame)
+		{
+			const float* weights = scene._morphWeights.data();
+			for (std::size_t v = 0; v < numVertices; ++v)
+			{
+				glm::vec3 position = scene._positions[v], normal = scene._normals[v];
+				for (std::size_t t = 0; t < numTargets; ++t)
+				{
+					position += weights[t] * expandedPositions[t * numVertices + v];
+					normal += weights[t] * expandedNormals[t * numVertices + v];
+				}
+				referencePositions[v] = position;
+				referenceNormals[v] = glm::normalize(normal);
+			}
+		}
+		const double referenceTime = elapsedMicroseconds(start);
+
+		float maxPositionError = 0.0f, maxNormalError = 0.0f;
+		for (std::size_t v = 0; v < numVertices; ++v)
+		{
+			maxPositionError = std::max(maxPositionError, glm::length(positions[v] - referencePositions[v]));
+			maxNormalError = std::max(maxNormalError, glm::length(normals[v] - referenceNormals[v]));
+		}
+		std::cout << "\tweights  : " << weightsTime / numFrames << " (us) per update, " << static_cast<float>(numActiveTargets) / numFrames
+				  << " non-zero targets on average\n"
+				  << "\tblending : " << blendTime / numFrames << " (us), expanded reference " << referenceTime / numReferenceFrames
+				  << " (us) per frame, max error position " << maxPositionError << ", normal " << maxNormalError << std::endl;
+	}
+
+	void GLTFScene::BenchmarkKeyframeReduction(std::size_t numChannels, std::size_t numKeys, int numFrames)
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		auto elapsedMicroseconds = [](Clock::time_point start) {
+			return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+		};
+
+		//! Smooth curves of a few random frequencies sampled at the capture rate, the paths alternate as BenchmarkAnimation
+		GLTFScene scene;
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> frequencyDistribution(0.2f, 2.0f), phaseDistribution(0.0f, 6.2831853f);
+		scene._sceneNodes.resize(numChannels);
+		scene._nodeWorlds.assign(numChannels, glm::mat4(1.0f));
+		scene._nodeTransforms.assign(numChannels, glm::mat4(1.0f));
+		scene._nodeParents.assign(numChannels, -1);
+		scene._sceneChannels.resize(numChannels);
+		scene._sceneSamplers.resize(numChannels);
+		for (std::size_t i = 0; i < numChannels; ++i)
+		{
+			auto& channel = scene._sceneChannels[i];
+			channel.path = static_cast<GLTFChannel::Path>(i % 3);
+			channel.samplerIndex = static_cast<int>(i);
+			channel.nodeIndex = static_cast<int>(i);
+			scene._sceneNodes[i].nodeIndex = static_cast<int>(i);
+
+			glm::vec4 frequency, phase;
+			for (int c = 0; c < 4; ++c)
+			{
+				frequency[c] = frequencyDistribution(random);
+				phase[c] = phaseDistribution(random);
+			}
+			auto& sampler = scene._sceneSamplers[i];
+			sampler.inputs.resize(numKeys);
+			sampler.outputs.resize(numKeys);
+			for (std::size_t k = 0; k < numKeys; ++k)
+			{
+				const float time = static_cast<float>(k) * kCaptureInterval;
+				sampler.inputs[k] = time;
+				const glm::vec4 value = glm::sin(frequency * time + phase);
+				sampler.outputs[k] = channel.path == GLTFChannel::Path::Rotation ? glm::normalize(value + glm::vec4(0.0f, 0.0f, 0.0f, 2.0f)) : value;
+			}
+		}
+
+		GLTFAnimation animation;
+		animation.name = "capture";
+		animation.channelCount = static_cast<int>(numChannels);
+		animation.samplerCount = static_cast<int>(numChannels);
+		animation.duration = numKeys > 0 ? scene._sceneSamplers.front().inputs.back() : 0.0f;
+		scene._sceneAnims.push_back(animation);
+		scene.BuildAnimationTracks();
+
+		std::cout << "[Keyframe Reduction Benchmark] " << numChannels << " channels x " << numKeys << " keys at "
+				  << 1.0f / kCaptureInterval << " Hz, " << numFrames << " frames" << std::endl;
+
+		//! Results of the dense tracks over the playback are the reference of the fitted ones, stored per node
+		const auto Playback = [&](GLTFScene& target, std::vector<glm::vec4>* results) {
+			results->resize(numFrames * numChannels);
+			const auto start = Clock::now();
+			for (int frame = 0; frame < numFrames; ++frame)
+			{
+				for (auto& track : target._sceneTracks)
+				{
+					track.lanes.Evaluate(std::fmod(frame * kPlaybackInterval, animation.duration));
+					for (std::size_t lane = 0; lane < track.nodeIndices.size(); ++lane)
+					{
+						(*results)[frame * numChannels + track.nodeIndices[lane]] = glm::vec4(track.lanes.GetResults(0)[lane], track.lanes.GetResults(1)[lane],
+																							   track.lanes.GetResults(2)[lane], track.lanes.GetResults(3)[lane]);
+					}
+				}
+			}
+			return elapsedMicroseconds(start);
+		};
+		std::vector<glm::vec4> denseResults, reducedResults;
+		const double denseTime = Playback(scene, &denseResults);
+
+		auto start = Clock::now();
+		scene.ReduceKeyframes(kReductionErrorBound);
+		const double reductionTime = elapsedMicroseconds(start);
+		scene.BuildAnimationTracks();
+		const double reducedTime = Playback(scene, &reducedResults);
+
+		//! The rotations are compared with the sign of the reference
+		float maxDifference = 0.0f;
+		for (std::size_t i = 0; i < denseResults.size(); ++i)
+		{
+			const bool isRotation = scene._sceneChannels[i % numChannels].path == GLTFChannel::Path::Rotation;
+			const glm::vec4& dense = denseResults[i];
+			const glm::vec4 reduced = isRotation && glm::dot(dense, reducedResults[i]) < 0.0f ? -reducedResults[i] : reducedResults[i];
+			const glm::vec4 difference = glm::abs(dense - reduced);
+			for (int c = 0; c < (isRotation ? 4 : 3); ++c)
+				maxDifference = std::max(maxDifference, difference[c]);
+		}
+		std::cout << "\treduction: " << reductionTime / 1000.0 << " (ms)\n"
+				  << "\tevaluate : cubic " << reducedTime / numFrames << " (us), linear " << denseTime / numFrames
+				  << " (us) per frame, max difference " << maxDifference << std::endl;
+	}
+};
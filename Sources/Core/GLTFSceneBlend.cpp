@@ -0,0 +1,383 @@
+#include <Core/GLTFScene.hpp>
+#include <Core/Macros.hpp>
+#include <Core/ThreadPool.hpp>
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#if defined(SIMD_SSE2)
+#include <emmintrin.h>
+#endif
+
+namespace Core {
+
+	namespace
+	{
+		//! Animated nodes blended per job of the layer passes
+		constexpr std::size_t kBlendGrainSize = 256;
+
+		//! Bits of the paths of the animated node, shifted by the channel path
+		constexpr unsigned int kTranslationBit = 1u << 0;
+		constexpr unsigned int kRotationBit = 1u << 1;
+		constexpr unsigned int kScaleBit = 1u << 2;
+		constexpr unsigned int kWeightsBit = 1u << 3;
+
+		//! accumulator += value * weight
+		inline void MultiplyAdd(glm::vec4& accumulator, const glm::vec4& value, float weight)
+		{
+#if defined(SIMD_SSE2)
+			const __m128 sum = _mm_add_ps(_mm_loadu_ps(&accumulator.x), _mm_mul_ps(_mm_loadu_ps(&value.x), _mm_set1_ps(weight)));
+			_mm_storeu_ps(&accumulator.x, sum);
+#else
+			accumulator += value * weight;
+#endif
+		}
+
+		//! accumulator += (value - reference) * weight
+		inline void MultiplyAddDifference(glm::vec4& accumulator, const glm::vec4& value, const glm::vec4& reference, float weight)
+		{
+#if defined(SIMD_SSE2)
+			const __m128 difference = _mm_sub_ps(_mm_loadu_ps(&value.x), _mm_loadu_ps(&reference.x));
+			_mm_storeu_ps(&accumulator.x, _mm_add_ps(_mm_loadu_ps(&accumulator.x), _mm_mul_ps(difference, _mm_set1_ps(weight))));
+#else
+			accumulator += (value - reference) * weight;
+#endif
+		}
+
+		//! Fill the total weight below one with the rest value and divide the accumulated value by the total weight
+		inline glm::vec4 ResolveBlend(const glm::vec4& accumulator, const glm::vec4& rest, float totalWeight)
+		{
+			glm::vec4 result = accumulator;
+			if (totalWeight < 1.0f)
+			{
+				MultiplyAdd(result, rest, 1.0f - totalWeight);
+				return result;
+			}
+			return result / totalWeight;
+		}
+
+		inline glm::quat ToQuat(const glm::vec4& value)
+		{
+			return glm::quat(value.w, value.x, value.y, value.z);
+		}
+
+		inline glm::vec4 ToVec4(const glm::quat& value)
+		{
+			return glm::vec4(value.x, value.y, value.z, value.w);
+		}
+	};
+
+	int GLTFScene::AddAnimationMask(const std::vector<float>& nodeWeights)
+	{
+		if (nodeWeights.size() != _sceneNodes.size())
+		{
+			std::cerr << "[GLTFScene::AddAnimationMask] Expected the weights of " << _sceneNodes.size() << " nodes, given " << nodeWeights.size() << std::endl;
+			return -1;
+		}
+
+		const int maskIndex = _sceneNodes.empty() ? 0 : static_cast<int>(_animationMasks.size() / _sceneNodes.size());
+		_animationMasks.insert(_animationMasks.end(), nodeWeights.begin(), nodeWeights.end());
+		return maskIndex;
+	}
+
+	int GLTFScene::AddSubtreeMask(int gltfNodeIndex)
+	{
+		//! Every instance of the node in the scene is masked with its descendants
+		std::vector<float> nodeWeights(_sceneNodes.size(), 0.0f);
+		bool found = false;
+		for (std::size_t i = 0; i < _sceneNodes.size(); ++i)
+		{
+			const auto& node = _sceneNodes[i];
+			if (node.nodeIndex != gltfNodeIndex)
+				continue;
+			std::fill(nodeWeights.begin() + i, nodeWeights.begin() + node.subtreeEnd, 1.0f);
+			found = true;
+		}
+
+		if (!found)
+		{
+			std::cerr << "[GLTFScene::AddSubtreeMask] The node " << gltfNodeIndex << " is not in the scene" << std::endl;
+			return -1;
+		}
+		return AddAnimationMask(nodeWeights);
+	}
+
+	void GLTFScene::ResizePose(const GLTFAnimation& anim, GLTFPose* pose) const
+	{
+		pose->translations.resize(anim.animatedNodeCount);
+		pose->rotations.resize(anim.animatedNodeCount);
+		pose->scales.resize(anim.animatedNodeCount);
+		pose->weights.resize(_morphWeights.size());
+	}
+
+	void GLTFScene::ScatterTrack(const GLTFTrack& track, GLTFPose* pose) const
+	{
+		const float* x = track.lanes.GetResults(0);
+		const float* y = track.lanes.GetResults(1);
+		const float* z = track.lanes.GetResults(2);
+		const float* w = track.lanes.GetResults(3);
+
+		for (std::size_t lane = 0; lane < track.nodeIndices.size(); ++lane)
+		{
+			const glm::vec4 value(x[lane], y[lane], z[lane], w[lane]);
+			const int entry = track.poseIndices[lane];
+			switch (track.path)
+			{
+			case GLTFChannel::Path::Translation:
+				pose->translations[entry] = value;
+				break;
+			case GLTFChannel::Path::Rotation:
+				pose->rotations[entry] = value;
+				break;
+			case GLTFChannel::Path::Scale:
+				pose->scales[entry] = value;
+				break;
+			case GLTFChannel::Path::Weights:
+			{
+				const auto& node = _sceneNodes[track.nodeIndices[lane]];
+				const int firstTarget = track.targetIndices[lane];
+				for (int k = 0; k < std::min(4, node.weightCount - firstTarget); ++k)
+					pose->weights[node.weightIndex + firstTarget + k] = value[k];
+				break;
+			}
+			}
+		}
+	}
+
+	bool GLTFScene::UpdateAnimation(const std::vector<GLTFAnimationLayer>& layers)
+	{
+		_animationStats = AnimationStats();
+		const std::size_t numNodes = _sceneNodes.size();
+		_layerPoses.resize(layers.size());
+		_blendPose.translations.resize(numNodes);
+		_blendPose.rotations.resize(numNodes);
+		_blendPose.scales.resize(numNodes);
+		_blendPose.weights.resize(_morphWeights.size());
+		_blendSums.resize(numNodes);
+		_blendedFlags.resize(numNodes, 0);
+
+		//! Layers with a clip of the scene, the weights of the other layers are ignored
+		std::vector<std::size_t> validLayers;
+		for (std::size_t i = 0; i < layers.size(); ++i)
+		{
+			const auto& layer = layers[i];
+			if (layer.animIndex >= 0 && layer.animIndex < static_cast<int>(_sceneAnims.size()))
+				validLayers.push_back(i);
+		}
+
+		//! The layers of the same clip share its tracks, therefore one job samples them one after another
+		std::stable_sort(validLayers.begin(), validLayers.end(), [&layers](std::size_t lhs, std::size_t rhs) {
+			return layers[lhs].animIndex < layers[rhs].animIndex;
+		});
+		struct SampleJob
+		{
+			int trackIndex;
+			std::size_t firstLayer;
+			std::size_t lastLayer;
+		};
+		std::vector<SampleJob> jobs;
+		for (std::size_t first = 0, last = 0; first < validLayers.size(); first = last)
+		{
+			const auto& anim = _sceneAnims[layers[validLayers[first]].animIndex];
+			for (last = first; last < validLayers.size() && layers[validLayers[last]].animIndex == layers[validLayers[first]].animIndex; ++last)
+				ResizePose(anim, &_layerPoses[validLayers[last]]);
+			for (int t = anim.trackIndex; t < anim.trackCount + anim.trackIndex; ++t)
+			{
+				jobs.push_back({ t, first, last });
+				const auto& targetIndices = _sceneTracks[t].targetIndices;
+				_animationStats.evaluatedChannels += (last - first) * static_cast<std::size_t>(std::count(targetIndices.begin(), targetIndices.end(), 0));
+			}
+		}
+
+		ThreadPool::GetInstance().ParallelFor(jobs.size(), 1, [&](std::size_t begin, std::size_t end) {
+			for (std::size_t j = begin; j < end; ++j)
+			{
+				auto& track = _sceneTracks[jobs[j].trackIndex];
+				for (std::size_t l = jobs[j].firstLayer; l < jobs[j].lastLayer; ++l)
+				{
+					const auto& layer = layers[validLayers[l]];
+					const float duration = _sceneAnims[layer.animIndex].duration;
+					track.lanes.Evaluate(duration > 0.0f ? std::fmod(layer.timeElapsed, duration) : 0.0f);
+					ScatterTrack(track, &_layerPoses[validLayers[l]]);
+				}
+			}
+		});
+
+		//! Nodes of this update followed by the nodes of the last update which return to the rest pose
+		std::vector<int> blendedNodes;
+		for (std::size_t index : validLayers)
+		{
+			const auto& anim = _sceneAnims[layers[index].animIndex];
+			for (int a = anim.animatedNodeIndex; a < anim.animatedNodeCount + anim.animatedNodeIndex; ++a)
+			{
+				const int nodeIndex = _animatedNodes[a].nodeIndex;
+				if (_blendedFlags[nodeIndex] == 0)
+				{
+					_blendedFlags[nodeIndex] = 1;
+					blendedNodes.push_back(nodeIndex);
+				}
+			}
+		}
+		const std::size_t numCurrentNodes = blendedNodes.size();
+		for (int nodeIndex : _blendedNodes)
+		{
+			if (_blendedFlags[nodeIndex] == 0)
+				blendedNodes.push_back(nodeIndex);
+		}
+
+		for (int nodeIndex : blendedNodes)
+		{
+			const auto& node = _sceneNodes[nodeIndex];
+			_blendPose.translations[nodeIndex] = glm::vec4(0.0f);
+			_blendPose.rotations[nodeIndex] = glm::vec4(0.0f);
+			_blendPose.scales[nodeIndex] = glm::vec4(0.0f);
+			std::fill_n(_blendPose.weights.begin() + node.weightIndex, node.weightCount, 0.0f);
+			_blendSums[nodeIndex] = glm::vec4(0.0f);
+		}
+
+		//! Runs the pass over the animated nodes of every layer of the given mode, each node appears once per layer
+		auto forEachLayerNode = [&](GLTFAnimationLayer::Mode mode, const auto& pass) {
+			for (std::size_t i = 0; i < layers.size(); ++i)
+			{
+				const auto& layer = layers[i];
+				if (layer.mode != mode || layer.animIndex < 0 || layer.animIndex >= static_cast<int>(_sceneAnims.size()))
+					continue;
+				const auto& anim = _sceneAnims[layer.animIndex];
+				const bool hasMask = layer.maskIndex >= 0 && static_cast<std::size_t>(layer.maskIndex + 1) * numNodes <= _animationMasks.size();
+				const float* mask = hasMask ? _animationMasks.data() + layer.maskIndex * numNodes : nullptr;
+				const GLTFPose& pose = _layerPoses[i];
+				ThreadPool::GetInstance().ParallelFor(anim.animatedNodeCount, kBlendGrainSize, [&](std::size_t begin, std::size_t end) {
+					for (std::size_t entry = begin; entry < end; ++entry)
+					{
+						const auto& animatedNode = _animatedNodes[anim.animatedNodeIndex + entry];
+						const float weight = layer.weight * (mask != nullptr ? mask[animatedNode.nodeIndex] : 1.0f);
+						if (weight > 0.0f)
+							pass(layer, pose, entry, animatedNode, weight);
+					}
+				});
+			}
+		};
+
+		//! Weighted sums of the blend layers, the rotations are flipped into the hemisphere of the rest rotation
+		forEachLayerNode(GLTFAnimationLayer::Mode::Blend, [&](const GLTFAnimationLayer&, const GLTFPose& pose, std::size_t entry, const GLTFAnimatedNode& animatedNode, float weight) {
+			const int nodeIndex = animatedNode.nodeIndex;
+			const unsigned int paths = animatedNode.paths;
+			glm::vec4& sums = _blendSums[nodeIndex];
+			if (paths & kTranslationBit)
+			{
+				MultiplyAdd(_blendPose.translations[nodeIndex], pose.translations[entry], weight);
+				sums.x += weight;
+			}
+			if (paths & kRotationBit)
+			{
+				const float sign = glm::dot(pose.rotations[entry], _restPose.rotations[nodeIndex]) < 0.0f ? -1.0f : 1.0f;
+				MultiplyAdd(_blendPose.rotations[nodeIndex], pose.rotations[entry], sign * weight);
+				sums.y += weight;
+			}
+			if (paths & kScaleBit)
+			{
+				MultiplyAdd(_blendPose.scales[nodeIndex], pose.scales[entry], weight);
+				sums.z += weight;
+			}
+			if (paths & kWeightsBit)
+			{
+				const auto& node = _sceneNodes[nodeIndex];
+				for (int k = node.weightIndex; k < node.weightIndex + node.weightCount; ++k)
+					_blendPose.weights[k] += pose.weights[k] * weight;
+				sums.w += weight;
+			}
+		});
+
+		ThreadPool::GetInstance().ParallelFor(blendedNodes.size(), kBlendGrainSize, [&](std::size_t begin, std::size_t end) {
+			for (std::size_t i = begin; i < end; ++i)
+			{
+				const int nodeIndex = blendedNodes[i];
+				const auto& node = _sceneNodes[nodeIndex];
+				const glm::vec4& sums = _blendSums[nodeIndex];
+				_blendPose.translations[nodeIndex] = ResolveBlend(_blendPose.translations[nodeIndex], _restPose.translations[nodeIndex], sums.x);
+				_blendPose.scales[nodeIndex] = ResolveBlend(_blendPose.scales[nodeIndex], _restPose.scales[nodeIndex], sums.z);
+
+				const glm::vec4 rotation = ResolveBlend(_blendPose.rotations[nodeIndex], _restPose.rotations[nodeIndex], sums.y);
+				const float length = glm::length(rotation);
+				_blendPose.rotations[nodeIndex] = length > 0.0f ? rotation / length : _restPose.rotations[nodeIndex];
+
+				for (int k = node.weightIndex; k < node.weightIndex + node.weightCount; ++k)
+				{
+					if (sums.w < 1.0f)
+						_blendPose.weights[k] += _restPose.weights[k] * (1.0f - sums.w);
+					else
+						_blendPose.weights[k] /= sums.w;
+				}
+			}
+		});
+
+		//! Additive layers apply the difference of the clip to its first frame, the rotations on the local side
+		forEachLayerNode(GLTFAnimationLayer::Mode::Additive, [&](const GLTFAnimationLayer& layer, const GLTFPose& pose, std::size_t entry, const GLTFAnimatedNode& animatedNode, float weight) {
+			const GLTFPose& reference = _referencePoses[layer.animIndex];
+			const int nodeIndex = animatedNode.nodeIndex;
+			const unsigned int paths = animatedNode.paths;
+			if (paths & kTranslationBit)
+				MultiplyAddDifference(_blendPose.translations[nodeIndex], pose.translations[entry], reference.translations[entry], weight);
+			if (paths & kRotationBit)
+			{
+				glm::vec4 delta = ToVec4(glm::inverse(ToQuat(reference.rotations[entry])) * ToQuat(pose.rotations[entry]));
+				if (delta.w < 0.0f)
+					delta = -delta;
+				const glm::vec4 identity(0.0f, 0.0f, 0.0f, 1.0f);
+				glm::vec4 scaled = identity;
+				MultiplyAddDifference(scaled, delta, identity, weight);
+				_blendPose.rotations[nodeIndex] = ToVec4(glm::normalize(ToQuat(_blendPose.rotations[nodeIndex]) * glm::normalize(ToQuat(scaled))));
+			}
+			if (paths & kScaleBit)
+			{
+				const glm::vec4& base = reference.scales[entry];
+				const glm::vec4 ratio(base.x != 0.0f ? pose.scales[entry].x / base.x : 1.0f,
+									  base.y != 0.0f ? pose.scales[entry].y / base.y : 1.0f,
+									  base.z != 0.0f ? pose.scales[entry].z / base.z : 1.0f, 1.0f);
+				glm::vec4 factor(1.0f);
+				MultiplyAddDifference(factor, ratio, glm::vec4(1.0f), weight);
+				_blendPose.scales[nodeIndex] *= factor;
+			}
+			if (paths & kWeightsBit)
+			{
+				const auto& node = _sceneNodes[nodeIndex];
+				for (int k = node.weightIndex; k < node.weightIndex + node.weightCount; ++k)
+					_blendPose.weights[k] += (pose.weights[k] - reference.weights[k]) * weight;
+			}
+		});
+
+		//! Only the changed nodes are marked
+		bool sceneModified = false;
+		for (std::size_t i = 0; i < blendedNodes.size(); ++i)
+		{
+			const int nodeIndex = blendedNodes[i];
+			auto& node = _sceneNodes[nodeIndex];
+			const glm::vec3 translation(_blendPose.translations[nodeIndex]);
+			const glm::quat rotation = ToQuat(_blendPose.rotations[nodeIndex]);
+			const glm::vec3 scale(_blendPose.scales[nodeIndex]);
+			if (translation != node.translation || rotation != node.rotation || scale != node.scale)
+			{
+				node.translation = translation;
+				node.rotation = rotation;
+				node.scale = scale;
+				_dirtyNodes.push_back(nodeIndex);
+				sceneModified = true;
+			}
+			for (int k = node.weightIndex; k < node.weightIndex + node.weightCount; ++k)
+			{
+				sceneModified |= _morphWeights[k] != _blendPose.weights[k];
+				_morphWeights[k] = _blendPose.weights[k];
+			}
+			_blendedFlags[nodeIndex] = 0;
+		}
+		blendedNodes.resize(numCurrentNodes);
+		_blendedNodes = std::move(blendedNodes);
+
+		UpdateNodeTransforms();
+		if (sceneModified)
+			UpdateJointPalettes();
+
+		return sceneModified;
+	}
+};
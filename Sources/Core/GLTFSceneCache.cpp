@@ -0,0 +1,850 @@
+#include <Core/GLTFScene.hpp>
+#include <Core/MappedFile.hpp>
+#include <type_traits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace Core {
+
+	namespace
+	{
+		//! Bump the version whenever the layout of the cached scene state is changed.
+		constexpr char kSceneCacheMagic[8] = { 'G', 'L', 'T', 'F', 'S', 'C', 'N', 'C' };
+		constexpr uint32_t kSceneCacheVersion = 10;
+		//! Arrays are aligned in the file so that they can be read in place or copied straight out of the mapping
+		constexpr std::size_t kArrayAlignment = 16;
+
+		constexpr uint64_t kPrime1 = 11400714785074694791ULL;
+		constexpr uint64_t kPrime2 = 14029467366897019727ULL;
+		constexpr uint64_t kPrime3 = 1609587929392839161ULL;
+		constexpr uint64_t kPrime4 = 9650029242287828579ULL;
+		constexpr uint64_t kPrime5 = 2870177450012600261ULL;
+
+		inline uint64_t RotateLeft(uint64_t value, int bits)
+		{
+			return (value << bits) | (value >> (64 - bits));
+		}
+
+		inline uint64_t Read64(const unsigned char* data)
+		{
+			uint64_t value;
+			std::memcpy(&value, data, sizeof(value));
+			return value;
+		}
+
+		inline uint64_t Round(uint64_t acc, uint64_t input)
+		{
+			acc += input * kPrime2;
+			return RotateLeft(acc, 31) * kPrime1;
+		}
+
+		inline uint64_t MergeRound(uint64_t acc, uint64_t value)
+		{
+			acc ^= Round(0, value);
+			return acc * kPrime1 + kPrime4;
+		}
+
+		//! xxHash64 of the given bytes, fast enough to validate the source files at every start
+		uint64_t Hash64(const unsigned char* data, std::size_t size, uint64_t seed)
+		{
+			const unsigned char* end = data + size;
+			uint64_t hash;
+
+			if (size >= 32)
+			{
+				uint64_t v1 = seed + kPrime1 + kPrime2;
+				uint64_t v2 = seed + kPrime2;
+				uint64_t v3 = seed;
+				uint64_t v4 = seed - kPrime1;
+				const unsigned char* limit = end - 32;
+				do
+				{
+					v1 = Round(v1, Read64(data));
+					v2 = Round(v2, Read64(data + 8));
+					v3 = Round(v3, Read64(data + 16));
+					v4 = Round(v4, Read64(data + 24));
+					data += 32;
+				} while (data <= limit);
+
+				hash = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+				hash = MergeRound(hash, v1);
+				hash = MergeRound(hash, v2);
+				hash = MergeRound(hash, v3);
+				hash = MergeRound(hash, v4);
+			}
+			else
+			{
+				hash = seed + kPrime5;
+			}
+
+			hash += static_cast<uint64_t>(size);
+
+			for (; data + 8 <= end; data += 8)
+				hash = RotateLeft(hash ^ Round(0, Read64(data)), 27) * kPrime1 + kPrime4;
+
+			if (data + 4 <= end)
+			{
+				uint32_t value;
+				std::memcpy(&value, data, sizeof(value));
+				hash = RotateLeft(hash ^ (static_cast<uint64_t>(value) * kPrime1), 23) * kPrime2 + kPrime3;
+				data += 4;
+			}
+
+			for (; data < end; ++data)
+				hash = RotateLeft(hash ^ (static_cast<uint64_t>(*data) * kPrime5), 11) * kPrime1;
+
+			hash ^= hash >> 33;
+			hash *= kPrime2;
+			hash ^= hash >> 29;
+			hash *= kPrime3;
+			hash ^= hash >> 32;
+			return hash;
+		}
+
+		//! Options changing the loaded scene state, the others only affect the way of loading.
+		//! The error bound of the keyframe reduction is kept in the upper word.
+		uint64_t GetOptionsKey(const GLTFLoadOptions& options)
+		{
+			uint64_t key = (options.keepQuantized ? 1u : 0u) | (options.optimizeMeshes ? 2u : 0u) | (options.generateLods ? 4u : 0u);
+			if (options.reduceKeyframes)
+			{
+				uint32_t errorBound{ 0 };
+				std::memcpy(&errorBound, &options.keyframeErrorBound, sizeof(errorBound));
+				key |= 8u | (static_cast<uint64_t>(errorBound) << 32);
+			}
+			return key;
+		}
+
+		std::string GetBaseDirectory(const std::string& filename)
+		{
+			const std::size_t pos = filename.find_last_of("/\\");
+			return pos == std::string::npos ? std::string() : filename.substr(0, pos);
+		}
+
+		std::string JoinPath(const std::string& baseDir, const std::string& path)
+		{
+			return baseDir.empty() ? path : baseDir + "/" + path;
+		}
+
+		//! Hash the contents of all dependencies.
+		//! Missing files are hashed as empty, the cache becomes stale once they appear.
+		uint64_t HashDependencies(const std::string& baseDir, const std::vector<std::string>& dependencies)
+		{
+			uint64_t seed = 0;
+			for (const auto& dependency : dependencies)
+			{
+				MappedFile file;
+				if (file.Open(JoinPath(baseDir, dependency)))
+					seed = Hash64(file.GetData(), file.GetSize(), seed);
+				else
+					seed = Hash64(nullptr, 0, seed);
+			}
+			return seed;
+		}
+
+		class CacheWriter
+		{
+		public:
+			explicit CacheWriter(const std::string& path)
+				: _stream(path, std::ios::binary | std::ios::trunc)
+			{
+				//! Do nothing
+			}
+
+			bool IsValid() const
+			{
+				return _stream.good();
+			}
+
+			void Close()
+			{
+				_stream.close();
+			}
+
+			void WriteBytes(const void* data, std::size_t size)
+			{
+				if (size > 0)
+					_stream.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+				_offset += size;
+			}
+
+			void Align()
+			{
+				static const char kPadding[kArrayAlignment] = {};
+				WriteBytes(kPadding, (kArrayAlignment - _offset % kArrayAlignment) % kArrayAlignment);
+			}
+
+			template <typename Type>
+			void Write(const Type& value)
+			{
+				static_assert(std::is_trivially_copyable<Type>::value, "Only trivially copyable types can be written as raw bytes");
+				WriteBytes(&value, sizeof(Type));
+			}
+
+			template <typename Type>
+			void WriteVector(const std::vector<Type>& values)
+			{
+				static_assert(std::is_trivially_copyable<Type>::value, "Only trivially copyable types can be written as raw bytes");
+				Write(static_cast<uint64_t>(values.size()));
+				Align();
+				WriteBytes(values.data(), values.size() * sizeof(Type));
+			}
+
+			void WriteString(const std::string& value)
+			{
+				Write(static_cast<uint64_t>(value.size()));
+				WriteBytes(value.data(), value.size());
+			}
+		private:
+			std::ofstream _stream;
+			std::size_t _offset{ 0 };
+		};
+
+		//! Bounds checked reader over the mapped cache file.
+		//! Once a read runs out of the range, all following reads fail.
+		class CacheReader
+		{
+		public:
+			CacheReader(const unsigned char* data, std::size_t size)
+				: _begin(data), _cursor(data), _end(data + size)
+			{
+				//! Do nothing
+			}
+
+			bool IsValid() const
+			{
+				return _valid;
+			}
+
+			bool ReadBytes(void* data, std::size_t size)
+			{
+				if (!_valid || static_cast<std::size_t>(_end - _cursor) < size)
+					return _valid = false;
+				if (size > 0)
+					std::memcpy(data, _cursor, size);
+				_cursor += size;
+				return true;
+			}
+
+			template <typename Type>
+			bool Read(Type& value)
+			{
+				static_assert(std::is_trivially_copyable<Type>::value, "Only trivially copyable types can be read as raw bytes");
+				return ReadBytes(&value, sizeof(Type));
+			}
+
+			bool Align()
+			{
+				const std::size_t offset = static_cast<std::size_t>(_cursor - _begin);
+				const std::size_t padding = (kArrayAlignment - offset % kArrayAlignment) % kArrayAlignment;
+				if (!_valid || static_cast<std::size_t>(_end - _cursor) < padding)
+					return _valid = false;
+				_cursor += padding;
+				return true;
+			}
+
+			template <typename Type>
+			bool ReadVector(std::vector<Type>& values)
+			{
+				static_assert(std::is_trivially_copyable<Type>::value, "Only trivially copyable types can be read as raw bytes");
+				static_assert(alignof(Type) <= kArrayAlignment, "Array element is over-aligned");
+				uint64_t count{ 0 };
+				if (!Read(count) || !Align() || count > static_cast<uint64_t>(_end - _cursor) / sizeof(Type))
+					return _valid = false;
+				//! Copy-construct from the mapping rather than zero-filling the storage first
+				const Type* first = reinterpret_cast<const Type*>(_cursor);
+				values.assign(first, first + count);
+				_cursor += count * sizeof(Type);
+				return true;
+			}
+
+			//! Point the view at the array in the mapping instead of copying it, the mapping must outlive the view
+			template <typename Type>
+			bool ReadView(ArrayView<Type>& view)
+			{
+				static_assert(std::is_trivially_copyable<Type>::value, "Only trivially copyable types can be read as raw bytes");
+				static_assert(alignof(Type) <= kArrayAlignment, "Array element is over-aligned");
+				uint64_t count{ 0 };
+				if (!Read(count) || !Align() || count > static_cast<uint64_t>(_end - _cursor) / sizeof(Type))
+					return _valid = false;
+				view = ArrayView<Type>(reinterpret_cast<const Type*>(_cursor), static_cast<std::size_t>(count));
+				_cursor += count * sizeof(Type);
+				return true;
+			}
+
+			bool ReadString(std::string& value)
+			{
+				uint64_t length{ 0 };
+				if (!Read(length) || length > static_cast<uint64_t>(_end - _cursor))
+					return _valid = false;
+				value.assign(reinterpret_cast<const char*>(_cursor), static_cast<std::size_t>(length));
+				_cursor += length;
+				return true;
+			}
+
+			//! Read the element count of the following array
+			bool ReadCount(std::size_t& count)
+			{
+				uint64_t value{ 0 };
+				if (!Read(value) || value > static_cast<uint64_t>(_end - _cursor))
+					return _valid = false;
+				count = static_cast<std::size_t>(value);
+				return true;
+			}
+		private:
+			const unsigned char* _begin;
+			const unsigned char* _cursor;
+			const unsigned char* _end;
+			bool _valid{ true };
+		};
+
+		//! Returns true if the cache was written for the given format and options from the current source files
+		bool ReadHeader(CacheReader& reader, const std::string& filename, VertexFormat format, const GLTFLoadOptions& options)
+		{
+			char magic[sizeof(kSceneCacheMagic)];
+			uint32_t version{ 0 }, cachedFormat{ 0 };
+			uint64_t optionsKey{ 0 };
+			if (!reader.ReadBytes(magic, sizeof(magic)) || std::memcmp(magic, kSceneCacheMagic, sizeof(magic)) != 0)
+				return false;
+			if (!reader.Read(version) || version != kSceneCacheVersion)
+				return false;
+			if (!reader.Read(cachedFormat) || cachedFormat != static_cast<uint32_t>(format))
+				return false;
+			if (!reader.Read(optionsKey) || optionsKey != GetOptionsKey(options))
+				return false;
+
+			std::size_t numDependencies{ 0 };
+			if (!reader.ReadCount(numDependencies))
+				return false;
+			std::vector<std::string> dependencies(numDependencies);
+			for (auto& dependency : dependencies)
+				reader.ReadString(dependency);
+
+			uint64_t cachedHash{ 0 };
+			return reader.Read(cachedHash) && cachedHash == HashDependencies(GetBaseDirectory(filename), dependencies);
+		}
+	};
+
+	std::string GLTFScene::GetSceneCachePath(const std::string& filename)
+	{
+		return filename + ".cache";
+	}
+
+	bool GLTFScene::SaveSceneCache(const std::string& filename, VertexFormat format, const GLTFLoadOptions& options, const tinygltf::Model& model, const std::vector<std::string>& dependencies) const
+	{
+		static_assert(std::is_trivially_copyable<GLTFMaterial>::value, "Material must be trivially copyable to be cached");
+		static_assert(std::is_trivially_copyable<GLTFChannel>::value, "Channel must be trivially copyable to be cached");
+
+		const uint64_t hash = HashDependencies(GetBaseDirectory(filename), dependencies);
+
+		//! Write to the temporary file first so that a killed process never leaves a broken cache
+		const std::string cachePath = GetSceneCachePath(filename);
+		const std::string tempPath = cachePath + ".tmp";
+		CacheWriter writer(tempPath);
+		if (!writer.IsValid())
+			return false;
+
+		//! Header
+		writer.WriteBytes(kSceneCacheMagic, sizeof(kSceneCacheMagic));
+		writer.Write(kSceneCacheVersion);
+		writer.Write(static_cast<uint32_t>(format));
+		writer.Write(GetOptionsKey(options));
+		writer.Write(static_cast<uint64_t>(dependencies.size()));
+		for (const auto& dependency : dependencies)
+			writer.WriteString(dependency);
+		writer.Write(hash);
+
+		//! Vertex streams
+		writer.WriteVector(_positions);
+		writer.WriteVector(_normals);
+		writer.WriteVector(_tangents);
+		writer.WriteVector(_colors);
+		writer.WriteVector(_texCoords);
+		writer.WriteVector(_indices);
+		writer.WriteVector(_skinJoints);
+		writer.WriteVector(_skinWeights);
+
+		for (const auto* stream : { &_quantizedPositions, &_quantizedNormals, &_quantizedTangents, &_quantizedColors, &_quantizedTexCoords })
+		{
+			writer.Write(stream->componentType);
+			writer.Write(stream->numComponents);
+			writer.Write(stream->normalized);
+			writer.Write(stream->elementSize);
+			writer.WriteVector(stream->data);
+		}
+
+		writer.Write(static_cast<uint64_t>(_scenePrimMeshes.size()));
+		for (const auto& primMesh : _scenePrimMeshes)
+		{
+			writer.Write(primMesh.firstIndex);
+			writer.Write(primMesh.indexCount);
+			writer.Write(primMesh.vertexOffset);
+			writer.Write(primMesh.vertexCount);
+			writer.Write(primMesh.materialIndex);
+			writer.Write(primMesh.min);
+			writer.Write(primMesh.max);
+			writer.WriteString(primMesh.name);
+			writer.WriteVector(primMesh.lods);
+			writer.Write(primMesh.morphTargetIndex);
+			writer.Write(primMesh.morphTargetCount);
+		}
+
+		writer.Write(static_cast<uint64_t>(_sceneNodes.size()));
+		for (const auto& node : _sceneNodes)
+		{
+			writer.Write(node.local);
+			writer.Write(node.translation);
+			writer.Write(node.scale);
+			writer.Write(node.rotation);
+			writer.WriteVector(node.primMeshes);
+			writer.WriteVector(node.childNodes);
+			writer.Write(node.nodeIndex);
+			writer.Write(node.subtreeEnd);
+			writer.Write(node.skin);
+			writer.Write(node.weightIndex);
+			writer.Write(node.weightCount);
+		}
+		writer.WriteVector(_nodeWorlds);
+		writer.WriteVector(_nodeTransforms);
+		writer.WriteVector(_nodeParents);
+
+		writer.WriteVector(_sceneMaterials);
+
+		writer.Write(static_cast<uint64_t>(_sceneCameras.size()));
+		for (const auto& camera : _sceneCameras)
+		{
+			writer.Write(camera.world);
+			writer.Write(camera.eye);
+			writer.Write(camera.center);
+			writer.Write(camera.up);
+			writer.WriteString(camera.camera.name);
+			writer.WriteString(camera.camera.type);
+			writer.Write(camera.camera.perspective.aspectRatio);
+			writer.Write(camera.camera.perspective.yfov);
+			writer.Write(camera.camera.perspective.zfar);
+			writer.Write(camera.camera.perspective.znear);
+			writer.Write(camera.camera.orthographic.xmag);
+			writer.Write(camera.camera.orthographic.ymag);
+			writer.Write(camera.camera.orthographic.zfar);
+			writer.Write(camera.camera.orthographic.znear);
+		}
+
+		writer.Write(static_cast<uint64_t>(_sceneLights.size()));
+		for (const auto& light : _sceneLights)
+		{
+			writer.Write(light.world);
+			writer.WriteString(light.light.name);
+			writer.WriteString(light.light.type);
+			writer.WriteVector(light.light.color);
+			writer.Write(light.light.intensity);
+			writer.Write(light.light.range);
+			writer.Write(light.light.spot.innerConeAngle);
+			writer.Write(light.light.spot.outerConeAngle);
+		}
+
+		writer.Write(static_cast<uint64_t>(_sceneAnims.size()));
+		for (const auto& anim : _sceneAnims)
+		{
+			writer.WriteString(anim.name);
+			writer.Write(anim.samplerIndex);
+			writer.Write(anim.samplerCount);
+			writer.Write(anim.channelIndex);
+			writer.Write(anim.channelCount);
+			writer.Write(anim.duration);
+		}
+
+		writer.Write(static_cast<uint64_t>(_sceneSamplers.size()));
+		for (const auto& sampler : _sceneSamplers)
+		{
+			writer.Write(sampler.interpolation);
+			writer.WriteVector(sampler.inputs);
+			writer.WriteVector(sampler.outputs);
+		}
+
+		writer.WriteVector(_sceneChannels);
+
+		writer.Write(static_cast<uint64_t>(_sceneSkins.size()));
+		for (const auto& skin : _sceneSkins)
+		{
+			writer.WriteString(skin.name);
+			writer.Write(skin.jointIndex);
+			writer.Write(skin.jointCount);
+		}
+		writer.WriteVector(_jointNodes);
+		writer.WriteVector(_inverseBindMatrices);
+		writer.WriteVector(_morphTargets);
+		writer.WriteVector(_morphDeltas);
+		writer.WriteVector(_morphWeights);
+		writer.Write(_sceneDim);
+
+		//! Decoded images come last, they are handed to the callback only after
+		//! the whole scene state is read successfully.
+		writer.Write(static_cast<uint64_t>(model.images.size()));
+		for (const auto& image : model.images)
+		{
+			writer.WriteString(image.name);
+			writer.Write(image.width);
+			writer.Write(image.height);
+			writer.Write(image.component);
+			writer.Write(image.bits);
+			writer.Write(image.pixel_type);
+			writer.WriteVector(image.image);
+		}
+
+		const bool bWritten = writer.IsValid();
+		writer.Close();
+		std::remove(cachePath.c_str());
+		if (!bWritten || std::rename(tempPath.c_str(), cachePath.c_str()) != 0)
+		{
+			std::remove(tempPath.c_str());
+			return false;
+		}
+
+		return true;
+	}
+
+	bool GLTFScene::LoadSceneCache(const std::string& filename, VertexFormat format, const GLTFLoadOptions& options, const ImageCallback& imageCallback)
+	{
+		//! Kept mapped until the streams are released, the pages are faulted in by the upload only
+		if (!_sceneCacheFile.Open(GetSceneCachePath(filename)))
+			return false;
+
+		CacheReader reader(_sceneCacheFile.GetData(), _sceneCacheFile.GetSize());
+		if (!ReadHeader(reader, filename, format, options))
+		{
+			//! Unmapped before the cold load rewrites the file
+			_sceneCacheFile.Close();
+			return false;
+		}
+
+		//! Vertex streams
+		reader.ReadView(_mappedPositions);
+		reader.ReadView(_mappedNormals);
+		reader.ReadView(_mappedTangents);
+		reader.ReadView(_mappedColors);
+		reader.ReadView(_mappedTexCoords);
+		reader.ReadView(_mappedIndices);
+		reader.ReadView(_mappedSkinJoints);
+		reader.ReadView(_mappedSkinWeights);
+
+		for (auto* stream : { &_quantizedPositions, &_quantizedNormals, &_quantizedTangents, &_quantizedColors, &_quantizedTexCoords })
+		{
+			reader.Read(stream->componentType);
+			reader.Read(stream->numComponents);
+			reader.Read(stream->normalized);
+			reader.Read(stream->elementSize);
+			reader.ReadView(stream->mappedData);
+		}
+
+		std::size_t count{ 0 };
+		reader.ReadCount(count);
+		_scenePrimMeshes.resize(count);
+		for (auto& primMesh : _scenePrimMeshes)
+		{
+			reader.Read(primMesh.firstIndex);
+			reader.Read(primMesh.indexCount);
+			reader.Read(primMesh.vertexOffset);
+			reader.Read(primMesh.vertexCount);
+			reader.Read(primMesh.materialIndex);
+			reader.Read(primMesh.min);
+			reader.Read(primMesh.max);
+			reader.ReadString(primMesh.name);
+			reader.ReadVector(primMesh.lods);
+			reader.Read(primMesh.morphTargetIndex);
+			reader.Read(primMesh.morphTargetCount);
+		}
+
+		reader.ReadCount(count);
+		_sceneNodes.resize(count);
+		for (auto& node : _sceneNodes)
+		{
+			reader.Read(node.local);
+			reader.Read(node.translation);
+			reader.Read(node.scale);
+			reader.Read(node.rotation);
+			reader.ReadVector(node.primMeshes);
+			reader.ReadVector(node.childNodes);
+			reader.Read(node.nodeIndex);
+			reader.Read(node.subtreeEnd);
+			reader.Read(node.skin);
+			reader.Read(node.weightIndex);
+			reader.Read(node.weightCount);
+		}
+		reader.ReadVector(_nodeWorlds);
+		reader.ReadVector(_nodeTransforms);
+		reader.ReadVector(_nodeParents);
+
+		reader.ReadVector(_sceneMaterials);
+
+		reader.ReadCount(count);
+		_sceneCameras.resize(count);
+		for (auto& camera : _sceneCameras)
+		{
+			reader.Read(camera.world);
+			reader.Read(camera.eye);
+			reader.Read(camera.center);
+			reader.Read(camera.up);
+			reader.ReadString(camera.camera.name);
+			reader.ReadString(camera.camera.type);
+			reader.Read(camera.camera.perspective.aspectRatio);
+			reader.Read(camera.camera.perspective.yfov);
+			reader.Read(camera.camera.perspective.zfar);
+			reader.Read(camera.camera.perspective.znear);
+			reader.Read(camera.camera.orthographic.xmag);
+			reader.Read(camera.camera.orthographic.ymag);
+			reader.Read(camera.camera.orthographic.zfar);
+			reader.Read(camera.camera.orthographic.znear);
+		}
+
+		reader.ReadCount(count);
+		_sceneLights.resize(count);
+		for (auto& light : _sceneLights)
+		{
+			reader.Read(light.world);
+			reader.ReadString(light.light.name);
+			reader.ReadString(light.light.type);
+			reader.ReadVector(light.light.color);
+			reader.Read(light.light.intensity);
+			reader.Read(light.light.range);
+			reader.Read(light.light.spot.innerConeAngle);
+			reader.Read(light.light.spot.outerConeAngle);
+		}
+
+		reader.ReadCount(count);
+		_sceneAnims.resize(count);
+		for (auto& anim : _sceneAnims)
+		{
+			reader.ReadString(anim.name);
+			reader.Read(anim.samplerIndex);
+			reader.Read(anim.samplerCount);
+			reader.Read(anim.channelIndex);
+			reader.Read(anim.channelCount);
+			reader.Read(anim.duration);
+		}
+
+		reader.ReadCount(count);
+		_sceneSamplers.resize(count);
+		for (auto& sampler : _sceneSamplers)
+		{
+			reader.Read(sampler.interpolation);
+			reader.ReadVector(sampler.inputs);
+			reader.ReadVector(sampler.outputs);
+		}
+
+		reader.ReadVector(_sceneChannels);
+
+		reader.ReadCount(count);
+		_sceneSkins.resize(count);
+		for (auto& skin : _sceneSkins)
+		{
+			reader.ReadString(skin.name);
+			reader.Read(skin.jointIndex);
+			reader.Read(skin.jointCount);
+		}
+		reader.ReadVector(_jointNodes);
+		reader.ReadVector(_inverseBindMatrices);
+		reader.ReadVector(_morphTargets);
+		reader.ReadView(_mappedMorphDeltas);
+		reader.ReadVector(_morphWeights);
+		reader.Read(_sceneDim);
+
+		//! The pixels are read in place as well, they are uploaded by the callback
+		std::vector<GLTFImage> images;
+		if (reader.ReadCount(count))
+			images.resize(count);
+		for (auto& image : images)
+		{
+			reader.ReadString(image.name);
+			reader.Read(image.width);
+			reader.Read(image.height);
+			reader.Read(image.component);
+			reader.Read(image.bits);
+			reader.Read(image.pixelType);
+			reader.ReadView(image.pixels);
+		}
+
+		//! The pixels are read by the callback, at least the described image must be there.
+		//! The images which failed to load are kept without the pixels like the cold load passes them.
+		bool bImagesValid = true;
+		for (const auto& image : images)
+		{
+			if (image.width <= 0 || image.height <= 0 || image.component <= 0 || image.bits <= 0)
+			{
+				bImagesValid &= image.pixels.empty();
+				continue;
+			}
+			const uint64_t numBytes = static_cast<uint64_t>(image.width) * static_cast<uint64_t>(image.height) *
+									  static_cast<uint64_t>(image.component) * static_cast<uint64_t>((image.bits + 7) / 8);
+			bImagesValid &= image.pixels.size() >= numBytes;
+		}
+
+		if (!reader.IsValid() || !bImagesValid || !ValidateSceneCache(format))
+		{
+			//! Truncated or corrupted cache, fall back to the scene file
+			std::clog << "[GLTFScene::LoadSceneCache] Ignore the corrupted cache of " << filename << std::endl;
+			ReleaseSourceData();
+			_sceneMaterials.clear();
+			_scenePrimMeshes.clear();
+			_sceneNodes.clear();
+			_nodeWorlds.clear();
+			_nodeTransforms.clear();
+			_nodeParents.clear();
+			_sceneCameras.clear();
+			_sceneLights.clear();
+			_sceneAnims.clear();
+			_sceneSamplers.clear();
+			_sceneChannels.clear();
+			_sceneSkins.clear();
+			_jointNodes.clear();
+			_inverseBindMatrices.clear();
+			_morphTargets.clear();
+			_morphWeights.clear();
+			_sceneDim = SceneDimension();
+			return false;
+		}
+
+		if (imageCallback != nullptr)
+		{
+			for (const auto& image : images)
+				imageCallback(image);
+		}
+
+		return true;
+	}
+
+	bool GLTFScene::ValidateSceneCache(VertexFormat format) const
+	{
+		//! [first, first + count) within [0, size), in 64 bits so that the corrupted values can't wrap around
+		auto isRange = [](int64_t first, int64_t count, std::size_t size) {
+			return first >= 0 && count >= 0 && static_cast<uint64_t>(first + count) <= size;
+		};
+		auto isIndex = [](int64_t index, std::size_t size) {
+			return index >= 0 && static_cast<uint64_t>(index) < size;
+		};
+
+		//! Every stream holds one element per vertex or nothing, the streams of the format are there in either form
+		const std::size_t numVertices = GetPositions().size();
+		auto isStream = [numVertices](std::size_t size, const GLTFQuantizedStream& quantized) {
+			const auto data = quantized.GetData();
+			const bool bFloats = size == 0 || size == numVertices;
+			const bool bQuantized = data.empty() || (quantized.numComponents >= 1 && quantized.numComponents <= 4 &&
+													 data.size() == static_cast<uint64_t>(numVertices) * quantized.elementSize);
+			return bFloats && bQuantized;
+		};
+		auto isPresent = [format](VertexFormat attribute, std::size_t size, const GLTFQuantizedStream& quantized) {
+			return !static_cast<int>(format & attribute) || size > 0 || !quantized.GetData().empty();
+		};
+		if (!isStream(GetPositions().size(), _quantizedPositions) || !isStream(GetNormals().size(), _quantizedNormals) ||
+			!isStream(GetTangents().size(), _quantizedTangents) || !isStream(GetColors().size(), _quantizedColors) ||
+			!isStream(GetTexCoords().size(), _quantizedTexCoords))
+			return false;
+		if (!isPresent(VertexFormat::Position3, GetPositions().size(), _quantizedPositions) ||
+			!isPresent(VertexFormat::Normal3, GetNormals().size(), _quantizedNormals) ||
+			!isPresent(VertexFormat::Tangent4, GetTangents().size(), _quantizedTangents) ||
+			!isPresent(VertexFormat::Color4, GetColors().size(), _quantizedColors) ||
+			!isPresent(VertexFormat::TexCoord2, GetTexCoords().size(), _quantizedTexCoords))
+			return false;
+		if (GetSkinJoints().size() != GetSkinWeights().size() || (!GetSkinJoints().empty() && GetSkinJoints().size() != numVertices))
+			return false;
+
+		const std::size_t numIndices = GetIndices().size();
+		for (const auto& primMesh : _scenePrimMeshes)
+		{
+			if (!isRange(primMesh.firstIndex, primMesh.indexCount, numIndices) || !isRange(primMesh.vertexOffset, primMesh.vertexCount, numVertices) ||
+				!isRange(primMesh.morphTargetIndex, primMesh.morphTargetCount, _morphTargets.size()))
+				return false;
+			if (!_sceneMaterials.empty() && !isIndex(primMesh.materialIndex, _sceneMaterials.size()))
+				return false;
+			for (const auto& lod : primMesh.lods)
+			{
+				if (!isRange(lod.firstIndex, lod.indexCount, numIndices))
+					return false;
+			}
+		}
+
+		//! The alpha mode selects the render pass
+		for (const auto& material : _sceneMaterials)
+		{
+			if (material.alphaMode < 0 || material.alphaMode > 2)
+				return false;
+		}
+
+		//! The nodes are stored in the parent-before-child order, each subtree is the range after its root
+		const std::size_t numNodes = _sceneNodes.size();
+		if (_nodeWorlds.size() != numNodes || _nodeTransforms.size() != numNodes || _nodeParents.size() != numNodes)
+			return false;
+		for (std::size_t i = 0; i < numNodes; ++i)
+		{
+			const auto& node = _sceneNodes[i];
+			if (_nodeParents[i] < -1 || _nodeParents[i] >= static_cast<int>(i) || node.subtreeEnd <= static_cast<int>(i) ||
+				static_cast<std::size_t>(node.subtreeEnd) > numNodes)
+				return false;
+			if ((node.skin != -1 && !isIndex(node.skin, _sceneSkins.size())) || !isRange(node.weightIndex, node.weightCount, _morphWeights.size()))
+				return false;
+			for (unsigned int primMesh : node.primMeshes)
+			{
+				if (primMesh >= _scenePrimMeshes.size())
+					return false;
+			}
+			for (int child : node.childNodes)
+			{
+				if (child <= static_cast<int>(i) || child >= node.subtreeEnd)
+					return false;
+			}
+		}
+
+		if (_inverseBindMatrices.size() != _jointNodes.size())
+			return false;
+		for (const auto& skin : _sceneSkins)
+		{
+			if (!isRange(skin.jointIndex, skin.jointCount, _jointNodes.size()))
+				return false;
+		}
+		for (int jointNode : _jointNodes)
+		{
+			if (jointNode != -1 && !isIndex(jointNode, numNodes))
+				return false;
+		}
+
+		//! The deltas are scattered to their vertices by the GPU
+		const auto morphDeltas = GetMorphDeltas();
+		for (const auto& target : _morphTargets)
+		{
+			for (const GLTFMorphRange* range : { &target.position, &target.normal, &target.tangent })
+			{
+				if (!isRange(range->offset, range->count, morphDeltas.size()))
+					return false;
+			}
+		}
+		for (const auto& delta : morphDeltas)
+		{
+			if (delta.vertex >= numVertices)
+				return false;
+		}
+
+		for (const auto& anim : _sceneAnims)
+		{
+			if (!isRange(anim.samplerIndex, anim.samplerCount, _sceneSamplers.size()) || !isRange(anim.channelIndex, anim.channelCount, _sceneChannels.size()))
+				return false;
+		}
+		for (const auto& sampler : _sceneSamplers)
+		{
+			const int interpolation = static_cast<int>(sampler.interpolation);
+			if (interpolation < 0 || interpolation > static_cast<int>(GLTFSampler::Interpolation::Cubicspline))
+				return false;
+		}
+		for (const auto& channel : _sceneChannels)
+		{
+			const int path = static_cast<int>(channel.path);
+			if (path < 0 || path > static_cast<int>(GLTFChannel::Path::Weights) || !isIndex(channel.samplerIndex, _sceneSamplers.size()) ||
+				!isIndex(channel.nodeIndex, numNodes))
+				return false;
+		}
+
+		return true;
+	}
+
+};
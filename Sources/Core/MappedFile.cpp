@@ -0,0 +1,108 @@
+#include <Core/MappedFile.hpp>
+#include <Core/Macros.hpp>
+
+#if defined(WINDOWS)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Core {
+
+	MappedFile::MappedFile()
+	{
+		//! Do nothing
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	bool MappedFile::Open(const std::string& path)
+	{
+		Close();
+
+#if defined(WINDOWS)
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (data == nullptr)
+		{
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+
+		_fileHandle = file;
+		_mappingHandle = mapping;
+		_data = static_cast<const unsigned char*>(data);
+		_size = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			return false;
+
+		struct stat fileStat;
+		if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+		{
+			close(fd);
+			return false;
+		}
+
+		void* data = mmap(nullptr, static_cast<std::size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		//! The mapping keeps it's own reference to the file
+		close(fd);
+		if (data == MAP_FAILED)
+			return false;
+
+		_data = static_cast<const unsigned char*>(data);
+		_size = static_cast<std::size_t>(fileStat.st_size);
+#endif
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (_data == nullptr)
+			return;
+
+#if defined(WINDOWS)
+		UnmapViewOfFile(_data);
+		CloseHandle(static_cast<HANDLE>(_mappingHandle));
+		CloseHandle(static_cast<HANDLE>(_fileHandle));
+		_mappingHandle = nullptr;
+		_fileHandle = nullptr;
+#else
+		munmap(const_cast<unsigned char*>(_data), _size);
+#endif
+		_data = nullptr;
+		_size = 0;
+	}
+
+};
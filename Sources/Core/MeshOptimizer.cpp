@@ -0,0 +1,562 @@
+#include <Core/MeshOptimizer.hpp>
+#include <glm/geometric.hpp>
+#include <glm/vec3.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+namespace Core {
+
+	namespace
+	{
+		//!
+		//! \brief      FIFO vertex cache simulated with the timestamps
+		//!
+		//! A vertex is in the cache while less than cacheSize vertices were inserted after it.
+		//!
+		class VertexCacheSimulator
+		{
+		public:
+			VertexCacheSimulator(std::size_t vertexCount, unsigned int cacheSize)
+				: _timestamps(vertexCount, 0), _cacheSize(cacheSize), _time(cacheSize + 1)
+			{
+				//! Do nothing
+			}
+			//! Returns whether the vertex was missed and inserted
+			bool Access(unsigned int vertex)
+			{
+				if (_time - _timestamps[vertex] <= _cacheSize)
+					return false;
+				_timestamps[vertex] = _time++;
+				return true;
+			}
+			//! Returns the number of missed vertices of the triangle
+			unsigned int AccessTriangle(const unsigned int* triangle)
+			{
+				return static_cast<unsigned int>(Access(triangle[0])) + Access(triangle[1]) + Access(triangle[2]);
+			}
+			//! Evict every vertex
+			void Flush()
+			{
+				_time += _cacheSize + 1;
+			}
+			//! Returns the age of the vertex in the cache, larger than cacheSize if it is not cached
+			unsigned int GetAge(unsigned int vertex) const
+			{
+				return _time - _timestamps[vertex];
+			}
+		private:
+			std::vector<unsigned int> _timestamps;
+			unsigned int _cacheSize;
+			unsigned int _time;
+		};
+
+		//! Sum of the weighted squared distances to the planes, the weights are accumulated in w
+		struct Quadric
+		{
+			double a00{ 0.0 }, a01{ 0.0 }, a02{ 0.0 }, a11{ 0.0 }, a12{ 0.0 }, a22{ 0.0 };
+			double b0{ 0.0 }, b1{ 0.0 }, b2{ 0.0 };
+			double c{ 0.0 };
+			double w{ 0.0 };
+
+			//! Add the plane dot(normal, p) + d = 0 with the given weight
+			void AddPlane(const glm::dvec3& normal, double d, double weight)
+			{
+				a00 += weight * normal.x * normal.x;
+				a01 += weight * normal.x * normal.y;
+				a02 += weight * normal.x * normal.z;
+				a11 += weight * normal.y * normal.y;
+				a12 += weight * normal.y * normal.z;
+				a22 += weight * normal.z * normal.z;
+				b0 += weight * normal.x * d;
+				b1 += weight * normal.y * d;
+				b2 += weight * normal.z * d;
+				c += weight * d * d;
+				w += weight;
+			}
+
+			Quadric& operator+=(const Quadric& other)
+			{
+				a00 += other.a00; a01 += other.a01; a02 += other.a02;
+				a11 += other.a11; a12 += other.a12; a22 += other.a22;
+				b0 += other.b0; b1 += other.b1; b2 += other.b2;
+				c += other.c;
+				w += other.w;
+				return *this;
+			}
+
+			//! Returns the weighted mean of the squared distances
+			double Evaluate(const glm::vec3& p) const
+			{
+				if (w <= 0.0)
+					return 0.0;
+				const double x = p.x, y = p.y, z = p.z;
+				const double error = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+								   + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+				return std::max(error, 0.0) / w;
+			}
+		};
+
+		//! Returns the representative vertex of each vertex, the smallest index sharing the position
+		std::vector<unsigned int> WeldPositions(const glm::vec3* positions, std::size_t vertexCount)
+		{
+			auto less = [positions](unsigned int lhs, unsigned int rhs) {
+				const int order = std::memcmp(&positions[lhs], &positions[rhs], sizeof(glm::vec3));
+				return order != 0 ? order < 0 : lhs < rhs;
+			};
+			std::vector<unsigned int> order(vertexCount), representatives(vertexCount);
+			std::iota(order.begin(), order.end(), 0u);
+			std::sort(order.begin(), order.end(), less);
+
+			for (std::size_t i = 0; i < vertexCount; ++i)
+			{
+				const bool sameAsPrevious = i > 0 && std::memcmp(&positions[order[i]], &positions[order[i - 1]], sizeof(glm::vec3)) == 0;
+				representatives[order[i]] = sameAsPrevious ? representatives[order[i - 1]] : order[i];
+			}
+			return representatives;
+		}
+	};
+
+	VertexCacheStatistics AnalyzeVertexCache(const unsigned int* indices, std::size_t indexCount, std::size_t vertexCount, unsigned int cacheSize)
+	{
+		VertexCacheStatistics statistics;
+		VertexCacheSimulator cache(vertexCount, cacheSize);
+		for (std::size_t i = 0; i < indexCount; ++i)
+			statistics.vertexTransforms += cache.Access(indices[i]);
+
+		if (indexCount >= 3)
+			statistics.acmr = static_cast<float>(statistics.vertexTransforms) / static_cast<float>(indexCount / 3);
+		if (vertexCount > 0)
+			statistics.atvr = static_cast<float>(statistics.vertexTransforms) / static_cast<float>(vertexCount);
+		return statistics;
+	}
+
+	void OptimizeVertexCache(unsigned int* dst, const unsigned int* src, std::size_t indexCount, std::size_t vertexCount, unsigned int cacheSize)
+	{
+		const std::size_t numTriangles = indexCount / 3;
+		if (numTriangles == 0)
+			return;
+
+		//! Triangles adjacent to each vertex, liveCount is the number of the non-emitted ones
+		std::vector<unsigned int> liveCount(vertexCount, 0), adjacencyOffsets(vertexCount + 1, 0);
+		for (std::size_t i = 0; i < numTriangles * 3; ++i)
+			++liveCount[src[i]];
+		std::partial_sum(liveCount.begin(), liveCount.end(), adjacencyOffsets.begin() + 1);
+
+		std::vector<unsigned int> adjacency(numTriangles * 3), cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (std::size_t i = 0; i < numTriangles * 3; ++i)
+			adjacency[cursors[src[i]]++] = static_cast<unsigned int>(i / 3);
+
+		VertexCacheSimulator cache(vertexCount, cacheSize);
+		std::vector<unsigned char> emitted(numTriangles, 0);
+		std::vector<unsigned int> deadEnd, candidates;
+		deadEnd.reserve(numTriangles * 3);
+
+		std::size_t numEmitted = 0, scanCursor = 0;
+		long long fanning = src[0];
+		while (fanning >= 0)
+		{
+			//! Emit every remaining triangle around the fanning vertex
+			candidates.clear();
+			for (unsigned int k = adjacencyOffsets[fanning]; k < adjacencyOffsets[fanning + 1]; ++k)
+			{
+				const unsigned int triangle = adjacency[k];
+				if (emitted[triangle])
+					continue;
+
+				for (int c = 0; c < 3; ++c)
+				{
+					const unsigned int vertex = src[triangle * 3 + c];
+					dst[numEmitted++] = vertex;
+					deadEnd.push_back(vertex);
+					candidates.push_back(vertex);
+					--liveCount[vertex];
+					cache.Access(vertex);
+				}
+				emitted[triangle] = 1;
+			}
+
+			//! Prefer the oldest candidate which stays in the cache while its triangles are emitted
+			fanning = -1;
+			unsigned int bestPriority = 0;
+			for (unsigned int vertex : candidates)
+			{
+				if (liveCount[vertex] == 0)
+					continue;
+				const unsigned int age = cache.GetAge(vertex);
+				const unsigned int priority = age + 2 * liveCount[vertex] <= cacheSize ? age + 1 : 1;
+				if (priority > bestPriority)
+				{
+					fanning = vertex;
+					bestPriority = priority;
+				}
+			}
+
+			//! Then the most recently referenced vertex, then the next one in the input order
+			while (fanning < 0 && !deadEnd.empty())
+			{
+				const unsigned int vertex = deadEnd.back();
+				deadEnd.pop_back();
+				if (liveCount[vertex] > 0)
+					fanning = vertex;
+			}
+			while (fanning < 0 && scanCursor < vertexCount)
+			{
+				if (liveCount[scanCursor] > 0)
+					fanning = static_cast<long long>(scanCursor);
+				++scanCursor;
+			}
+		}
+
+		//! Incomplete trailing triangle is kept as it is
+		std::copy(src + numTriangles * 3, src + indexCount, dst + numTriangles * 3);
+	}
+
+	void OptimizeOverdraw(unsigned int* dst, const unsigned int* src, std::size_t indexCount, const glm::vec3* positions,
+						  std::size_t vertexCount, float threshold, unsigned int cacheSize)
+	{
+		const std::size_t numTriangles = indexCount / 3;
+		std::copy(src + numTriangles * 3, src + indexCount, dst + numTriangles * 3);
+		if (numTriangles == 0)
+			return;
+
+		VertexCacheSimulator cache(vertexCount, cacheSize);
+
+		//! Hard boundaries : triangles missing every vertex, the cache is effectively flushed there
+		std::vector<std::size_t> hardBoundaries;
+		for (std::size_t t = 0; t < numTriangles; ++t)
+		{
+			if (cache.AccessTriangle(src + t * 3) == 3 || t == 0)
+				hardBoundaries.push_back(t);
+		}
+		hardBoundaries.push_back(numTriangles);
+
+		//! Soft boundaries : split the hard clusters while the ACMR of the pieces stays near the original
+		std::vector<std::size_t> clusters;
+		for (std::size_t h = 0; h + 1 < hardBoundaries.size(); ++h)
+		{
+			const std::size_t begin = hardBoundaries[h], end = hardBoundaries[h + 1];
+
+			cache.Flush();
+			unsigned int misses = 0;
+			for (std::size_t t = begin; t < end; ++t)
+				misses += cache.AccessTriangle(src + t * 3);
+			const float clusterThreshold = threshold * static_cast<float>(misses) / static_cast<float>(end - begin);
+
+			clusters.push_back(begin);
+			cache.Flush();
+			unsigned int runningMisses = 0, runningTriangles = 0;
+			for (std::size_t t = begin; t + 1 < end; ++t)
+			{
+				runningMisses += cache.AccessTriangle(src + t * 3);
+				++runningTriangles;
+				if (static_cast<float>(runningMisses) <= clusterThreshold * static_cast<float>(runningTriangles))
+				{
+					clusters.push_back(t + 1);
+					cache.Flush();
+					runningMisses = runningTriangles = 0;
+				}
+			}
+		}
+		clusters.push_back(numTriangles);
+
+		//! Area weighted centroid and normal of each cluster
+		const std::size_t numClusters = clusters.size() - 1;
+		std::vector<glm::vec3> centroids(numClusters, glm::vec3(0.0f)), normals(numClusters, glm::vec3(0.0f));
+		std::vector<float> areas(numClusters, 0.0f);
+		glm::vec3 meshCentroid(0.0f);
+		float meshArea = 0.0f;
+		for (std::size_t c = 0; c < numClusters; ++c)
+		{
+			for (std::size_t t = clusters[c]; t < clusters[c + 1]; ++t)
+			{
+				const glm::vec3& p0 = positions[src[t * 3 + 0]];
+				const glm::vec3& p1 = positions[src[t * 3 + 1]];
+				const glm::vec3& p2 = positions[src[t * 3 + 2]];
+				const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+				const float area = glm::length(normal);
+
+				centroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+				normals[c] += normal;
+				areas[c] += area;
+			}
+			meshCentroid += centroids[c];
+			meshArea += areas[c];
+			if (areas[c] > 0.0f)
+				centroids[c] /= areas[c];
+		}
+		if (meshArea > 0.0f)
+			meshCentroid /= meshArea;
+
+		std::vector<float> sortKeys(numClusters, 0.0f);
+		for (std::size_t c = 0; c < numClusters; ++c)
+		{
+			const float length = glm::length(normals[c]);
+			if (length > 0.0f)
+				sortKeys[c] = glm::dot(centroids[c] - meshCentroid, normals[c] / length);
+		}
+
+		std::vector<std::size_t> order(numClusters);
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&](std::size_t lhs, std::size_t rhs) {
+			return sortKeys[lhs] > sortKeys[rhs];
+		});
+
+		unsigned int* out = dst;
+		for (std::size_t c : order)
+			out = std::copy(src + clusters[c] * 3, src + clusters[c + 1] * 3, out);
+	}
+
+	std::size_t BuildVertexFetchRemap(unsigned int* remap, const unsigned int* indices, std::size_t indexCount, std::size_t vertexCount)
+	{
+		constexpr unsigned int kUnused = ~0u;
+		std::fill(remap, remap + vertexCount, kUnused);
+
+		unsigned int next = 0;
+		for (std::size_t i = 0; i < indexCount; ++i)
+		{
+			if (remap[indices[i]] == kUnused)
+				remap[indices[i]] = next++;
+		}
+
+		const std::size_t numReferenced = next;
+		for (std::size_t v = 0; v < vertexCount; ++v)
+		{
+			if (remap[v] == kUnused)
+				remap[v] = next++;
+		}
+		return numReferenced;
+	}
+
+	std::size_t SimplifyMesh(unsigned int* dst, const unsigned int* indices, std::size_t indexCount, const glm::vec3* positions,
+							 std::size_t vertexCount, std::size_t targetIndexCount, float maxError, float* resultError)
+	{
+		//! Border planes are weighted over the faces to keep the silhouette of the open borders
+		constexpr double kBorderWeight = 10.0;
+		//! Collapses rotating any triangle more than about 75 degrees are rejected
+		constexpr double kMinNormalCosine = 0.25;
+		constexpr unsigned int kNoCollapse = ~0u;
+
+		float error = 0.0f;
+		const std::vector<unsigned int> representatives = WeldPositions(positions, vertexCount);
+
+		//! Triangles collapsed in the welded space are dropped
+		std::vector<unsigned int> triangles(indices, indices + indexCount / 3 * 3);
+		auto removeDegenerates = [&]() {
+			std::size_t numKept = 0;
+			for (std::size_t t = 0; t < triangles.size(); t += 3)
+			{
+				const unsigned int r0 = representatives[triangles[t]], r1 = representatives[triangles[t + 1]], r2 = representatives[triangles[t + 2]];
+				if (r0 == r1 || r1 == r2 || r2 == r0)
+					continue;
+				std::copy(triangles.begin() + t, triangles.begin() + t + 3, triangles.begin() + numKept);
+				numKept += 3;
+			}
+			triangles.resize(numKept);
+		};
+		removeDegenerates();
+
+		//! Triangles around each representative
+		std::vector<unsigned int> adjacencyOffsets(vertexCount + 1), adjacency, cursors;
+		auto buildAdjacency = [&]() {
+			std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+			for (unsigned int index : triangles)
+				++adjacencyOffsets[representatives[index] + 1];
+			std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+			adjacency.resize(triangles.size());
+			cursors.assign(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (std::size_t i = 0; i < triangles.size(); ++i)
+				adjacency[cursors[representatives[triangles[i]]]++] = static_cast<unsigned int>(i / 3);
+		};
+		//! The existing edge is on the border if no triangle around it has the reverse edge
+		auto isBorderEdge = [&](unsigned int from, unsigned int to) {
+			for (unsigned int k = adjacencyOffsets[from]; k < adjacencyOffsets[from + 1]; ++k)
+			{
+				const unsigned int* triangle = triangles.data() + adjacency[k] * 3;
+				for (int c = 0; c < 3; ++c)
+				{
+					if (representatives[triangle[c]] == to && representatives[triangle[(c + 1) % 3]] == from)
+						return false;
+				}
+			}
+			return true;
+		};
+		auto getNormal = [](const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2) {
+			return glm::cross(glm::dvec3(p1) - glm::dvec3(p0), glm::dvec3(p2) - glm::dvec3(p0));
+		};
+
+		//! Initial quadrics of the faces and the border planes perpendicular to them
+		std::vector<Quadric> quadrics(vertexCount);
+		buildAdjacency();
+		for (std::size_t t = 0; t < triangles.size(); t += 3)
+		{
+			const unsigned int r[3] = { representatives[triangles[t]], representatives[triangles[t + 1]], representatives[triangles[t + 2]] };
+			glm::dvec3 normal = getNormal(positions[r[0]], positions[r[1]], positions[r[2]]);
+			const double length = glm::length(normal);
+			if (length == 0.0)
+				continue;
+			normal /= length;
+
+			const double d = -glm::dot(normal, glm::dvec3(positions[r[0]]));
+			for (int k = 0; k < 3; ++k)
+				quadrics[r[k]].AddPlane(normal, d, length * 0.5);
+
+			for (int k = 0; k < 3; ++k)
+			{
+				const unsigned int from = r[k], to = r[(k + 1) % 3];
+				if (!isBorderEdge(from, to))
+					continue;
+				const glm::dvec3 edge = glm::dvec3(positions[to]) - glm::dvec3(positions[from]);
+				glm::dvec3 borderNormal = glm::cross(edge, normal);
+				const double borderLength = glm::length(borderNormal);
+				if (borderLength == 0.0)
+					continue;
+				borderNormal /= borderLength;
+
+				const double borderD = -glm::dot(borderNormal, glm::dvec3(positions[from]));
+				const double weight = glm::dot(edge, edge) * kBorderWeight;
+				quadrics[from].AddPlane(borderNormal, borderD, weight);
+				quadrics[to].AddPlane(borderNormal, borderD, weight);
+			}
+		}
+
+		struct Collapse
+		{
+			unsigned int from;
+			unsigned int to;
+			float error;
+		};
+		std::vector<Collapse> candidates;
+		std::vector<unsigned int> collapseTargets(vertexCount, kNoCollapse), collapsed;
+		std::vector<unsigned char> borders(vertexCount), locked(vertexCount), borderEdges;
+
+		//! Every pass collapses the cheapest edges whose neighborhoods do not overlap
+		while (triangles.size() > targetIndexCount)
+		{
+			buildAdjacency();
+
+			//! Border flag of each directed edge of the triangles
+			std::fill(borders.begin(), borders.end(), 0);
+			borderEdges.resize(triangles.size());
+			for (std::size_t i = 0; i < triangles.size(); ++i)
+			{
+				const unsigned int from = representatives[triangles[i]], to = representatives[triangles[i - i % 3 + (i + 1) % 3]];
+				borderEdges[i] = isBorderEdge(from, to);
+				if (borderEdges[i])
+					borders[from] = borders[to] = 1;
+			}
+
+			candidates.clear();
+			auto addCandidate = [&](unsigned int from, unsigned int to, bool borderEdge) {
+				if (borders[from] && !(borders[to] && borderEdge))
+					return;
+				Quadric quadric = quadrics[from];
+				quadric += quadrics[to];
+				candidates.push_back({ from, to, static_cast<float>(std::sqrt(quadric.Evaluate(positions[to]))) });
+			};
+			for (std::size_t i = 0; i < triangles.size(); ++i)
+			{
+				const unsigned int from = representatives[triangles[i]], to = representatives[triangles[i - i % 3 + (i + 1) % 3]];
+				addCandidate(from, to, borderEdges[i] != 0);
+				if (borderEdges[i])
+					addCandidate(to, from, true);
+			}
+			std::sort(candidates.begin(), candidates.end(), [](const Collapse& lhs, const Collapse& rhs) {
+				return lhs.error < rhs.error;
+			});
+
+			std::fill(locked.begin(), locked.end(), 0);
+			collapsed.clear();
+			std::size_t remainingTriangles = triangles.size() / 3;
+			for (const auto& candidate : candidates)
+			{
+				if (remainingTriangles <= targetIndexCount / 3 || candidate.error > maxError)
+					break;
+				if (locked[candidate.from] || locked[candidate.to])
+					continue;
+
+				//! Reject the collapse if any remaining triangle around 'from' flips
+				std::size_t numRemoved = 0;
+				bool flipped = false;
+				for (unsigned int k = adjacencyOffsets[candidate.from]; k < adjacencyOffsets[candidate.from + 1] && !flipped; ++k)
+				{
+					const unsigned int* triangle = triangles.data() + adjacency[k] * 3;
+					glm::vec3 corners[3], moved[3];
+					bool removed = false;
+					for (int c = 0; c < 3; ++c)
+					{
+						const unsigned int representative = representatives[triangle[c]];
+						removed |= representative == candidate.to;
+						corners[c] = positions[representative];
+						moved[c] = representative == candidate.from ? positions[candidate.to] : corners[c];
+					}
+					if (removed)
+					{
+						++numRemoved;
+						continue;
+					}
+
+					const glm::dvec3 before = getNormal(corners[0], corners[1], corners[2]);
+					const glm::dvec3 after = getNormal(moved[0], moved[1], moved[2]);
+					const double lengths = glm::length(before) * glm::length(after);
+					flipped = lengths == 0.0 ? glm::length(before) > 0.0 : glm::dot(before, after) < kMinNormalCosine * lengths;
+				}
+				if (flipped)
+					continue;
+
+				collapseTargets[candidate.from] = candidate.to;
+				collapsed.push_back(candidate.from);
+				quadrics[candidate.to] += quadrics[candidate.from];
+				error = std::max(error, candidate.error);
+				remainingTriangles -= std::min(numRemoved, remainingTriangles);
+
+				//! The one-ring of 'from' changes, lock it to keep the flip tests of this pass valid
+				for (unsigned int k = adjacencyOffsets[candidate.from]; k < adjacencyOffsets[candidate.from + 1]; ++k)
+				{
+					const unsigned int* triangle = triangles.data() + adjacency[k] * 3;
+					for (int c = 0; c < 3; ++c)
+						locked[representatives[triangle[c]]] = 1;
+				}
+			}
+			if (collapsed.empty())
+				break;
+
+			//! Move the corners onto the vertex of the target connected to them by an edge,
+			//! which keeps the corners on the same side of the attribute seams.
+			std::vector<unsigned int> updated(triangles);
+			for (std::size_t i = 0; i < triangles.size(); ++i)
+			{
+				const unsigned int vertex = triangles[i], from = representatives[vertex];
+				const unsigned int to = collapseTargets[from];
+				if (to == kNoCollapse)
+					continue;
+
+				unsigned int wedge = to;
+				for (unsigned int k = adjacencyOffsets[from]; k < adjacencyOffsets[from + 1] && wedge == to; ++k)
+				{
+					const unsigned int* triangle = triangles.data() + adjacency[k] * 3;
+					if (triangle[0] != vertex && triangle[1] != vertex && triangle[2] != vertex)
+						continue;
+					for (int c = 0; c < 3; ++c)
+					{
+						if (representatives[triangle[c]] == to)
+							wedge = triangle[c];
+					}
+				}
+				updated[i] = wedge;
+			}
+			triangles.swap(updated);
+
+			for (unsigned int from : collapsed)
+				collapseTargets[from] = kNoCollapse;
+			removeDegenerates();
+		}
+
+		std::copy(triangles.begin(), triangles.end(), dst);
+		if (resultError != nullptr)
+			*resultError = error;
+		return triangles.size();
+	}
+};
@@ -0,0 +1,344 @@
+#include <Core/Quantization.hpp>
+#include <Core/Macros.hpp>
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if defined(SIMD_SSE2)
+#include <emmintrin.h>
+#endif
+
+namespace Core {
+
+	namespace
+	{
+		//! glTF component types, identical to the OpenGL enums
+		constexpr int kComponentTypeByte = 5120;
+		constexpr int kComponentTypeUnsignedByte = 5121;
+		constexpr int kComponentTypeShort = 5122;
+		constexpr int kComponentTypeUnsignedShort = 5123;
+		constexpr int kComponentTypeFloat = 5126;
+
+		template <typename Type>
+		void DequantizeScalar(const unsigned char* src, std::size_t srcStride, std::size_t numComponents,
+							  float* dst, std::size_t dstComponents, std::size_t count, float scale, float minValue)
+		{
+			const std::size_t writeComponents = std::min(numComponents, dstComponents);
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				const unsigned char* element = src + i * srcStride;
+				float* out = dst + i * dstComponents;
+				for (std::size_t c = 0; c < writeComponents; ++c)
+				{
+					Type value;
+					std::memcpy(&value, element + c * sizeof(Type), sizeof(Type));
+					if (std::is_floating_point<Type>::value)
+						out[c] = static_cast<float>(value);
+					else
+						out[c] = std::max(static_cast<float>(value) * scale, minValue);
+				}
+			}
+		}
+
+#if defined(SIMD_SSE2)
+		//! Convert 4 integer lanes and apply the normalization
+		inline __m128 ConvertLanes(__m128i lanes, __m128 scale, __m128 minValue)
+		{
+			return _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(lanes), scale), minValue);
+		}
+
+		//! Widen 4 lanes of 16-bit integers into 32-bit
+		template <typename Type>
+		inline __m128i Widen16Lo(__m128i value)
+		{
+			if (std::is_signed<Type>::value)
+				return _mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16);
+			return _mm_unpacklo_epi16(value, _mm_setzero_si128());
+		}
+
+		template <typename Type>
+		inline __m128i Widen16Hi(__m128i value)
+		{
+			if (std::is_signed<Type>::value)
+				return _mm_srai_epi32(_mm_unpackhi_epi16(value, value), 16);
+			return _mm_unpackhi_epi16(value, _mm_setzero_si128());
+		}
+
+		//! Widen 8 lanes of 8-bit integers into 16-bit
+		template <typename Type>
+		inline __m128i Widen8Lo(__m128i value)
+		{
+			if (std::is_signed<Type>::value)
+				return _mm_srai_epi16(_mm_unpacklo_epi8(value, value), 8);
+			return _mm_unpacklo_epi8(value, _mm_setzero_si128());
+		}
+
+		template <typename Type>
+		inline __m128i Widen8Hi(__m128i value)
+		{
+			if (std::is_signed<Type>::value)
+				return _mm_srai_epi16(_mm_unpackhi_epi8(value, value), 8);
+			return _mm_unpackhi_epi8(value, _mm_setzero_si128());
+		}
+
+		//!
+		//! \brief      Dequantize the elements with numComponents == dstComponents.
+		//!
+		//! Every element is loaded as 4 components and stored as 4 floats, the extra lanes
+		//! are overwritten by the next element. 16-bit components are converted by 2 elements
+		//! (8 components) and 8-bit components by 4 elements (16 components) at once.
+		//! Returns the number of processed elements, the rest must be done by the scalar path
+		//! because their 4-component loads or stores would run out of the ranges.
+		//!
+		template <typename Type>
+		std::size_t DequantizeSSE2(const unsigned char* src, std::size_t srcStride, std::size_t numComponents,
+								   float* dst, std::size_t count, float scale, float minValue)
+		{
+			if (srcStride == 0 || count == 0)
+				return 0;
+
+			const std::size_t overRead = (4 - numComponents) * sizeof(Type);
+			const std::size_t readTail = (overRead + srcStride - 1) / srcStride;
+			const std::size_t writeTail = (4 + numComponents - 1) / numComponents - 1;
+			const std::size_t tail = std::max(readTail, writeTail);
+			if (count <= tail)
+				return 0;
+
+			const __m128 scaleVec = _mm_set1_ps(scale);
+			const __m128 minVec = _mm_set1_ps(minValue);
+			const std::size_t safeCount = count - tail;
+
+			std::size_t i = 0;
+			if (sizeof(Type) == 2)
+			{
+				for (; i + 2 <= safeCount; i += 2)
+				{
+					const unsigned char* element = src + i * srcStride;
+					const __m128i value = _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(element)),
+															 _mm_loadl_epi64(reinterpret_cast<const __m128i*>(element + srcStride)));
+					float* out = dst + i * numComponents;
+					_mm_storeu_ps(out, ConvertLanes(Widen16Lo<Type>(value), scaleVec, minVec));
+					_mm_storeu_ps(out + numComponents, ConvertLanes(Widen16Hi<Type>(value), scaleVec, minVec));
+				}
+			}
+			else
+			{
+				for (; i + 4 <= safeCount; i += 4)
+				{
+					const unsigned char* element = src + i * srcStride;
+					int32_t packed[4];
+					for (int e = 0; e < 4; ++e)
+						std::memcpy(&packed[e], element + e * srcStride, sizeof(int32_t));
+					const __m128i value = _mm_unpacklo_epi64(
+						_mm_unpacklo_epi32(_mm_cvtsi32_si128(packed[0]), _mm_cvtsi32_si128(packed[1])),
+						_mm_unpacklo_epi32(_mm_cvtsi32_si128(packed[2]), _mm_cvtsi32_si128(packed[3])));
+					const __m128i lo = Widen8Lo<Type>(value);
+					const __m128i hi = Widen8Hi<Type>(value);
+					float* out = dst + i * numComponents;
+					_mm_storeu_ps(out, ConvertLanes(Widen16Lo<int16_t>(lo), scaleVec, minVec));
+					_mm_storeu_ps(out + numComponents, ConvertLanes(Widen16Hi<int16_t>(lo), scaleVec, minVec));
+					_mm_storeu_ps(out + numComponents * 2, ConvertLanes(Widen16Lo<int16_t>(hi), scaleVec, minVec));
+					_mm_storeu_ps(out + numComponents * 3, ConvertLanes(Widen16Hi<int16_t>(hi), scaleVec, minVec));
+				}
+			}
+
+			return i;
+		}
+#endif
+
+		template <typename Type>
+		void Dequantize(const unsigned char* src, std::size_t srcStride, bool normalized, std::size_t numComponents,
+						float* dst, std::size_t dstComponents, std::size_t count)
+		{
+			//! Normalized signed values are clamped at -1 since both MIN and MIN + 1 map to -1
+			float scale = 1.0f, minValue = std::numeric_limits<float>::lowest();
+			if (normalized)
+			{
+				scale = 1.0f / static_cast<float>(std::numeric_limits<Type>::max());
+				if (std::is_signed<Type>::value)
+					minValue = -1.0f;
+			}
+
+			std::size_t processed = 0;
+#if defined(SIMD_SSE2)
+			if (numComponents == dstComponents)
+				processed = DequantizeSSE2<Type>(src, srcStride, numComponents, dst, count, scale, minValue);
+#endif
+			DequantizeScalar<Type>(src + processed * srcStride, srcStride, numComponents,
+								   dst + processed * dstComponents, dstComponents, count - processed, scale, minValue);
+		}
+	};
+
+	std::size_t GetComponentSize(int componentType)
+	{
+		switch (componentType)
+		{
+		case kComponentTypeByte:
+		case kComponentTypeUnsignedByte:
+			return 1;
+		case kComponentTypeShort:
+		case kComponentTypeUnsignedShort:
+			return 2;
+		case kComponentTypeFloat:
+			return 4;
+		default:
+			return 0;
+		}
+	}
+
+	void WidenIndices(const unsigned char* src, unsigned int* dst, std::size_t count)
+	{
+		std::size_t i = 0;
+#if defined(SIMD_SSE2)
+		const __m128i zero = _mm_setzero_si128();
+		for (; i + 16 <= count; i += 16)
+		{
+			const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			const __m128i lo = _mm_unpacklo_epi8(value, zero);
+			const __m128i hi = _mm_unpackhi_epi8(value, zero);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_unpacklo_epi16(lo, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 4), _mm_unpackhi_epi16(lo, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8), _mm_unpacklo_epi16(hi, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 12), _mm_unpackhi_epi16(hi, zero));
+		}
+#endif
+		std::copy(src + i, src + count, dst + i);
+	}
+
+	void WidenIndices(const unsigned short* src, unsigned int* dst, std::size_t count)
+	{
+		std::size_t i = 0;
+#if defined(SIMD_SSE2)
+		const __m128i zero = _mm_setzero_si128();
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_unpacklo_epi16(value, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 4), _mm_unpackhi_epi16(value, zero));
+		}
+#endif
+		std::copy(src + i, src + count, dst + i);
+	}
+
+	void NarrowIndices(const unsigned int* src, unsigned short* dst, std::size_t count)
+	{
+		std::size_t i = 0;
+#if defined(SIMD_SSE2)
+		//! SSE2 has only the signed saturation, shift the range into int16 and back
+		const __m128i bias32 = _mm_set1_epi32(0x8000);
+		const __m128i bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m128i lo = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), bias32);
+			const __m128i hi = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 4)), bias32);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(_mm_packs_epi32(lo, hi), bias16));
+		}
+#endif
+		for (; i < count; ++i)
+			dst[i] = static_cast<unsigned short>(src[i]);
+	}
+
+	bool DequantizeAttributes(const unsigned char* src, std::size_t srcStride, int componentType, bool normalized,
+							  std::size_t numComponents, float* dst, std::size_t dstComponents, std::size_t count)
+	{
+		if (numComponents == 0 || numComponents > 4)
+			return false;
+
+		switch (componentType)
+		{
+		case kComponentTypeByte:
+			Dequantize<int8_t>(src, srcStride, normalized, numComponents, dst, dstComponents, count);
+			return true;
+		case kComponentTypeUnsignedByte:
+			Dequantize<uint8_t>(src, srcStride, normalized, numComponents, dst, dstComponents, count);
+			return true;
+		case kComponentTypeShort:
+			Dequantize<int16_t>(src, srcStride, normalized, numComponents, dst, dstComponents, count);
+			return true;
+		case kComponentTypeUnsignedShort:
+			Dequantize<uint16_t>(src, srcStride, normalized, numComponents, dst, dstComponents, count);
+			return true;
+		case kComponentTypeFloat:
+			if (srcStride == numComponents * sizeof(float) && numComponents == dstComponents)
+				std::memcpy(dst, src, count * numComponents * sizeof(float));
+			else
+				DequantizeScalar<float>(src, srcStride, numComponents, dst, dstComponents, count, 1.0f, std::numeric_limits<float>::lowest());
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	glm::vec2 EncodeOctahedral(const glm::vec3& direction)
+	{
+		const float length = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+		if (length == 0.0f)
+			return glm::vec2(0.0f);
+
+		const glm::vec3 n = direction / length;
+		if (n.z >= 0.0f)
+			return glm::vec2(n.x, n.y);
+
+		//! Fold the lower hemisphere over the diagonals
+		return glm::vec2((1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f),
+						 (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f));
+	}
+
+	glm::vec3 DecodeOctahedral(const glm::vec2& encoded)
+	{
+		glm::vec3 n(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+		const float t = std::max(-n.z, 0.0f);
+		n.x += n.x >= 0.0f ? -t : t;
+		n.y += n.y >= 0.0f ? -t : t;
+		return glm::normalize(n);
+	}
+
+	namespace
+	{
+		constexpr float kSmallestThreeRange = 0.70710678f;
+		constexpr float kSmallestThreeSteps = 32767.0f;
+	};
+
+	glm::u16vec3 EncodeSmallestThree(const glm::vec4& quaternion)
+	{
+		int largest = 0;
+		for (int c = 1; c < 4; ++c)
+			largest = std::abs(quaternion[c]) > std::abs(quaternion[largest]) ? c : largest;
+		const float sign = quaternion[largest] < 0.0f ? -1.0f : 1.0f;
+
+		uint64_t bits = static_cast<uint64_t>(largest);
+		for (int c = 0; c < 4; ++c)
+		{
+			if (c == largest)
+				continue;
+			const float normalized = (std::min(std::max(quaternion[c] * sign, -kSmallestThreeRange), kSmallestThreeRange) / kSmallestThreeRange + 1.0f) * 0.5f;
+			bits = (bits << 15) | static_cast<uint64_t>(std::lround(normalized * kSmallestThreeSteps));
+		}
+		return glm::u16vec3(static_cast<glm::u16>(bits >> 32), static_cast<glm::u16>(bits >> 16), static_cast<glm::u16>(bits));
+	}
+
+	glm::vec4 DecodeSmallestThree(const glm::u16vec3& encoded)
+	{
+		const uint64_t bits = (static_cast<uint64_t>(encoded.x) << 32) | (static_cast<uint64_t>(encoded.y) << 16) | encoded.z;
+		const int largest = static_cast<int>(bits >> 45);
+
+		glm::vec4 quaternion(0.0f);
+		float sumSquares = 0.0f;
+		int shift = 30;
+		for (int c = 0; c < 4; ++c)
+		{
+			if (c == largest)
+				continue;
+			const float normalized = static_cast<float>((bits >> shift) & 0x7FFF) / kSmallestThreeSteps;
+			quaternion[c] = (normalized * 2.0f - 1.0f) * kSmallestThreeRange;
+			sumSquares += quaternion[c] * quaternion[c];
+			shift -= 15;
+		}
+		quaternion[largest] = std::sqrt(std::max(1.0f - sumSquares, 0.0f));
+		return quaternion;
+	}
+};
@@ -0,0 +1,48 @@
+#include <Core/RadixSort.hpp>
+#include <cstddef>
+
+namespace Core {
+
+	void RadixSort(std::vector<std::uint64_t>& keys, std::vector<int>& values,
+				   std::vector<std::uint64_t>& scratchKeys, std::vector<int>& scratchValues)
+	{
+		constexpr int kNumBuckets = 256;
+		const std::size_t count = keys.size();
+		if (count < 2)
+			return;
+
+		//! Histograms of every byte in one pass over the keys
+		std::size_t histograms[8][kNumBuckets] = { { 0 } };
+		for (std::uint64_t key : keys)
+		{
+			for (int byte = 0; byte < 8; ++byte)
+				++histograms[byte][(key >> (byte * 8)) & 0xFF];
+		}
+
+		scratchKeys.resize(count);
+		scratchValues.resize(count);
+		for (int byte = 0; byte < 8; ++byte)
+		{
+			std::size_t* histogram = histograms[byte];
+			if (histogram[(keys[0] >> (byte * 8)) & 0xFF] == count)
+				continue;
+
+			std::size_t offset = 0;
+			for (int bucket = 0; bucket < kNumBuckets; ++bucket)
+			{
+				const std::size_t bucketCount = histogram[bucket];
+				histogram[bucket] = offset;
+				offset += bucketCount;
+			}
+
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				const std::size_t dst = histogram[(keys[i] >> (byte * 8)) & 0xFF]++;
+				scratchKeys[dst] = keys[i];
+				scratchValues[dst] = values[i];
+			}
+			keys.swap(scratchKeys);
+			values.swap(scratchValues);
+		}
+	}
+};
\ No newline at end of file
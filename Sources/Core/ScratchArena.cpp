@@ -0,0 +1,62 @@
+#include <Core/ScratchArena.hpp>
+#include <algorithm>
+#include <cstdint>
+
+namespace Core {
+
+	ScratchArena::ScratchArena(std::size_t capacity)
+	{
+		if (capacity > 0)
+			AddBlock(capacity);
+	}
+
+	ScratchArena::~ScratchArena()
+	{
+		//! Do nothing
+	}
+
+	void ScratchArena::Reset()
+	{
+		//! Merge the blocks so that the same workload fits in one block next time
+		if (_blocks.size() > 1)
+		{
+			std::size_t capacity = 0;
+			for (const auto& block : _blocks)
+				capacity += block.capacity;
+			_blocks.clear();
+			AddBlock(capacity);
+		}
+
+		_offset = 0;
+		_usedBytes = 0;
+	}
+
+	void* ScratchArena::AllocateBytes(std::size_t bytes)
+	{
+		//! Keep the following allocation aligned
+		bytes = (std::max<std::size_t>(bytes, 1) + kAlignment - 1) & ~(kAlignment - 1);
+
+		if (_blocks.empty() || _offset + bytes > _blocks.back().capacity)
+		{
+			//! Grow geometrically to bound the number of blocks
+			const std::size_t lastCapacity = _blocks.empty() ? 0 : _blocks.back().capacity;
+			AddBlock(std::max(bytes, lastCapacity * 2));
+			_offset = 0;
+		}
+
+		void* result = _blocks.back().begin + _offset;
+		_offset += bytes;
+		_usedBytes += bytes;
+		return result;
+	}
+
+	void ScratchArena::AddBlock(std::size_t bytes)
+	{
+		Block block;
+		block.capacity = (bytes + kAlignment - 1) & ~(kAlignment - 1);
+		block.storage.reset(new unsigned char[block.capacity + kAlignment - 1]);
+		const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(block.storage.get());
+		block.begin = block.storage.get() + ((kAlignment - address % kAlignment) % kAlignment);
+		_blocks.emplace_back(std::move(block));
+	}
+};
@@ -0,0 +1,79 @@
+#include <Core/Skinning.hpp>
+#include <Core/Macros.hpp>
+#include <Core/ThreadPool.hpp>
+#include <glm/geometric.hpp>
+#include <cmath>
+
+#if defined(SIMD_SSE2)
+#include <emmintrin.h>
+#endif
+
+namespace Core {
+
+	namespace
+	{
+		constexpr std::size_t kVertexGrainSize = 4096;
+		constexpr float kWeightScale = 1.0f / 65535.0f;
+#if defined(SIMD_SSE2)
+		const glm::mat4 kZeroMatrix(0.0f);
+#endif
+	};
+
+	void SkinVertices(glm::vec3* outPositions, glm::vec3* outNormals, const glm::vec3* positions, const glm::vec3* normals,
+					  const glm::u16vec4* joints, const glm::u16vec4* weights, std::size_t vertexCount,
+					  const glm::mat4* palette, std::size_t jointCount)
+	{
+		ThreadPool::GetInstance().ParallelFor(vertexCount, kVertexGrainSize, [&](std::size_t begin, std::size_t end) {
+			for (std::size_t v = begin; v < end; ++v)
+			{
+#if defined(SIMD_SSE2)
+				//! Columns of the blended matrix
+				__m128 columns[4] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+				for (int k = 0; k < 4; ++k)
+				{
+					//! The unused and out of palette joints read the zero matrix, no branch and no NaN from the palette
+					const bool isUsed = weights[v][k] != 0 && joints[v][k] < jointCount;
+					const __m128 weight = _mm_set1_ps(weights[v][k] * kWeightScale);
+					const float* matrix = isUsed ? &palette[joints[v][k]][0][0] : &kZeroMatrix[0][0];
+					for (int c = 0; c < 4; ++c)
+						columns[c] = _mm_add_ps(columns[c], _mm_mul_ps(weight, _mm_loadu_ps(matrix + c * 4)));
+				}
+
+				const glm::vec3& position = positions[v];
+				__m128 result = _mm_add_ps(_mm_add_ps(_mm_mul_ps(columns[0], _mm_set1_ps(position.x)), _mm_mul_ps(columns[1], _mm_set1_ps(position.y))),
+										   _mm_add_ps(_mm_mul_ps(columns[2], _mm_set1_ps(position.z)), columns[3]));
+				alignas(16) float stored[4];
+				_mm_store_ps(stored, result);
+				outPositions[v] = glm::vec3(stored[0], stored[1], stored[2]);
+
+				if (outNormals != nullptr && normals != nullptr)
+				{
+					const glm::vec3& normal = normals[v];
+					result = _mm_add_ps(_mm_add_ps(_mm_mul_ps(columns[0], _mm_set1_ps(normal.x)), _mm_mul_ps(columns[1], _mm_set1_ps(normal.y))),
+										_mm_mul_ps(columns[2], _mm_set1_ps(normal.z)));
+					_mm_store_ps(stored, result);
+					const glm::vec3 skinned(stored[0], stored[1], stored[2]);
+					const float lengthSquared = glm::dot(skinned, skinned);
+					outNormals[v] = lengthSquared > 0.0f ? skinned * (1.0f / std::sqrt(lengthSquared)) : normal;
+				}
+#else
+				glm::mat4 matrix(0.0f);
+				for (int k = 0; k < 4; ++k)
+				{
+					const unsigned int joint = joints[v][k];
+					if (weights[v][k] != 0 && joint < jointCount)
+						matrix += palette[joint] * (weights[v][k] * kWeightScale);
+				}
+
+				outPositions[v] = glm::vec3(matrix * glm::vec4(positions[v], 1.0f));
+				if (outNormals != nullptr && normals != nullptr)
+				{
+					const glm::vec3 skinned = glm::mat3(matrix) * normals[v];
+					const float length = glm::length(skinned);
+					outNormals[v] = length > 0.0f ? skinned / length : normals[v];
+				}
+#endif
+			}
+		});
+	}
+};
@@ -0,0 +1,204 @@
+#include <Core/TangentGenerator.hpp>
+#include <Core/ScratchArena.hpp>
+#include <Core/ThreadPool.hpp>
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+
+namespace Core {
+
+	namespace {
+		constexpr std::size_t kTriangleGrainSize = 4096;
+		constexpr std::size_t kVertexGrainSize = 4096;
+
+		constexpr unsigned int kEmptySlot = ~0u;
+
+		//! Same threshold as MikkTSpace
+		inline bool IsNotZero(float value)
+		{
+			return std::fabs(value) > FLT_MIN;
+		}
+
+		//! Returns the unit vector perpendicular to the normal
+		glm::vec3 GetPerpendicular(const glm::vec3& n)
+		{
+			if (std::abs(n.x) > std::abs(n.y))
+				return glm::vec3(n.z, 0.0f, -n.x) / std::sqrt(n.x * n.x + n.z * n.z);
+			if (IsNotZero(n.y) || IsNotZero(n.z))
+				return glm::vec3(0.0f, -n.z, n.y) / std::sqrt(n.y * n.y + n.z * n.z);
+			return glm::vec3(1.0f, 0.0f, 0.0f);
+		}
+
+		//! Arc cosine within 2e-8 radians (Abramowitz and Stegun 4.4.46), cheaper than std::acos
+		inline float ArcCos(float x)
+		{
+			const float a = std::min(std::fabs(x), 1.0f);
+			const float polynomial = 1.5707963050f + a * (-0.2145988016f + a * (0.0889789874f + a * (-0.0501743046f +
+									 a * (0.0308918810f + a * (-0.0170881256f + a * (0.0066700901f + a * -0.0012624911f))))));
+			const float result = std::sqrt(1.0f - a) * polynomial;
+			return x < 0.0f ? 3.14159265358979f - result : result;
+		}
+
+		//! Hash of the bits of the vertex attributes
+		inline std::size_t HashVertex(const glm::vec3& position, const glm::vec3& normal, const glm::vec2& texCoord)
+		{
+			uint32_t bits[8];
+			std::memcpy(bits + 0, &position, sizeof(glm::vec3));
+			std::memcpy(bits + 3, &normal, sizeof(glm::vec3));
+			std::memcpy(bits + 6, &texCoord, sizeof(glm::vec2));
+			uint64_t hash = 14695981039346656037ULL;
+			for (uint32_t value : bits)
+				hash = (hash ^ value) * 1099511628211ULL;
+			return static_cast<std::size_t>(hash ^ (hash >> 32));
+		}
+
+		inline bool IsSameVertex(const glm::vec3* positions, const glm::vec3* normals, const glm::vec2* texCoords, std::size_t lhs, std::size_t rhs)
+		{
+			return std::memcmp(&positions[lhs], &positions[rhs], sizeof(glm::vec3)) == 0 &&
+				   std::memcmp(&normals[lhs], &normals[rhs], sizeof(glm::vec3)) == 0 &&
+				   std::memcmp(&texCoords[lhs], &texCoords[rhs], sizeof(glm::vec2)) == 0;
+		}
+
+		//! Returns the normalized component of the vector on the plane of the unit normal, zero if none
+		inline glm::vec3 ProjectOnPlane(const glm::vec3& v, const glm::vec3& n)
+		{
+			const glm::vec3 projected = v - n * glm::dot(n, v);
+			const float length = glm::length(projected);
+			return IsNotZero(length) ? projected / length : glm::vec3(0.0f);
+		}
+	};
+
+	void GenerateTangents(glm::vec4* tangents, const unsigned int* indices, std::size_t indexCount, const glm::vec3* positions,
+						  const glm::vec3* normals, const glm::vec2* texCoords, std::size_t vertexCount)
+	{
+		const std::size_t numTriangles = indexCount / 3;
+		ScratchArena arena(vertexCount * 6 * sizeof(unsigned int) + numTriangles * 3 * (4 * sizeof(float) + sizeof(unsigned int)) +
+						   8 * ScratchArena::kAlignment);
+
+		//! Representative of the identical vertices, the first one in the hash table order
+		unsigned int* remap = arena.Allocate<unsigned int>(vertexCount);
+		std::size_t tableSize = 1;
+		while (tableSize < vertexCount * 2)
+			tableSize *= 2;
+		unsigned int* table = arena.Allocate<unsigned int>(tableSize);
+		std::fill(table, table + tableSize, kEmptySlot);
+		for (std::size_t v = 0; v < vertexCount; ++v)
+		{
+			std::size_t slot = HashVertex(positions[v], normals[v], texCoords[v]) & (tableSize - 1);
+			while (table[slot] != kEmptySlot && !IsSameVertex(positions, normals, texCoords, table[slot], v))
+				slot = (slot + 1) & (tableSize - 1);
+			if (table[slot] == kEmptySlot)
+				table[slot] = static_cast<unsigned int>(v);
+			remap[v] = table[slot];
+		}
+
+		//! Angle weighted tangent contribution of each corner, stored as SoA. The weight is
+		//! the corner angle, negated for the triangles of the mirrored texture space.
+		const std::size_t numCorners = numTriangles * 3;
+		float* cornerTangentX = arena.Allocate<float>(numCorners);
+		float* cornerTangentY = arena.Allocate<float>(numCorners);
+		float* cornerTangentZ = arena.Allocate<float>(numCorners);
+		float* cornerWeights = arena.Allocate<float>(numCorners);
+
+		auto& threadPool = ThreadPool::GetInstance();
+		threadPool.ParallelFor(numTriangles, kTriangleGrainSize, [&](std::size_t begin, std::size_t end) {
+			for (std::size_t t = begin; t < end; ++t)
+			{
+				const unsigned int* triangle = indices + t * 3;
+				const glm::vec3 d1 = positions[triangle[1]] - positions[triangle[0]];
+				const glm::vec3 d2 = positions[triangle[2]] - positions[triangle[0]];
+				//! glTF puts the texture origin at the top left, MikkTSpace is run with the flipped V
+				//! like the exporters do. Only the bitangent sign changes.
+				const glm::vec2 t21 = (texCoords[triangle[1]] - texCoords[triangle[0]]) * glm::vec2(1.0f, -1.0f);
+				const glm::vec2 t31 = (texCoords[triangle[2]] - texCoords[triangle[0]]) * glm::vec2(1.0f, -1.0f);
+
+				//! Texture space derivative along u, mirrored triangles are flipped back
+				//! since the bitangent sign carries the orientation.
+				const float signedArea = t21.x * t31.y - t21.y * t31.x;
+				const float sign = signedArea > 0.0f ? 1.0f : -1.0f;
+				const glm::vec3 tangent = (d1 * t31.y - d2 * t21.y) * sign;
+				const bool isValid = IsNotZero(signedArea) && IsNotZero(glm::length(tangent));
+
+				for (std::size_t corner = 0; corner < 3; ++corner)
+				{
+					const std::size_t c = t * 3 + corner;
+					glm::vec3 weighted(0.0f);
+					float weight = 0.0f;
+					if (isValid)
+					{
+						const glm::vec3& normal = normals[triangle[corner]];
+						const float normalLength = glm::length(normal);
+						const glm::vec3 n = IsNotZero(normalLength) ? normal / normalLength : glm::vec3(0.0f, 0.0f, 1.0f);
+
+						//! Angle of the corner on the tangent plane
+						const glm::vec3& position = positions[triangle[corner]];
+						glm::vec3 edge0 = positions[triangle[(corner + 2) % 3]] - position;
+						glm::vec3 edge1 = positions[triangle[(corner + 1) % 3]] - position;
+						edge0 -= n * glm::dot(n, edge0);
+						edge1 -= n * glm::dot(n, edge1);
+						const float lengthProduct = std::sqrt(glm::dot(edge0, edge0) * glm::dot(edge1, edge1));
+						const float angle = ArcCos(IsNotZero(lengthProduct) ? glm::dot(edge0, edge1) / lengthProduct : 0.0f);
+
+						weighted = ProjectOnPlane(tangent, n) * angle;
+						weight = angle * sign;
+					}
+					cornerTangentX[c] = weighted.x;
+					cornerTangentY[c] = weighted.y;
+					cornerTangentZ[c] = weighted.z;
+					cornerWeights[c] = weight;
+				}
+			}
+		});
+
+		//! Corners of each representative vertex in the ascending order, the sums are deterministic
+		unsigned int* cornerOffsets = arena.Allocate<unsigned int>(vertexCount + 1);
+		unsigned int* corners = arena.Allocate<unsigned int>(numCorners);
+		std::fill(cornerOffsets, cornerOffsets + vertexCount + 1, 0u);
+		for (std::size_t c = 0; c < numCorners; ++c)
+			++cornerOffsets[remap[indices[c]] + 1];
+		std::partial_sum(cornerOffsets, cornerOffsets + vertexCount + 1, cornerOffsets);
+		unsigned int* cursors = table;  //! Not needed anymore, at least vertexCount long
+		std::copy(cornerOffsets, cornerOffsets + vertexCount, cursors);
+		for (std::size_t c = 0; c < numCorners; ++c)
+			corners[cursors[remap[indices[c]]]++] = static_cast<unsigned int>(c);
+
+		threadPool.ParallelFor(vertexCount, kVertexGrainSize, [&](std::size_t begin, std::size_t end) {
+			for (std::size_t v = begin; v < end; ++v)
+			{
+				if (remap[v] != v)
+					continue;
+
+				//! Accumulated separately for each texture space orientation
+				glm::vec3 sums[2] = { glm::vec3(0.0f), glm::vec3(0.0f) };
+				float weightSums[2] = { 0.0f, 0.0f };
+				for (unsigned int i = cornerOffsets[v]; i < cornerOffsets[v + 1]; ++i)
+				{
+					const unsigned int c = corners[i];
+					const int orientation = cornerWeights[c] > 0.0f ? 1 : 0;
+					sums[orientation] += glm::vec3(cornerTangentX[c], cornerTangentY[c], cornerTangentZ[c]);
+					weightSums[orientation] += std::fabs(cornerWeights[c]);
+				}
+
+				const int orientation = weightSums[1] >= weightSums[0] ? 1 : 0;
+				const float length = glm::length(sums[orientation]);
+				if (IsNotZero(length))
+					tangents[v] = glm::vec4(sums[orientation] / length, orientation ? 1.0f : -1.0f);
+				else
+					tangents[v] = glm::vec4(GetPerpendicular(normals[v]), 1.0f);
+			}
+		});
+
+		//! The identical vertices share the tangent of their representative
+		threadPool.ParallelFor(vertexCount, kVertexGrainSize, [&](std::size_t begin, std::size_t end) {
+			for (std::size_t v = begin; v < end; ++v)
+			{
+				if (remap[v] != v)
+					tangents[v] = tangents[remap[v]];
+			}
+		});
+	}
+};
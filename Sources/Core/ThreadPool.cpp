@@ -0,0 +1,147 @@
+#include <Core/ThreadPool.hpp>
+#include <algorithm>
+
+namespace Core {
+
+	ThreadPool::ThreadPool(std::size_t numThreads)
+	{
+		if (numThreads == 0)
+		{
+			const std::size_t hardwareThreads = std::thread::hardware_concurrency();
+			numThreads = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+		}
+
+		_workers.reserve(numThreads);
+		for (std::size_t i = 0; i < numThreads; ++i)
+			_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_stop = true;
+		}
+		_condition.notify_all();
+
+		for (auto& worker : _workers)
+			worker.join();
+	}
+
+	ThreadPool& ThreadPool::GetInstance()
+	{
+		static ThreadPool instance;
+		return instance;
+	}
+
+	std::size_t ThreadPool::GetConcurrency() const
+	{
+		return _workers.size() + 1;
+	}
+
+	void ThreadPool::Enqueue(Job job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_jobs.push_back({ std::move(job), nullptr });
+		}
+		_condition.notify_one();
+	}
+
+	void ThreadPool::ParallelFor(std::size_t count, std::size_t grainSize, const RangeJob& job)
+	{
+		if (count == 0)
+			return;
+
+		grainSize = std::max<std::size_t>(grainSize, 1);
+		const std::size_t numChunks = (count + grainSize - 1) / grainSize;
+
+		//! Not worth to pass through the queue
+		if (numChunks == 1 || _workers.empty())
+		{
+			job(0, count);
+			return;
+		}
+
+		JobGroup group;
+		group.remaining.store(numChunks, std::memory_order_relaxed);
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			for (std::size_t chunk = 0; chunk < numChunks; ++chunk)
+			{
+				const std::size_t begin = chunk * grainSize;
+				const std::size_t end = std::min(begin + grainSize, count);
+				_jobs.push_back({ [&job, &group, begin, end]() {
+					//! The chunk is counted even if it throws, otherwise the caller would wait forever
+					try
+					{
+						job(begin, end);
+					}
+					catch (...)
+					{
+						if (!group.failed.exchange(true, std::memory_order_acq_rel))
+							group.exception = std::current_exception();
+					}
+					group.remaining.fetch_sub(1, std::memory_order_acq_rel);
+				}, &group });
+			}
+		}
+		_condition.notify_all();
+
+		//! Help the workers with the chunks of this call instead of blocking
+		while (group.remaining.load(std::memory_order_acquire) > 0)
+		{
+			if (!RunPendingJob(&group))
+				std::this_thread::yield();
+		}
+
+		if (group.exception)
+			std::rethrow_exception(group.exception);
+	}
+
+	void ThreadPool::WaitFor(const std::atomic<bool>& done)
+	{
+		while (!done.load(std::memory_order_acquire))
+		{
+			if (!RunPendingJob())
+				std::this_thread::yield();
+		}
+	}
+
+	bool ThreadPool::RunPendingJob(const JobGroup* group)
+	{
+		Job job;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			auto pending = group == nullptr ? _jobs.begin() : std::find_if(_jobs.begin(), _jobs.end(), [group](const PendingJob& queued) {
+				return queued.group == group;
+			});
+			if (pending == _jobs.end())
+				return false;
+			job = std::move(pending->job);
+			_jobs.erase(pending);
+		}
+
+		job();
+		return true;
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		for (;;)
+		{
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_condition.wait(lock, [this]() { return _stop || !_jobs.empty(); });
+				if (_stop && _jobs.empty())
+					return;
+				job = std::move(_jobs.front().job);
+				_jobs.pop_front();
+			}
+
+			job();
+		}
+	}
+
+};
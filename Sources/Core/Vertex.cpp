@@ -31,5 +31,45 @@ namespace Core {
     {
         return sizeof(float) * GetNumberOfFloats(format);
     }
+
+    std::size_t VertexHelper::GetCompressedSizeInBytes(VertexFormat format)
+    {
+        std::size_t size = 0;
+
+        if (static_cast<int>(format & VertexFormat::Position3)) 
+            size += 8;
+
+        if (static_cast<int>(format & VertexFormat::Normal3)) 
+            size += 4;
+
+        if (static_cast<int>(format & VertexFormat::TexCoord2)) 
+            size += 4;
+
+        if (static_cast<int>(format & VertexFormat::TexCoord3)) 
+            size += 8;
+
+        if (static_cast<int>(format & VertexFormat::Color4))
+            size += 4;
+
+        if (static_cast<int>(format & VertexFormat::Tangent4))
+            size += 4;
+
+        return size;
+    }
+
+    const char* VertexHelper::GetLayoutName(VertexLayout layout)
+    {
+        switch (layout)
+        {
+        case VertexLayout::Separate:
+            return "separate";
+        case VertexLayout::Interleaved:
+            return "interleaved";
+        case VertexLayout::PositionSplit:
+            return "position-split";
+        default:
+            return "unknown";
+        }
+    }
     
 }  
\ No newline at end of file
@@ -0,0 +1,318 @@
+#include <GL3/BVH.hpp>
+#include <Core/Macros.hpp>
+#include <Core/ThreadPool.hpp>
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+#if defined(SIMD_SSE2)
+#include <emmintrin.h>
+#endif
+
+namespace GL3 {
+
+	namespace
+	{
+		constexpr int kNumBins = 12;
+		//! Leaves are not split below this size, nor above it if the split costs more than the leaf
+		constexpr int kMinSplitItems = 3;
+		constexpr int kMaxLeafItems = 8;
+		//! Subtrees larger than this build their children on the thread pool
+		constexpr int kParallelItems = 4096;
+
+		float GetHalfArea(const glm::vec3& boundMin, const glm::vec3& boundMax)
+		{
+			const glm::vec3 size = glm::max(boundMax - boundMin, glm::vec3(0.0f));
+			return size.x * size.y + size.y * size.z + size.z * size.x;
+		}
+
+		glm::vec3 GetCentroid(const BoundingBox& box)
+		{
+			return (box.GetLowerCorner() + box.GetUpperCorner()) * 0.5f;
+		}
+
+		//! Planes in the structure of arrays, the last two always keep the box
+		struct FrustumPlanes
+		{
+			alignas(16) float x[8];
+			alignas(16) float y[8];
+			alignas(16) float z[8];
+			alignas(16) float w[8];
+		};
+
+		//! Returns -1 if the box is fully behind a plane, 1 if it is fully in front of every plane, 0 otherwise
+		int ClassifyBox(const FrustumPlanes& planes, const glm::vec3& boundMin, const glm::vec3& boundMax)
+		{
+			const glm::vec3 center = (boundMin + boundMax) * 0.5f, extent = (boundMax - boundMin) * 0.5f;
+#if defined(SIMD_SSE2)
+			const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+			const __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+			const __m128 ex = _mm_set1_ps(extent.x), ey = _mm_set1_ps(extent.y), ez = _mm_set1_ps(extent.z);
+			int outside = 0, crossing = 0;
+			for (int i = 0; i < 8; i += 4)
+			{
+				const __m128 px = _mm_load_ps(planes.x + i), py = _mm_load_ps(planes.y + i), pz = _mm_load_ps(planes.z + i);
+				const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, cx), _mm_mul_ps(py, cy)),
+												   _mm_add_ps(_mm_mul_ps(pz, cz), _mm_load_ps(planes.w + i)));
+				const __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(px, absMask), ex), _mm_mul_ps(_mm_and_ps(py, absMask), ey)),
+												 _mm_mul_ps(_mm_and_ps(pz, absMask), ez));
+				outside |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+				crossing |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(distance, radius), _mm_setzero_ps()));
+			}
+#else
+			int outside = 0, crossing = 0;
+			for (int i = 0; i < 8; ++i)
+			{
+				const float distance = planes.x[i] * center.x + planes.y[i] * center.y + planes.z[i] * center.z + planes.w[i];
+				const float radius = std::abs(planes.x[i]) * extent.x + std::abs(planes.y[i]) * extent.y + std::abs(planes.z[i]) * extent.z;
+				outside |= distance + radius < 0.0f;
+				crossing |= distance - radius < 0.0f;
+			}
+#endif
+			return outside != 0 ? -1 : (crossing != 0 ? 0 : 1);
+		}
+	}
+
+	BVH::BVH()
+	{
+		//! Do nothing
+	}
+
+	BVH::~BVH()
+	{
+		//! Do nothing
+	}
+
+	void BVH::Build(const std::vector< BoundingBox >& boxes, std::vector< int > items)
+	{
+		Clear();
+		_items = std::move(items);
+		_itemLeaves.assign(boxes.size(), -1);
+		_refitMarks.clear();
+		if (_items.empty())
+			return;
+
+		//! A binary tree with at least one item per leaf has less than twice the items of nodes
+		_nodes.resize(_items.size() * 2 - 1);
+		std::atomic<int> numNodes{ 1 };
+		BuildNode(boxes, 0, 0, static_cast<int>(_items.size()), numNodes);
+		_nodes.resize(numNodes.load());
+		_refitMarks.assign(_nodes.size(), 0);
+	}
+
+	void BVH::BuildNode(const std::vector< BoundingBox >& boxes, int nodeIdx, int begin, int end, std::atomic< int >& numNodes)
+	{
+		Node& node = _nodes[nodeIdx];
+		node.firstItem = begin;
+		node.numItems = end - begin;
+
+		BoundingBox bounds, centroidBounds;
+		for (int i = begin; i < end; ++i)
+		{
+			bounds.Merge(boxes[_items[i]]);
+			centroidBounds.Merge(GetCentroid(boxes[_items[i]]));
+		}
+		node.boundMin = bounds.GetLowerCorner();
+		node.boundMax = bounds.GetUpperCorner();
+
+		const int numItems = end - begin;
+		if (numItems < kMinSplitItems)
+		{
+			for (int i = begin; i < end; ++i)
+				_itemLeaves[_items[i]] = nodeIdx;
+			return;
+		}
+
+		//! Bin the centroids along the longest axis and sweep the split planes between the bins
+		const glm::vec3 centroidSize = centroidBounds.GetUpperCorner() - centroidBounds.GetLowerCorner();
+		const int axis = centroidSize.x >= centroidSize.y ? (centroidSize.x >= centroidSize.z ? 0 : 2) : (centroidSize.y >= centroidSize.z ? 1 : 2);
+		const float axisMin = centroidBounds.GetLowerCorner()[axis];
+		const float binScale = centroidSize[axis] > 0.0f ? kNumBins / centroidSize[axis] : 0.0f;
+		auto getBin = [&](int item) {
+			return std::min(static_cast<int>((GetCentroid(boxes[item])[axis] - axisMin) * binScale), kNumBins - 1);
+		};
+
+		int splitBin = -1;
+		if (binScale > 0.0f)
+		{
+			BoundingBox binBounds[kNumBins];
+			int binCounts[kNumBins] = { 0 };
+			for (int i = begin; i < end; ++i)
+			{
+				const int bin = getBin(_items[i]);
+				binBounds[bin].Merge(boxes[_items[i]]);
+				++binCounts[bin];
+			}
+
+			//! Right side costs of the splits after each bin, then the left side sweep
+			float rightCosts[kNumBins] = { 0.0f };
+			BoundingBox right;
+			int rightCount = 0;
+			for (int bin = kNumBins - 1; bin > 0; --bin)
+			{
+				if (!binBounds[bin].IsEmpty())
+					right.Merge(binBounds[bin]);
+				rightCount += binCounts[bin];
+				rightCosts[bin - 1] = right.IsEmpty() ? 0.0f : rightCount * GetHalfArea(right.GetLowerCorner(), right.GetUpperCorner());
+			}
+
+			float bestCost = std::numeric_limits<float>::max();
+			BoundingBox left;
+			int leftCount = 0;
+			for (int bin = 0; bin < kNumBins - 1; ++bin)
+			{
+				if (!binBounds[bin].IsEmpty())
+					left.Merge(binBounds[bin]);
+				leftCount += binCounts[bin];
+				if (leftCount == 0 || leftCount == numItems)
+					continue;
+				const float cost = leftCount * GetHalfArea(left.GetLowerCorner(), left.GetUpperCorner()) + rightCosts[bin];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					splitBin = bin;
+				}
+			}
+
+			//! Traversal cost of one box against the items of the leaf
+			const float leafCost = numItems * GetHalfArea(node.boundMin, node.boundMax);
+			if (numItems <= kMaxLeafItems && bestCost + GetHalfArea(node.boundMin, node.boundMax) >= leafCost)
+				splitBin = -2;
+		}
+
+		if (splitBin == -2)
+		{
+			for (int i = begin; i < end; ++i)
+				_itemLeaves[_items[i]] = nodeIdx;
+			return;
+		}
+
+		int middle;
+		if (splitBin >= 0)
+		{
+			middle = static_cast<int>(std::partition(_items.begin() + begin, _items.begin() + end, [&](int item) {
+				return getBin(item) <= splitBin;
+			}) - _items.begin());
+		}
+		else
+		{
+			//! Coincident centroids, split in the middle of the items
+			middle = (begin + end) / 2;
+		}
+
+		const int firstChild = numNodes.fetch_add(2);
+		node.firstChild = firstChild;
+		_nodes[firstChild].parent = nodeIdx;
+		_nodes[firstChild + 1].parent = nodeIdx;
+
+		if (numItems >= kParallelItems)
+		{
+			Core::ThreadPool::GetInstance().ParallelFor(2, 1, [&](size_t childBegin, size_t childEnd) {
+				for (size_t child = childBegin; child < childEnd; ++child)
+				{
+					if (child == 0)
+						BuildNode(boxes, firstChild, begin, middle, numNodes);
+					else
+						BuildNode(boxes, firstChild + 1, middle, end, numNodes);
+				}
+			});
+		}
+		else
+		{
+			BuildNode(boxes, firstChild, begin, middle, numNodes);
+			BuildNode(boxes, firstChild + 1, middle, end, numNodes);
+		}
+	}
+
+	void BVH::Refit(const std::vector< BoundingBox >& boxes, const std::vector< int >& changedItems)
+	{
+		//! Mark the paths from the changed leaves up to the first node already marked
+		_refitNodes.clear();
+		for (int item : changedItems)
+		{
+			int nodeIdx = _itemLeaves[item];
+			while (nodeIdx != -1 && _refitMarks[nodeIdx] == 0)
+			{
+				_refitMarks[nodeIdx] = 1;
+				_refitNodes.push_back(nodeIdx);
+				nodeIdx = _nodes[nodeIdx].parent;
+			}
+		}
+
+		//! Children are allocated after their parent, the descending order visits them first
+		std::sort(_refitNodes.begin(), _refitNodes.end(), std::greater<int>());
+		for (int nodeIdx : _refitNodes)
+		{
+			UpdateBounds(boxes, _nodes[nodeIdx]);
+			_refitMarks[nodeIdx] = 0;
+		}
+	}
+
+	void BVH::UpdateBounds(const std::vector< BoundingBox >& boxes, Node& node) const
+	{
+		if (node.firstChild != -1)
+		{
+			const Node& left = _nodes[node.firstChild];
+			const Node& right = _nodes[node.firstChild + 1];
+			node.boundMin = glm::min(left.boundMin, right.boundMin);
+			node.boundMax = glm::max(left.boundMax, right.boundMax);
+			return;
+		}
+
+		BoundingBox bounds;
+		for (int i = node.firstItem; i < node.firstItem + node.numItems; ++i)
+			bounds.Merge(boxes[_items[i]]);
+		node.boundMin = bounds.GetLowerCorner();
+		node.boundMax = bounds.GetUpperCorner();
+	}
+
+	void BVH::Cull(const std::array< glm::vec4, 6 >& planes, std::vector< int >* visibleItems) const
+	{
+		if (_nodes.empty())
+			return;
+
+		FrustumPlanes soaPlanes;
+		for (int i = 0; i < 8; ++i)
+		{
+			const glm::vec4 plane = i < 6 ? planes[i] : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+			soaPlanes.x[i] = plane.x;
+			soaPlanes.y[i] = plane.y;
+			soaPlanes.z[i] = plane.z;
+			soaPlanes.w[i] = plane.w;
+		}
+
+		//! Subtrees fully inside the frustum append their items without testing the children
+		int stack[64];
+		int stackSize = 0;
+		stack[stackSize++] = 0;
+		while (stackSize > 0)
+		{
+			const Node& node = _nodes[stack[--stackSize]];
+			const int classification = ClassifyBox(soaPlanes, node.boundMin, node.boundMax);
+			if (classification < 0)
+				continue;
+
+			if (classification > 0 || node.firstChild == -1 || stackSize + 2 > 64)
+			{
+				visibleItems->insert(visibleItems->end(), _items.begin() + node.firstItem, _items.begin() + node.firstItem + node.numItems);
+				continue;
+			}
+			stack[stackSize++] = node.firstChild + 1;
+			stack[stackSize++] = node.firstChild;
+		}
+	}
+
+	size_t BVH::GetNumNodes() const
+	{
+		return _nodes.size();
+	}
+
+	void BVH::Clear()
+	{
+		_nodes.clear();
+		_items.clear();
+		_itemLeaves.clear();
+		_refitNodes.clear();
+		_refitMarks.clear();
+	}
+};
\ No newline at end of file
@@ -71,6 +71,22 @@ namespace GL3 {
 		}
 	}
 
+	BoundingBox BoundingBox::Transform(const glm::mat4& matrix) const
+	{
+		BoundingBox transformed;
+		if (_bFirstMerge)
+			return transformed;
+
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			const glm::vec3 point((corner & 1) ? _upperCorner.x : _lowerCorner.x,
+								  (corner & 2) ? _upperCorner.y : _lowerCorner.y,
+								  (corner & 4) ? _upperCorner.z : _lowerCorner.z);
+			transformed.Merge(glm::vec3(matrix * glm::vec4(point, 1.0f)));
+		}
+		return transformed;
+	}
+
 	void BoundingBox::Reset()
 	{
 		this->_lowerCorner = glm::vec3(0.0f);
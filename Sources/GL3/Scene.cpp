@@ -1,9 +1,14 @@
 #include <GL3/Scene.hpp>
 #include <GL3/Shader.hpp>
 #include <Core/Macros.hpp>
+#include <Core/Quantization.hpp>
+#include <Core/RadixSort.hpp>
+#include <Core/ThreadPool.hpp>
 #include <glad/glad.h>
-#include <bitset>
+#include <glm/gtc/matrix_access.hpp>
+#include <cstring>
 #include <algorithm>
+#include <limits>
 #include <chrono>
 
 using namespace glm;
@@ -17,14 +22,14 @@ namespace GL3 {
 
 	Scene::~Scene()
 	{
-		//! Do nothing
+		WaitForFrame();
 	}
 
-	bool Scene::Initialize(const std::string& filename, Core::VertexFormat format)
+	bool Scene::Initialize(const std::string& filename, Core::VertexFormat format, const Core::GLTFLoadOptions& options, Core::VertexLayout layout)
 	{
 		auto timerStart = std::chrono::high_resolution_clock::now();
 
-		if (!Core::GLTFScene::Initialize(filename, format, [&](const tinygltf::Image& image) {
+		if (!Core::GLTFScene::Initialize(filename, format, options, [&](const GLTFImage& image) {
 			std::string name = image.name.empty() ? std::string("texture") + std::to_string(this->_textures.size()) : image.name;
 			GLuint texture;
 			glCreateTextures(GL_TEXTURE_2D, 1, &texture);
@@ -33,7 +38,7 @@ namespace GL3 {
 			glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 			glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 			glTextureStorage2D(texture, 1, GL_RGBA8, image.width, image.height);
-			glTextureSubImage2D(texture, 0, 0, 0, image.width, image.height, GL_RGBA, GL_UNSIGNED_BYTE, &image.image[0]);
+			glTextureSubImage2D(texture, 0, 0, 0, image.width, image.height, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.data());
 			glGenerateTextureMipmap(texture);
 			_debug.SetObjectName(GL_TEXTURE, texture, name);
 			_textures.emplace_back(texture);
@@ -44,47 +49,17 @@ namespace GL3 {
 		auto elapsed = std::chrono::duration<double, std::milli>(timerEnd - timerStart).count();
 		std::cout << "Loading Scene " << filename << " took " << elapsed << " (ms)\n";
 
-		//! vertex buffer storages index
-		int index = 0;
-
-		//! Resize vertex buffer storage with number of vertex attribute type in given format,
-		//! additionally index buffer also added.
-		_buffers.resize(std::bitset<static_cast<unsigned int>(Core::VertexFormat::Last)>(
-						static_cast<unsigned int>(format)).count() + 1);
-
 		//! Create & Bind vertex array object
 		glCreateVertexArrays(1, &_vao);
 		_debug.SetObjectName(GL_VERTEX_ARRAY, _vao, "Scene Vertex Array Object");
-		glCreateBuffers(_buffers.size(), _buffers.data());
-
-		//! Temporary buffer binding lambda function
-		auto bindingBuffer = [&](void* data, size_t num, Core::VertexFormat attribute) {
-			if (static_cast<int>(format & attribute))
-			{
-				const size_t numFloats = Core::VertexHelper::GetNumberOfFloats(attribute);
-				const size_t stride = numFloats * sizeof(float);
-				glNamedBufferStorage(_buffers[index], num * stride, data, GL_MAP_READ_BIT);
-				glVertexArrayVertexBuffer(_vao, index, _buffers[index], 0, stride);
-				glEnableVertexArrayAttrib(_vao, index);
-				glVertexArrayAttribFormat(_vao, index, numFloats, GL_FLOAT, GL_FALSE, 0);
-				glVertexArrayAttribBinding(_vao, index, index);
-				_debug.SetObjectName(GL_BUFFER, _buffers[index], "Scene Buffer #" + std::to_string(index));
-				++index;
-			}
-		};
 
 		//! Create & Bind the vertex buffers
-		bindingBuffer(_positions.data(), _positions.size(), Core::VertexFormat::Position3);
-		bindingBuffer(_normals.data(),	 _normals.size(),	Core::VertexFormat::Normal3	 );
-		bindingBuffer(_tangents.data(),  _tangents.size(),	Core::VertexFormat::Tangent4 );
-		bindingBuffer(_colors.data(),	 _colors.size(),	Core::VertexFormat::Color4	 );
-		bindingBuffer(_texCoords.data(), _texCoords.size(), Core::VertexFormat::TexCoord2);
+		_compressedAttributes = options.compressAttributes;
+		CreateVertexBuffers(format, layout);
 
 		//! Create buffers for indices
-		glCreateBuffers(1, &_ebo);
-		glNamedBufferStorage(_ebo, _indices.size() * sizeof(unsigned int), _indices.data(), GL_MAP_READ_BIT);
-		glVertexArrayElementBuffer(_vao, _ebo);
-		_debug.SetObjectName(GL_BUFFER, _ebo, "Scene Element Buffer");
+		CreateElementBuffer(options.shortIndices);
+		CreateNodeSpheres();
 
 		//! Create shader storage buffer object for matrices of scene nodes
 		const size_t numMatrices = std::count_if(_sceneNodes.begin(), _sceneNodes.end(), [](const GLTFNode& node){
@@ -97,8 +72,70 @@ namespace GL3 {
 		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 		_debug.SetObjectName(GL_BUFFER, _matrixBuffer, "Scene Instance Buffer");
 
-		//! Initialize matrix buffer contents
-		UpdateMatrixBuffer();
+		//! Initialize matrix buffer contents and both frames
+		_matrixIndices.resize(_sceneNodes.size() + 1);
+		for (size_t i = 0; i < _sceneNodes.size(); ++i)
+			_matrixIndices[i + 1] = _matrixIndices[i] + (_sceneNodes[i].primMeshes.empty() ? 0 : 1);
+		for (auto& frame : _frames)
+		{
+			frame.matrices.resize(numMatrices);
+			StageMatrices(frame, 0, static_cast<int>(_sceneNodes.size()));
+			frame.jointPalette = _jointPalette;
+			frame.morphWeights = _morphWeights;
+		}
+		if (numMatrices > 0)
+			glNamedBufferSubData(_matrixBuffer, 0, numMatrices * sizeof(NodeMatrix), _frames[0].matrices.data());
+
+		//! Create shader storage buffer object for the joint palettes of the skins
+		if (!_jointPalette.empty())
+		{
+			glGenBuffers(1, &_jointBuffer);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, _jointBuffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, _jointPalette.size() * sizeof(glm::mat4), _jointPalette.data(), GL_DYNAMIC_DRAW);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, _jointBuffer);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+			_debug.SetObjectName(GL_BUFFER, _jointBuffer, "Scene Joint Buffer");
+		}
+
+		//! Create shader storage buffer objects for the packed morph deltas and the targets with a non-zero weight
+		if (!_morphTargets.empty())
+		{
+			static_assert(sizeof(GltfMorphDelta) == sizeof(GLTFMorphDelta), "Morph delta layout must match gltf.glsl");
+			glCreateBuffers(1, &_morphDeltaBuffer);
+			const auto morphDeltas = GetMorphDeltas();
+			glNamedBufferStorage(_morphDeltaBuffer, std::max<size_t>(morphDeltas.size(), 1) * sizeof(GLTFMorphDelta), morphDeltas.empty() ? nullptr : morphDeltas.data(), 0);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, _morphDeltaBuffer);
+			_debug.SetObjectName(GL_BUFFER, _morphDeltaBuffer, "Scene Morph Delta Buffer");
+
+			//! Sized for every target of every drawn primitive, the weights select a part of them
+			size_t numDrawnTargets = 0;
+			for (const auto& node : _sceneNodes)
+			{
+				for (unsigned int meshIdx : node.primMeshes)
+					numDrawnTargets += std::min(_scenePrimMeshes[meshIdx].morphTargetCount, node.weightCount);
+			}
+			_morphTargetData.resize(numDrawnTargets);
+			glCreateBuffers(1, &_morphTargetBuffer);
+			glNamedBufferStorage(_morphTargetBuffer, std::max<size_t>(numDrawnTargets, 1) * sizeof(GltfMorphTarget), nullptr, GL_DYNAMIC_STORAGE_BIT);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, _morphTargetBuffer);
+			_debug.SetObjectName(GL_BUFFER, _morphTargetBuffer, "Scene Morph Target Buffer");
+		}
+		CreateDrawBuffers();
+		UpdateMorphBuffer(_morphWeights);
+
+		//! Compute pass of the GPU culling
+		_cullShader = std::make_unique< Shader >();
+		if (!_cullShader->Initialize({ {GL_COMPUTE_SHADER, RESOURCES_DIR "shaders/cull.comp"} }))
+		{
+			std::cerr << "[Scene:Initialize] Failed to create the culling shader" << std::endl;
+			return false;
+		}
+		_hiZShader = std::make_unique< Shader >();
+		if (!_hiZShader->Initialize({ {GL_COMPUTE_SHADER, RESOURCES_DIR "shaders/hiz.comp"} }))
+		{
+			std::cerr << "[Scene:Initialize] Failed to create the Hi-Z shader" << std::endl;
+			return false;
+		}
 
 		//! Create shader storage buffer object for materials and fill it
 		std::vector<GltfShadeMaterial> materials;
@@ -141,23 +178,126 @@ namespace GL3 {
 
 	void Scene::Update(double dt)
 	{
-		bool sceneModified = UpdateAnimation(_animIndex, _timeElapsed);
+		//! The frame of the current time is staged by the worker issued in the last update, otherwise here
+		if (_frameInFlight)
+		{
+			WaitForFrame();
+		}
+		else
+		{
+			const int front = _frontFrame.load(std::memory_order_relaxed);
+			IssueFrame(_frames[1 - front]);
+			StageFrame(_frames[1 - front], _frames[front]);
+		}
 
-		//! If the scene is modified, update the matrix buffer
-		if (sceneModified)
-			UpdateMatrixBuffer();			
+		//! Only this thread swaps the frames and the worker is idle here
+		const int front = 1 - _frontFrame.load(std::memory_order_relaxed);
+		_frontFrame.store(front, std::memory_order_release);
+		UploadFrame(_frames[front]);
+		if (_cpuCulling)
+			RefitDrawBoxes(_frames[front]);
+		//! The depths of the moved draws are stale
+		if (!_frames[front].matrixRanges.empty())
+			_queueDirty = true;
 
 		_timeElapsed += dt;
+		for (auto& layer : _animationLayers)
+			layer.timeElapsed += static_cast<float>(dt);
+
+		//! Stage the next frame on a worker while this one is drawn
+		if (_updateMode == UpdateMode::Pipelined)
+		{
+			FrameState& next = _frames[1 - front];
+			IssueFrame(next);
+			_frameStaged.store(false, std::memory_order_relaxed);
+			_frameInFlight = true;
+			Core::ThreadPool::GetInstance().Enqueue([this, &next, front]() {
+				StageFrame(next, _frames[front]);
+				_frameStaged.store(true, std::memory_order_release);
+			});
+		}
+	}
+
+	void Scene::SetUpdateMode(UpdateMode mode)
+	{
+		_updateMode = mode;
+	}
+
+	const Scene::AnimationStats& Scene::GetFrameAnimationStats() const
+	{
+		return _frames[_frontFrame.load(std::memory_order_acquire)].stats;
+	}
+
+	void Scene::IssueFrame(FrameState& frame)
+	{
+		if (_animationLod && _lodProjectionScale > 0.0f)
+			UpdateAnimationLods();
+		else
+			_nodeUpdatePeriods.clear();
+
+		frame.time = static_cast<float>(_timeElapsed);
+		frame.animIndex = _animIndex;
+		frame.layers = _animationLayers;
 	}
 
-	void Scene::Render(const std::shared_ptr< Shader >& shader, GLenum alphaMode) const
+	void Scene::StageFrame(FrameState& frame, const FrameState& previous)
 	{
-		UNUSED_VARIABLE(alphaMode);
+		frame.sceneModified = frame.layers.empty() ? UpdateAnimation(static_cast<int>(frame.animIndex), frame.time) : UpdateAnimation(frame.layers);
+		frame.stats = GetAnimationStats();
 
+		//! The frame was staged two updates ago, it misses only the matrices changed by the previous frame
+		for (const auto& range : previous.matrixRanges)
+			std::copy(previous.matrices.begin() + range.first, previous.matrices.begin() + range.second, frame.matrices.begin() + range.first);
+		frame.matrixRanges.clear();
+		if (!frame.sceneModified)
+			return;
+
+		for (const auto& range : _updatedNodeRanges)
+		{
+			const int firstMatrix = _matrixIndices[range.first], lastMatrix = _matrixIndices[range.second];
+			if (firstMatrix == lastMatrix)
+				continue;
+			StageMatrices(frame, range.first, range.second);
+			frame.matrixRanges.emplace_back(firstMatrix, lastMatrix);
+		}
+		frame.jointPalette = _jointPalette;
+		frame.morphWeights = _morphWeights;
+	}
+
+	void Scene::UploadFrame(const FrameState& frame)
+	{
+		//! Only the matrices of the updated subtrees are uploaded
+		if (!frame.sceneModified)
+			return;
+
+		for (const auto& range : frame.matrixRanges)
+			glNamedBufferSubData(_matrixBuffer, range.first * sizeof(NodeMatrix), (range.second - range.first) * sizeof(NodeMatrix), frame.matrices.data() + range.first);
+		if (_jointBuffer != 0)
+			glNamedBufferSubData(_jointBuffer, 0, frame.jointPalette.size() * sizeof(glm::mat4), frame.jointPalette.data());
+		UpdateMorphBuffer(frame.morphWeights);
+	}
+
+	void Scene::WaitForFrame()
+	{
+		if (!_frameInFlight)
+			return;
+		Core::ThreadPool::GetInstance().WaitFor(_frameStaged);
+		_frameInFlight = false;
+	}
+
+	void Scene::Render(const std::shared_ptr< Shader >& shader, const std::shared_ptr< Shader >& opaqueShader)
+	{
 		auto scope = _debug.ScopeLabel("Scene Rendering");
 		glBindVertexArray(_vao);
 		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, _matrixBuffer);
 		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, _materialBuffer);
+		if (_jointBuffer != 0)
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, _jointBuffer);
+		if (_morphTargetBuffer != 0)
+		{
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, _morphDeltaBuffer);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, _morphTargetBuffer);
+		}
 
 		//! Use block-scope for calling destructor of scope label instance
 		{
@@ -166,62 +306,899 @@ namespace GL3 {
 				glBindTextureUnit(i + 3, _textures[i]);
 		}
 
-		int lastMaterialIdx = -1, instanceIdx = 0;
-		for (auto& node : _sceneNodes)
+		//! Always sent since the shaders may be shared with the other scenes
+		const auto& opaque = opaqueShader ? opaqueShader : shader;
+		for (const auto& passShader : { opaque, shader })
 		{
-			shader->SendUniformVariable("instanceIdx", instanceIdx);
+			passShader->BindShaderProgram();
+			passShader->SendUniformVariable("compressedAttributes", static_cast<int>(_compressedAttributes));
+			passShader->SendUniformVariable("indirectDraws", static_cast<int>(_indirectDraws));
+		}
 
-			for (unsigned int meshIdx : node.primMeshes)
+		//! The nodes are being animated by the worker, the matrices of the drawn frame are read instead
+		const FrameState& frame = _frames[_frontFrame.load(std::memory_order_acquire)];
+		if (_cpuCulling && _lodProjectionScale > 0.0f)
+			CullDrawsCpu();
+		else if (_cpuCulling)
+			std::fill(_drawVisible.begin(), _drawVisible.end(), 1);
+		BuildRenderQueue(frame);
+
+		if (_indirectDraws)
+		{
+			DrawIndirect(opaque, shader, frame);
+		}
+		else
+		{
+			opaque->BindShaderProgram();
+			DrawDirect(opaque, frame, _queueGroups[0], _queueGroups[2]);
+			shader->BindShaderProgram();
+			DrawDirect(shader, frame, _queueGroups[2], _queueGroups[4]);
+			BeginBlendPass();
+			DrawDirect(shader, frame, _queueGroups[4], static_cast<int>(_queueOrder.size()));
+			EndBlendPass();
+		}
+
+		glBindVertexArray(0);
+	}
+
+	void Scene::SetIndirectDraws(bool enabled)
+	{
+		_indirectDraws = enabled;
+	}
+
+	void Scene::SetGpuCulling(bool enabled, bool readbackStats)
+	{
+		_gpuCulling = enabled;
+		_cullStats = readbackStats;
+	}
+
+	void Scene::SetOcclusionCulling(bool enabled)
+	{
+		_occlusionCulling = enabled;
+	}
+
+	size_t Scene::GetNumVisibleDraws() const
+	{
+		return _numVisibleDraws;
+	}
+
+	void Scene::BuildRenderQueue(const FrameState& frame)
+	{
+		//! Smaller moves of the eye keep the order, the coarse depths of the opaque draws barely change
+		constexpr float kResortDistance = 0.01f;
+		if (!_queueDirty && glm::length(_lodEye - _queueEye) <= kResortDistance * _sceneDim.radius)
+			return;
+		_queueDirty = false;
+		_queueEye = _lodEye;
+
+		//! Keys from the high bits : pass(2), then index type(1), coarse depth(12) and material(16) for the opaque and masked draws
+		//! or the inverted depth(32) for the blended ones, the farthest first
+		constexpr size_t kSortGrainSize = 4096;
+		const size_t numDraws = _drawItems.size();
+		_sortKeys.resize(numDraws);
+		_queueOrder.resize(numDraws);
+		Core::ThreadPool::GetInstance().ParallelFor(numDraws, kSortGrainSize, [&](std::size_t begin, std::size_t end) {
+			for (size_t drawIdx = begin; drawIdx < end; ++drawIdx)
 			{
-				auto& primMesh = _scenePrimMeshes[meshIdx];
-				if (primMesh.materialIndex != lastMaterialIdx)
+				const auto& item = _drawItems[drawIdx];
+				const auto& primMesh = _scenePrimMeshes[item.meshIdx];
+				const int alphaMode = _sceneMaterials.empty() ? 0 : _sceneMaterials[primMesh.materialIndex].alphaMode;
+				const glm::vec3 center = glm::vec3(frame.matrices[_matrixIndices[item.nodeIdx]].first * glm::vec4((primMesh.min + primMesh.max) * 0.5f, 1.0f));
+				//! The bits of a non-negative float sort as the float
+				const float distance = glm::length(center - _lodEye);
+				std::uint32_t depthBits;
+				std::memcpy(&depthBits, &distance, sizeof(depthBits));
+
+				std::uint64_t key = static_cast<std::uint64_t>(alphaMode) << 62;
+				if (alphaMode == static_cast<int>(RenderPass::Blend))
+				{
+					key |= static_cast<std::uint64_t>(~depthBits) << 30;
+				}
+				else
 				{
-					auto materialScope = _debug.ScopeLabel("Material Binding: " + std::to_string(instanceIdx));
-					shader->SendUniformVariable("materialIdx", primMesh.materialIndex);
-					lastMaterialIdx = primMesh.materialIndex;
+					key |= static_cast<std::uint64_t>(_indexRanges[item.meshIdx][0].type == GL_UNSIGNED_SHORT) << 61;
+					key |= static_cast<std::uint64_t>((depthBits >> 19) & 0xFFF) << 49;
+					key |= static_cast<std::uint64_t>(primMesh.materialIndex & 0xFFFF) << 33;
 				}
+				_sortKeys[drawIdx] = key;
+				_queueOrder[drawIdx] = static_cast<int>(drawIdx);
+			}
+		});
+		Core::RadixSort(_sortKeys, _queueOrder, _sortScratchKeys, _sortScratchValues);
 
-				auto drawScope = _debug.ScopeLabel("Draw Mesh: " + std::to_string(instanceIdx));
-				//! Draw elements with primitive mesh index informations.
-				glDrawElementsBaseVertex(GL_TRIANGLES, primMesh.indexCount, GL_UNSIGNED_INT,
-					reinterpret_cast<const void*>(primMesh.firstIndex * sizeof(unsigned int)), primMesh.vertexOffset);
+		//! Each multi-draw takes a single index type, the LODs keep the type of their primitive.
+		//! The opaque and masked draws are grouped by type, the blended ones are split wherever it changes to keep their order.
+		_queueRuns.clear();
+		size_t i = 0;
+		for (int group = 0; group < 4; ++group)
+		{
+			_queueGroups[group] = static_cast<int>(i);
+			while (i < numDraws && (_sortKeys[i] >> 61) == static_cast<std::uint64_t>(group))
+				++i;
+			if (i > static_cast<size_t>(_queueGroups[group]))
+				_queueRuns.push_back({ static_cast<RenderPass>(group / 2), group % 2 == 0 ? GLenum(GL_UNSIGNED_INT) : GLenum(GL_UNSIGNED_SHORT),
+									   _queueGroups[group], static_cast<int>(i) - _queueGroups[group] });
+		}
+		_queueGroups[4] = static_cast<int>(i);
+		for (; i < numDraws; ++i)
+		{
+			const GLenum type = _indexRanges[_drawItems[_queueOrder[i]].meshIdx][0].type;
+			if (_queueRuns.empty() || _queueRuns.back().pass != RenderPass::Blend || _queueRuns.back().type != type)
+				_queueRuns.push_back({ RenderPass::Blend, type, static_cast<int>(i), 0 });
+			++_queueRuns.back().count;
+		}
+	}
 
-				++instanceIdx;
+	void Scene::DrawIndirect(const std::shared_ptr< Shader >& opaqueShader, const std::shared_ptr< Shader >& shader, const FrameState& frame)
+	{
+		auto drawScope = _debug.ScopeLabel("Multi Draw Indirect");
+
+		//! Only the selected LODs and the order of the queue change the commands, the records are indexed by the base instance
+		bool isModified = false;
+		_numBlendDraws = 0;
+		for (size_t i = 0; i < _queueOrder.size(); ++i)
+		{
+			const int drawIdx = _queueOrder[i];
+			const auto& item = _drawItems[drawIdx];
+			const auto& primMesh = _scenePrimMeshes[item.meshIdx];
+			const auto& indexRange = _indexRanges[item.meshIdx][SelectLod(primMesh, GetProjectedScale(frame, item.nodeIdx))];
+			const GLuint indexSize = indexRange.type == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+			const DrawCommand command{ indexRange.count, static_cast<GLuint>(_drawVisible[drawIdx]), static_cast<GLuint>(indexRange.offset / indexSize),
+									   static_cast<GLint>(primMesh.vertexOffset), static_cast<GLuint>(drawIdx) };
+			DrawCommand& cached = _drawCommands[i];
+			if (std::memcmp(&cached, &command, sizeof(DrawCommand)) != 0)
+			{
+				cached = command;
+				isModified = true;
 			}
+			if (static_cast<int>(i) >= _queueGroups[4])
+				_numBlendDraws += command.instanceCount;
 		}
+		if (_drawCommands.empty())
+			return;
+		if (isModified)
+			glNamedBufferSubData(_drawCommandBuffer, 0, _drawCommands.size() * sizeof(DrawCommand), _drawCommands.data());
 
-		glBindVertexArray(0);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, _drawRecordBuffer);
+		const auto submitDepthPasses = [&](GLuint commandBuffer) {
+			opaqueShader->BindShaderProgram();
+			SubmitCommands(commandBuffer, RenderPass::Opaque);
+			shader->BindShaderProgram();
+			SubmitCommands(commandBuffer, RenderPass::Mask);
+		};
+
+		const bool isCulled = (_gpuCulling || _occlusionCulling) && _queueGroups[4] > 0;
+		if (!isCulled)
+		{
+			submitDepthPasses(_drawCommandBuffer);
+		}
+		else
+		{
+			//! The counts lag a few frames behind, the pending copies are not waited for
+			if (_cullStats)
+				ReadDrawCounts();
+			glClearNamedBufferSubData(_drawCountBuffer, GL_R32UI, 0, 8 * sizeof(GLuint), GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+			//! The pyramid is built from the depth attachment of the bound framebuffer, frustum culling only without it
+			const GLuint depthTexture = _occlusionCulling ? GetBoundDepthTexture() : 0;
+			if (depthTexture != 0)
+			{
+				//! Draws visible in the last frame fill the depth, then the hidden ones are tested against it
+				CullDraws(CullPhase::Visible);
+				submitDepthPasses(_culledCommandBuffer);
+
+				BuildHiZ(depthTexture);
+				CullDraws(CullPhase::Occlusion);
+				submitDepthPasses(_culledCommandBuffer);
+			}
+			else
+			{
+				CullDraws(CullPhase::Frustum);
+				submitDepthPasses(_culledCommandBuffer);
+			}
+
+			if (_cullStats)
+				CopyDrawCounts();
+		}
+
+		//! Compacting would lose the order of the blended draws, they are submitted from the sorted commands
+		if (_queueGroups[4] < static_cast<int>(_drawCommands.size()))
+		{
+			shader->BindShaderProgram();
+			BeginBlendPass();
+			SubmitCommands(_drawCommandBuffer, RenderPass::Blend);
+			EndBlendPass();
+		}
+	}
+
+	void Scene::CopyDrawCounts()
+	{
+		//! All the slots are in flight, this frame is not counted rather than stalling on the oldest
+		GLsync& fence = _drawCountFences[_drawCountSlot];
+		if (fence != nullptr)
+			return;
+
+		//! The counters are written by the atomics of the cull shader, the copy must see them
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+		glCopyNamedBufferSubData(_drawCountBuffer, _drawCountReadback, 0, _drawCountSlot * 8 * sizeof(GLuint), 8 * sizeof(GLuint));
+		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		_drawCountSlot = (_drawCountSlot + 1) % kDrawCountSlots;
+	}
+
+	void Scene::ReadDrawCounts()
+	{
+		//! The oldest copy is at the current slot, the later ones cannot be done before it
+		for (int i = 0; i < kDrawCountSlots; ++i)
+		{
+			const int slot = (_drawCountSlot + i) % kDrawCountSlots;
+			GLsync& fence = _drawCountFences[slot];
+			if (fence == nullptr)
+				continue;
+			const GLenum status = glClientWaitSync(fence, 0, 0);
+			if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+				break;
+			glDeleteSync(fence);
+			fence = nullptr;
+
+			//! The mapping is coherent, the signalled fence makes the copy visible
+			_numVisibleDraws = _numBlendDraws;
+			for (int c = 0; c < 8; ++c)
+				_numVisibleDraws += _drawCountMapped[slot * 8 + c];
+		}
+	}
+
+	void Scene::SubmitCommands(GLuint commandBuffer, RenderPass pass) const
+	{
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+		for (const auto& run : _queueRuns)
+		{
+			if (run.pass == pass)
+				glMultiDrawElementsIndirect(GL_TRIANGLES, run.type, reinterpret_cast<const void*>(run.first * sizeof(DrawCommand)), run.count, 0);
+		}
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+
+	void Scene::BeginBlendPass() const
+	{
+		//! The blended draws are tested against the depth of the others without writing it
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glDepthMask(GL_FALSE);
+	}
+
+	void Scene::EndBlendPass() const
+	{
+		glDepthMask(GL_TRUE);
+		glDisable(GL_BLEND);
+	}
+
+	void Scene::CullDraws(CullPhase phase)
+	{
+		auto cullScope = _debug.ScopeLabel("GPU Culling Phase " + std::to_string(static_cast<int>(phase)));
+
+		//! The culled commands stay zero past the visible ones, the multi-draws skip them.
+		//! The draws of the first phase are already submitted, the buffer is cleared after them.
+		glClearNamedBufferSubData(_culledCommandBuffer, GL_R32UI, 0, _queueGroups[4] * sizeof(DrawCommand), GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+		constexpr GLuint kCullGroupSize = 64;
+		_cullShader->BindShaderProgram();
+		for (size_t i = 0; i < _queueGroups.size(); ++i)
+			_cullShader->SendUniformVariable("groupFirsts[" + std::to_string(i) + "]", _queueGroups[i]);
+		_cullShader->SendUniformVariable("cullPhase", static_cast<int>(phase));
+		_cullShader->SendUniformVariable("hiZLevels", _hiZLevels);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, _drawCommandBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 9, _culledCommandBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 10, _drawCountBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 11, _visibilityBuffer);
+		if (phase == CullPhase::Occlusion)
+			glBindTextureUnit(kHiZTextureUnit, _hiZTexture);
+		glDispatchCompute((static_cast<GLuint>(_queueGroups[4]) + kCullGroupSize - 1) / kCullGroupSize, 1, 1);
+		glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+	}
+
+	void Scene::BuildHiZ(GLuint depthTexture)
+	{
+		auto hiZScope = _debug.ScopeLabel("Hi-Z Pyramid");
+
+		//! Reallocated with the depth buffer
+		GLint width = 0, height = 0;
+		glGetTextureLevelParameteriv(depthTexture, 0, GL_TEXTURE_WIDTH, &width);
+		glGetTextureLevelParameteriv(depthTexture, 0, GL_TEXTURE_HEIGHT, &height);
+		if (width != _hiZWidth || height != _hiZHeight)
+		{
+			glDeleteTextures(1, &_hiZTexture);
+			_hiZWidth = width;
+			_hiZHeight = height;
+			_hiZLevels = 1;
+			while ((std::max(width, height) >> _hiZLevels) > 0)
+				++_hiZLevels;
+			glCreateTextures(GL_TEXTURE_2D, 1, &_hiZTexture);
+			glTextureParameteri(_hiZTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+			glTextureParameteri(_hiZTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTextureStorage2D(_hiZTexture, _hiZLevels, GL_R32F, width, height);
+			_debug.SetObjectName(GL_TEXTURE, _hiZTexture, "Scene Hi-Z Pyramid");
+		}
+
+		//! Each level keeps the farthest depth of the texels of the previous level it covers
+		constexpr GLuint kHiZGroupSize = 8;
+		_hiZShader->BindShaderProgram();
+		for (int level = 0; level < _hiZLevels; ++level)
+		{
+			const GLuint levelWidth = std::max(width >> level, 1), levelHeight = std::max(height >> level, 1);
+			glBindTextureUnit(kHiZTextureUnit, level == 0 ? depthTexture : _hiZTexture);
+			glBindImageTexture(0, _hiZTexture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+			_hiZShader->SendUniformVariable("sourceLevel", level - 1);
+			glDispatchCompute((levelWidth + kHiZGroupSize - 1) / kHiZGroupSize, (levelHeight + kHiZGroupSize - 1) / kHiZGroupSize, 1);
+			glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+		}
+	}
+
+	GLuint Scene::GetBoundDepthTexture() const
+	{
+		GLint framebuffer = 0;
+		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+		if (framebuffer == 0)
+			return 0;
+
+		GLint type = GL_NONE, name = 0;
+		glGetNamedFramebufferAttachmentParameteriv(framebuffer, GL_DEPTH_ATTACHMENT, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE, &type);
+		if (type != GL_TEXTURE)
+			return 0;
+		glGetNamedFramebufferAttachmentParameteriv(framebuffer, GL_DEPTH_ATTACHMENT, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &name);
+		return static_cast<GLuint>(name);
+	}
+
+	void Scene::DrawDirect(const std::shared_ptr< Shader >& shader, const FrameState& frame, int first, int last) const
+	{
+		int lastMaterialIdx = -1, lastNodeIdx = -1;
+		float projectedScale = 0.0f;
+		for (int i = first; i < last; ++i)
+		{
+			const int drawIdx = _queueOrder[i];
+			if (_drawVisible[drawIdx] == 0)
+				continue;
+
+			const auto& item = _drawItems[drawIdx];
+			if (item.nodeIdx != lastNodeIdx)
+			{
+				const auto& node = _sceneNodes[item.nodeIdx];
+				//! Every primitive of the node shares its matrix
+				shader->SendUniformVariable("instanceIdx", _matrixIndices[item.nodeIdx]);
+				//! Skinned vertices are transformed to the world space by the palette instead of the node matrix
+				shader->SendUniformVariable("jointOffset", node.skin == -1 ? -1 : _sceneSkins[node.skin].jointIndex);
+				projectedScale = GetProjectedScale(frame, item.nodeIdx);
+				lastNodeIdx = item.nodeIdx;
+			}
+
+			auto& primMesh = _scenePrimMeshes[item.meshIdx];
+			if (primMesh.materialIndex != lastMaterialIdx)
+			{
+				auto materialScope = _debug.ScopeLabel("Material Binding: " + std::to_string(drawIdx));
+				shader->SendUniformVariable("materialIdx", primMesh.materialIndex);
+				lastMaterialIdx = primMesh.materialIndex;
+			}
+
+			if (_compressedAttributes)
+			{
+				shader->SendUniformVariable("positionOffset", primMesh.positionOffset);
+				shader->SendUniformVariable("positionScale", primMesh.positionScale);
+			}
+
+			//! Primitives without a non-zero weight skip the blending
+			const auto& morphRange = _morphRanges[drawIdx];
+			shader->SendUniformVariable("morphOffset", morphRange.first);
+			shader->SendUniformVariable("morphCount", morphRange.second);
+
+			auto drawScope = _debug.ScopeLabel("Draw Mesh: " + std::to_string(drawIdx));
+			//! Draw elements with primitive mesh index informations.
+			const auto& indexRange = _indexRanges[item.meshIdx][SelectLod(primMesh, projectedScale)];
+			glDrawElementsBaseVertex(GL_TRIANGLES, indexRange.count, indexRange.type,
+				reinterpret_cast<const void*>(indexRange.offset), primMesh.vertexOffset);
+		}
+	}
+
+	void Scene::SetCpuCulling(bool enabled)
+	{
+		//! The boxes were not refit while disabled
+		if (enabled && !_cpuCulling && !_drawItems.empty())
+		{
+			UpdateDrawBoxes(_frames[_frontFrame.load(std::memory_order_acquire)], 0, static_cast<int>(_drawItems.size()));
+			_drawBvh.Refit(_drawBoxes, _bvhItems);
+		}
+		_cpuCulling = enabled;
+		_drawVisible.assign(_drawItems.size(), 1);
+	}
+
+	void Scene::CullDrawsCpu()
+	{
+		//! Skinned and morphed draws are not in the hierarchy and always drawn
+		std::fill(_drawVisible.begin(), _drawVisible.end(), 1);
+		for (int drawIdx : _bvhItems)
+			_drawVisible[drawIdx] = 0;
+
+		_visibleDraws.clear();
+		_drawBvh.Cull(_lodFrustum, &_visibleDraws);
+		for (int drawIdx : _visibleDraws)
+			_drawVisible[drawIdx] = 1;
+	}
+
+	void Scene::RefitDrawBoxes(const FrameState& frame)
+	{
+		//! The draws of a matrix range are contiguous in the node order
+		_changedDraws.clear();
+		for (const auto& range : frame.matrixRanges)
+		{
+			const int firstDraw = _matrixFirstDraws[range.first], lastDraw = _matrixFirstDraws[range.second];
+			UpdateDrawBoxes(frame, firstDraw, lastDraw);
+			for (int drawIdx = firstDraw; drawIdx < lastDraw; ++drawIdx)
+				_changedDraws.push_back(drawIdx);
+		}
+		if (!_changedDraws.empty())
+			_drawBvh.Refit(_drawBoxes, _changedDraws);
 	}
 
-	void Scene::UpdateMatrixBuffer()
+	void Scene::UpdateDrawBoxes(const FrameState& frame, int firstDraw, int lastDraw)
 	{
-		std::vector<NodeMatrix> matrices;
-		matrices.reserve(_sceneNodes.size());
-		for (const auto& node : _sceneNodes)
+		for (int drawIdx = firstDraw; drawIdx < lastDraw; ++drawIdx)
 		{
+			const auto& item = _drawItems[drawIdx];
+			const auto& primMesh = _scenePrimMeshes[item.meshIdx];
+			BoundingBox localBox;
+			localBox.Merge(primMesh.min);
+			localBox.Merge(primMesh.max);
+			_drawBoxes[drawIdx] = localBox.Transform(frame.matrices[_matrixIndices[item.nodeIdx]].first);
+		}
+	}
+
+	float Scene::GetProjectedScale(const FrameState& frame, size_t nodeIdx) const
+	{
+		//! Object space error times the projected scale gives the error in pixels,
+		//! zero keeps the full detail (selection disabled or the camera inside the bounds).
+		if (_lodProjectionScale <= 0.0f)
+			return 0.0f;
+
+		const glm::vec4& sphere = _nodeSpheres[nodeIdx];
+		const glm::mat4& world = frame.matrices[_matrixIndices[nodeIdx]].first;
+		const float worldScale = std::max({ glm::length(glm::vec3(world[0])),
+											glm::length(glm::vec3(world[1])),
+											glm::length(glm::vec3(world[2])) });
+		const glm::vec3 center(world * glm::vec4(glm::vec3(sphere), 1.0f));
+		const float distance = glm::length(center - _lodEye) - sphere.w * worldScale;
+		return distance > 0.0f ? worldScale * _lodProjectionScale / distance : 0.0f;
+	}
+
+	void Scene::StageMatrices(FrameState& frame, int firstNode, int lastNode) const
+	{
+		for (int i = firstNode; i < lastNode; ++i)
+		{
+			const auto& node = _sceneNodes[i];
 			if (!node.primMeshes.empty())
 			{
-				NodeMatrix instance;
-				instance.first = node.world;
+				NodeMatrix& instance = frame.matrices[_matrixIndices[i]];
+				instance.first = _nodeWorlds[i];
 				if (glm::determinant(instance.first) == 0.0f)
 					instance.second = glm::transpose(instance.first);
 				else
 					instance.second = glm::transpose(glm::inverse(instance.first));
-				matrices.emplace_back(std::move(instance));
 			}
 		}
+	}
 
-		//! TODO(snowapril) : mark only modified node and update the contents of them
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, _matrixBuffer);
-		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, matrices.size() * sizeof(NodeMatrix), matrices.data());
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	void Scene::UpdateMorphBuffer(const std::vector< float >& morphWeights)
+	{
+		if (_morphTargetBuffer == 0 || morphWeights == _uploadedMorphWeights)
+			return;
+
+		//! Only the draws whose weights changed rewrite their slots, contiguous slots are uploaded together
+		const bool compareWeights = _uploadedMorphWeights.size() == morphWeights.size();
+		size_t dirtyFirst = 0, dirtyEnd = 0;
+		auto uploadTargets = [this, &dirtyFirst, &dirtyEnd]() {
+			if (dirtyEnd > dirtyFirst)
+				glNamedBufferSubData(_morphTargetBuffer, dirtyFirst * sizeof(GltfMorphTarget), (dirtyEnd - dirtyFirst) * sizeof(GltfMorphTarget), &_morphTargetData[dirtyFirst]);
+		};
+		for (size_t i = 0; i < _drawItems.size(); ++i)
+		{
+			const auto& node = _sceneNodes[_drawItems[i].nodeIdx];
+			const auto& primMesh = _scenePrimMeshes[_drawItems[i].meshIdx];
+			const int numTargets = std::min(primMesh.morphTargetCount, node.weightCount);
+			if (numTargets <= 0)
+				continue;
+			const float* weights = morphWeights.data() + node.weightIndex;
+			if (compareWeights && std::equal(weights, weights + numTargets, _uploadedMorphWeights.data() + node.weightIndex))
+				continue;
+
+			auto& range = _morphRanges[i];
+			int count = 0;
+			for (int t = 0; t < numTargets; ++t)
+			{
+				if (weights[t] == 0.0f)
+					continue;
+
+				//! Dense ranges are based on the first vertex of the scene, gl_VertexID includes the base vertex
+				const auto& target = _morphTargets[primMesh.morphTargetIndex + t];
+				auto base = [&primMesh](const GLTFMorphRange& range) {
+					return range.sparse ? range.offset : range.offset - static_cast<int>(primMesh.vertexOffset);
+				};
+				_morphTargetData[range.first + count++] = { base(target.position), target.position.count,
+															base(target.normal), target.normal.count,
+															base(target.tangent), target.tangent.count,
+															target.position.sparse | target.normal.sparse << 1 | target.tangent.sparse << 2,
+															weights[t] };
+			}
+			if (static_cast<size_t>(range.first) != dirtyEnd)
+			{
+				uploadTargets();
+				dirtyFirst = range.first;
+			}
+			dirtyEnd = range.first + count;
+
+			//! The draw records carry the counts of the indirect draws, they only change when a weight becomes zero or not
+			if (count != range.second)
+			{
+				range.second = count;
+				_drawRecords[i].morphCount = count;
+				glNamedBufferSubData(_drawRecordBuffer, i * sizeof(GltfDrawRecord), sizeof(GltfDrawRecord), &_drawRecords[i]);
+			}
+		}
+		uploadTargets();
+		_uploadedMorphWeights = morphWeights;
+	}
+
+	void Scene::CreateDrawBuffers()
+	{
+		_drawItems.clear();
+		for (size_t nodeIdx = 0; nodeIdx < _sceneNodes.size(); ++nodeIdx)
+		{
+			for (unsigned int meshIdx : _sceneNodes[nodeIdx].primMeshes)
+				_drawItems.push_back({ static_cast<int>(nodeIdx), meshIdx });
+		}
+		if (_drawItems.empty())
+			return;
+
+		//! Each draw owns the slots of all its morph targets, the weights only select how many of them are used
+		_morphRanges.resize(_drawItems.size());
+		int morphSlot = 0;
+		for (size_t i = 0; i < _drawItems.size(); ++i)
+		{
+			_morphRanges[i] = { morphSlot, 0 };
+			if (!_morphTargets.empty())
+				morphSlot += std::min(_scenePrimMeshes[_drawItems[i].meshIdx].morphTargetCount, _sceneNodes[_drawItems[i].nodeIdx].weightCount);
+		}
+
+		//! Hierarchy over the world boxes of the rigid draws, the skinned and morphed vertices leave their bounds
+		_matrixFirstDraws.assign(_matrixIndices.back() + 1, static_cast<int>(_drawItems.size()));
+		_bvhItems.clear();
+		for (size_t i = _drawItems.size(); i-- > 0;)
+			_matrixFirstDraws[_matrixIndices[_drawItems[i].nodeIdx]] = static_cast<int>(i);
+		for (size_t i = 0; i < _drawItems.size(); ++i)
+		{
+			const auto& node = _sceneNodes[_drawItems[i].nodeIdx];
+			if (node.skin == -1 && (_scenePrimMeshes[_drawItems[i].meshIdx].morphTargetCount == 0 || node.weightCount == 0))
+				_bvhItems.push_back(static_cast<int>(i));
+		}
+		_drawBoxes.resize(_drawItems.size());
+		UpdateDrawBoxes(_frames[0], 0, static_cast<int>(_drawItems.size()));
+		_drawBvh.Build(_drawBoxes, _bvhItems);
+		_drawVisible.assign(_drawItems.size(), 1);
+
+		_queueDirty = true;
+		BuildRenderQueue(_frames[0]);
+
+		//! Commands start empty so that the first submission uploads them
+		_drawCommands.assign(_drawItems.size(), DrawCommand());
+		glCreateBuffers(1, &_drawCommandBuffer);
+		glNamedBufferStorage(_drawCommandBuffer, _drawCommands.size() * sizeof(DrawCommand), _drawCommands.data(), GL_DYNAMIC_STORAGE_BIT);
+		_debug.SetObjectName(GL_BUFFER, _drawCommandBuffer, "Scene Draw Command Buffer");
+
+		static_assert(sizeof(GltfDrawRecord) == 96, "Draw record layout must match gltf.glsl");
+		glCreateBuffers(1, &_drawRecordBuffer);
+		glNamedBufferStorage(_drawRecordBuffer, _drawItems.size() * sizeof(GltfDrawRecord), nullptr, GL_DYNAMIC_STORAGE_BIT);
+		_debug.SetObjectName(GL_BUFFER, _drawRecordBuffer, "Scene Draw Record Buffer");
+		UpdateDrawRecords();
+
+		glCreateBuffers(1, &_culledCommandBuffer);
+		glNamedBufferStorage(_culledCommandBuffer, _drawCommands.size() * sizeof(DrawCommand), nullptr, 0);
+		_debug.SetObjectName(GL_BUFFER, _culledCommandBuffer, "Scene Culled Command Buffer");
+		glCreateBuffers(1, &_drawCountBuffer);
+		glCreateBuffers(1, &_drawCountReadback);
+		glNamedBufferStorage(_drawCountBuffer, 8 * sizeof(GLuint), nullptr, 0);
+		constexpr GLbitfield kReadbackFlags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glNamedBufferStorage(_drawCountReadback, kDrawCountSlots * 8 * sizeof(GLuint), nullptr, kReadbackFlags | GL_CLIENT_STORAGE_BIT);
+		_drawCountMapped = static_cast<const GLuint*>(glMapNamedBufferRange(_drawCountReadback, 0, kDrawCountSlots * 8 * sizeof(GLuint), kReadbackFlags));
+		_debug.SetObjectName(GL_BUFFER, _drawCountBuffer, "Scene Draw Count Buffer");
+
+		//! Nothing is visible before the first frame, its second phase draws everything not occluded
+		const std::vector<GLuint> visibleBits((_drawItems.size() + 31) / 32, 0);
+		glCreateBuffers(1, &_visibilityBuffer);
+		glNamedBufferStorage(_visibilityBuffer, visibleBits.size() * sizeof(GLuint), visibleBits.data(), 0);
+		_debug.SetObjectName(GL_BUFFER, _visibilityBuffer, "Scene Visibility Buffer");
+
+		//! Without the draw parameters the base instance reaches the shader through the instanced fetch of 0, 1, 2, ...
+		std::vector<GLint> drawIndices(_drawItems.size());
+		for (size_t i = 0; i < drawIndices.size(); ++i)
+			drawIndices[i] = static_cast<GLint>(i);
+		const GLuint binding = static_cast<GLuint>(_buffers.size());
+		glCreateBuffers(1, &_drawIndexBuffer);
+		glNamedBufferStorage(_drawIndexBuffer, drawIndices.size() * sizeof(GLint), drawIndices.data(), 0);
+		glVertexArrayVertexBuffer(_vao, binding, _drawIndexBuffer, 0, sizeof(GLint));
+		glVertexArrayBindingDivisor(_vao, binding, 1);
+		glEnableVertexArrayAttrib(_vao, 7);
+		glVertexArrayAttribIFormat(_vao, 7, 1, GL_INT, 0);
+		glVertexArrayAttribBinding(_vao, 7, binding);
+		_debug.SetObjectName(GL_BUFFER, _drawIndexBuffer, "Scene Draw Index Buffer");
+	}
+
+	void Scene::UpdateDrawRecords()
+	{
+		_drawRecords.resize(_drawItems.size());
+		for (size_t i = 0; i < _drawItems.size(); ++i)
+		{
+			const auto& node = _sceneNodes[_drawItems[i].nodeIdx];
+			const auto& primMesh = _scenePrimMeshes[_drawItems[i].meshIdx];
+			auto& record = _drawRecords[i];
+			record.positionOffset = glm::vec4(primMesh.positionOffset, 0.0f);
+			record.positionScale = glm::vec4(primMesh.positionScale, 0.0f);
+			record.boundCenter = glm::vec4((primMesh.min + primMesh.max) * 0.5f, 0.0f);
+			record.boundExtent = glm::vec4((primMesh.max - primMesh.min) * 0.5f, 0.0f);
+			record.instanceIdx = _matrixIndices[_drawItems[i].nodeIdx];
+			record.materialIdx = primMesh.materialIndex;
+			record.jointOffset = node.skin == -1 ? -1 : _sceneSkins[node.skin].jointIndex;
+			record.morphOffset = _morphRanges[i].first;
+			record.morphCount = _morphRanges[i].second;
+		}
+		glNamedBufferSubData(_drawRecordBuffer, 0, _drawRecords.size() * sizeof(GltfDrawRecord), _drawRecords.data());
+	}
+
+	void Scene::CreateVertexBuffers(Core::VertexFormat format, Core::VertexLayout layout)
+	{
+		//! Source of each enabled attribute in the order of the attribute locations.
+		//! Quantized and compressed streams are kept as they are and converted by the vertex fetch,
+		//! the compressed positions and normals are decoded by vertex.glsl.
+		struct VertexStream
+		{
+			const unsigned char* data;
+			GLuint elementSize;
+			GLint numComponents;
+			GLenum type;
+			GLboolean normalized;
+			GLuint location;
+			bool integer;
+		};
+		std::vector<VertexStream> streams;
+		auto addStream = [&](const void* data, Core::VertexFormat attribute, const GLTFQuantizedStream& quantized) {
+			if (!static_cast<int>(format & attribute))
+				return;
+			const auto quantizedData = quantized.GetData();
+			if (quantizedData.empty())
+			{
+				const GLint numFloats = static_cast<GLint>(Core::VertexHelper::GetNumberOfFloats(attribute));
+				streams.push_back({ static_cast<const unsigned char*>(data), static_cast<GLuint>(numFloats * sizeof(float)), numFloats, GL_FLOAT, GL_FALSE,
+									static_cast<GLuint>(streams.size()), false });
+			}
+			else
+			{
+				streams.push_back({ quantizedData.data(), quantized.elementSize, quantized.numComponents,
+									static_cast<GLenum>(quantized.componentType), quantized.normalized ? GLboolean(GL_TRUE) : GLboolean(GL_FALSE),
+									static_cast<GLuint>(streams.size()), false });
+			}
+		};
+		//! Uploaded straight from the mapped scene cache after a warm start
+		addStream(GetPositions().data(), Core::VertexFormat::Position3, _quantizedPositions);
+		addStream(GetNormals().data(),	 Core::VertexFormat::Normal3,	_quantizedNormals  );
+		addStream(GetTangents().data(),	 Core::VertexFormat::Tangent4,	_quantizedTangents );
+		addStream(GetColors().data(),	 Core::VertexFormat::Color4,	_quantizedColors   );
+		addStream(GetTexCoords().data(), Core::VertexFormat::TexCoord2, _quantizedTexCoords);
+		//! Skinning streams at the fixed locations after the format attributes
+		if (!GetSkinJoints().empty())
+		{
+			streams.push_back({ reinterpret_cast<const unsigned char*>(GetSkinJoints().data()), sizeof(glm::u16vec4), 4, GL_UNSIGNED_SHORT, GL_FALSE, 5, true });
+			streams.push_back({ reinterpret_cast<const unsigned char*>(GetSkinWeights().data()), sizeof(glm::u16vec4), 4, GL_UNSIGNED_SHORT, GL_TRUE, 6, false });
+		}
+
+		//! Assign each stream to a buffer binding, streams sharing the binding are interleaved
+		std::vector<GLuint> bindings(streams.size(), 0);
+		for (size_t i = 0; i < streams.size(); ++i)
+		{
+			switch (layout)
+			{
+			case Core::VertexLayout::Interleaved:
+				bindings[i] = 0;
+				break;
+			case Core::VertexLayout::PositionSplit:
+				bindings[i] = i == 0 ? 0 : 1;
+				break;
+			default:
+				bindings[i] = static_cast<GLuint>(i);
+				break;
+			}
+		}
+		const size_t numBindings = streams.empty() ? 0 : *std::max_element(bindings.begin(), bindings.end()) + 1;
+
+		//! Relative offsets of the streams and stride of each binding
+		std::vector<GLuint> offsets(streams.size(), 0), strides(numBindings, 0);
+		for (size_t i = 0; i < streams.size(); ++i)
+		{
+			offsets[i] = strides[bindings[i]];
+			strides[bindings[i]] += streams[i].elementSize;
+		}
+
+		_buffers.resize(numBindings);
+		glCreateBuffers(static_cast<GLsizei>(_buffers.size()), _buffers.data());
+
+		//! Pack each binding in one pass over the vertices
+		const size_t numVertices = GetPositions().size();
+		std::vector<unsigned char> packed;
+		for (GLuint binding = 0; binding < numBindings; ++binding)
+		{
+			const size_t stride = strides[binding];
+			const size_t numStreams = std::count(bindings.begin(), bindings.end(), binding);
+			const unsigned char* data = nullptr;
+			if (numStreams == 1)
+			{
+				//! Nothing to interleave, upload the stream as it is
+				data = streams[std::find(bindings.begin(), bindings.end(), binding) - bindings.begin()].data;
+			}
+			else
+			{
+				packed.resize(numVertices * stride);
+				for (size_t v = 0; v < numVertices; ++v)
+				{
+					unsigned char* dst = packed.data() + v * stride;
+					for (size_t i = 0; i < streams.size(); ++i)
+					{
+						if (bindings[i] == binding)
+							std::memcpy(dst + offsets[i], streams[i].data + v * streams[i].elementSize, streams[i].elementSize);
+					}
+				}
+				data = packed.data();
+			}
+
+			glNamedBufferStorage(_buffers[binding], numVertices * stride, data, GL_MAP_READ_BIT);
+			glVertexArrayVertexBuffer(_vao, binding, _buffers[binding], 0, static_cast<GLsizei>(stride));
+			_debug.SetObjectName(GL_BUFFER, _buffers[binding], "Scene Buffer #" + std::to_string(binding));
+		}
+
+		for (size_t i = 0; i < streams.size(); ++i)
+		{
+			const GLuint location = streams[i].location;
+			glEnableVertexArrayAttrib(_vao, location);
+			if (streams[i].integer)
+				glVertexArrayAttribIFormat(_vao, location, streams[i].numComponents, streams[i].type, offsets[i]);
+			else
+				glVertexArrayAttribFormat(_vao, location, streams[i].numComponents, streams[i].type, streams[i].normalized, offsets[i]);
+			glVertexArrayAttribBinding(_vao, location, bindings[i]);
+		}
+	}
+
+	void Scene::CreateElementBuffer(bool shortIndices)
+	{
+		//! Indices are local to each primitive (drawn with base vertex),
+		//! therefore primitives with at most 65536 vertices fit in 16-bit.
+		//! The LODs share the vertices, hence the index type of their primitive.
+		constexpr unsigned int kMaxShortVertices = 65536;
+
+		_indexRanges.resize(_scenePrimMeshes.size());
+		size_t numIntIndices = 0, numShortIndices = 0;
+		for (size_t i = 0; i < _scenePrimMeshes.size(); ++i)
+		{
+			const auto& primMesh = _scenePrimMeshes[i];
+			const bool isShort = shortIndices && primMesh.vertexCount <= kMaxShortVertices;
+			size_t& numIndices = isShort ? numShortIndices : numIntIndices;
+
+			_indexRanges[i].resize(primMesh.lods.size() + 1);
+			for (size_t level = 0; level < _indexRanges[i].size(); ++level)
+			{
+				auto& indexRange = _indexRanges[i][level];
+				indexRange.type = isShort ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+				indexRange.offset = numIndices;
+				indexRange.count = level == 0 ? primMesh.indexCount : primMesh.lods[level - 1].indexCount;
+				numIndices += indexRange.count;
+			}
+		}
+
+		//! Without a 16-bit primitive the indices are uploaded as they are, the ranges are already contiguous
+		const auto indices = GetIndices();
+		glCreateBuffers(1, &_ebo);
+		if (numShortIndices == 0)
+		{
+			for (size_t i = 0; i < _scenePrimMeshes.size(); ++i)
+			{
+				const auto& primMesh = _scenePrimMeshes[i];
+				for (size_t level = 0; level < _indexRanges[i].size(); ++level)
+					_indexRanges[i][level].offset = (level == 0 ? primMesh.firstIndex : primMesh.lods[level - 1].firstIndex) * sizeof(unsigned int);
+			}
+			glNamedBufferStorage(_ebo, std::max<size_t>(indices.size(), 1) * sizeof(unsigned int), indices.empty() ? nullptr : indices.data(), 0);
+		}
+		else
+		{
+			//! The 16-bit range follows the 32-bit range to keep both aligned. The 32-bit ranges are copied
+			//! from the indices one by one, only the narrowed ones need a scratch array.
+			const size_t shortRangeOffset = numIntIndices * sizeof(unsigned int);
+			glNamedBufferStorage(_ebo, shortRangeOffset + numShortIndices * sizeof(unsigned short), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+			std::vector<unsigned short> indices16(numShortIndices);
+			for (size_t i = 0; i < _scenePrimMeshes.size(); ++i)
+			{
+				const auto& primMesh = _scenePrimMeshes[i];
+				for (size_t level = 0; level < _indexRanges[i].size(); ++level)
+				{
+					auto& indexRange = _indexRanges[i][level];
+					const unsigned int firstIndex = level == 0 ? primMesh.firstIndex : primMesh.lods[level - 1].firstIndex;
+					if (indexRange.type == GL_UNSIGNED_SHORT)
+					{
+						Core::NarrowIndices(indices.data() + firstIndex, indices16.data() + indexRange.offset, indexRange.count);
+						indexRange.offset = shortRangeOffset + indexRange.offset * sizeof(unsigned short);
+					}
+					else
+					{
+						indexRange.offset *= sizeof(unsigned int);
+						if (indexRange.count > 0)
+							glNamedBufferSubData(_ebo, indexRange.offset, indexRange.count * sizeof(unsigned int), indices.data() + firstIndex);
+					}
+				}
+			}
+			glNamedBufferSubData(_ebo, shortRangeOffset, numShortIndices * sizeof(unsigned short), indices16.data());
+		}
+		glVertexArrayElementBuffer(_vao, _ebo);
+		_debug.SetObjectName(GL_BUFFER, _ebo, "Scene Element Buffer");
+	}
+
+	void Scene::CreateNodeSpheres()
+	{
+		_nodeSpheres.assign(_sceneNodes.size(), glm::vec4(0.0f));
+		for (size_t i = 0; i < _sceneNodes.size(); ++i)
+		{
+			const auto& node = _sceneNodes[i];
+			if (node.primMeshes.empty())
+				continue;
+
+			glm::vec3 boundMin(std::numeric_limits<float>::max()), boundMax(std::numeric_limits<float>::lowest());
+			for (unsigned int meshIdx : node.primMeshes)
+			{
+				boundMin = glm::min(boundMin, _scenePrimMeshes[meshIdx].min);
+				boundMax = glm::max(boundMax, _scenePrimMeshes[meshIdx].max);
+			}
+			_nodeSpheres[i] = glm::vec4((boundMin + boundMax) * 0.5f, glm::length(boundMax - boundMin) * 0.5f);
+		}
+	}
+
+	size_t Scene::SelectLod(const GLTFPrimMesh& primMesh, float projectedScale) const
+	{
+		if (projectedScale <= 0.0f)
+			return 0;
+
+		size_t level = 0;
+		while (level < primMesh.lods.size() && primMesh.lods[level].error * projectedScale <= _lodPixelError)
+			++level;
+		return level;
 	}
 
 	void Scene::CleanUp()
 	{
+		WaitForFrame();
 		glDeleteTextures(_textures.size(), _textures.data());
 		glDeleteBuffers(1, &_matrixBuffer);
 		glDeleteBuffers(1, &_materialBuffer);
+		glDeleteBuffers(1, &_jointBuffer);
+		glDeleteBuffers(1, &_morphDeltaBuffer);
+		glDeleteBuffers(1, &_morphTargetBuffer);
+		glDeleteBuffers(1, &_drawCommandBuffer);
+		glDeleteBuffers(1, &_drawRecordBuffer);
+		glDeleteBuffers(1, &_drawIndexBuffer);
+		glDeleteBuffers(1, &_culledCommandBuffer);
+		glDeleteBuffers(1, &_drawCountBuffer);
+		for (GLsync& fence : _drawCountFences)
+		{
+			if (fence != nullptr)
+				glDeleteSync(fence);
+			fence = nullptr;
+		}
+		glDeleteBuffers(1, &_drawCountReadback);
+		_drawCountMapped = nullptr;
+		glDeleteBuffers(1, &_visibilityBuffer);
+		glDeleteTextures(1, &_hiZTexture);
+		_hiZShader.reset();
+		_cullShader.reset();
 		glDeleteBuffers(_buffers.size(), _buffers.data());
 		glDeleteBuffers(1, &_ebo);
 		glDeleteVertexArrays(1, &_vao);
@@ -236,4 +1213,114 @@ namespace GL3 {
 	{
 		_animIndex = animIndex;
 	}
-};
\ No newline at end of file
+
+	void Scene::SetAnimationLayers(const std::vector< Core::GLTFAnimationLayer >& layers)
+	{
+		_animationLayers = layers;
+	}
+
+	void Scene::SetLodCamera(const glm::mat4& view, const glm::mat4& projection, int viewportHeight)
+	{
+		//! Pixels per unit length at unit distance along the view direction
+		_lodProjectionScale = projection[1][1] * static_cast<float>(viewportHeight) * 0.5f;
+		_lodEye = glm::vec3(glm::inverse(view)[3]);
+
+		//! Planes of the clip space bounds -w <= x, y, z <= w
+		const glm::mat4 viewProjection = projection * view;
+		const glm::vec4 rows[4] = { glm::row(viewProjection, 0), glm::row(viewProjection, 1), glm::row(viewProjection, 2), glm::row(viewProjection, 3) };
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			_lodFrustum[axis * 2] = rows[3] + rows[axis];
+			_lodFrustum[axis * 2 + 1] = rows[3] - rows[axis];
+		}
+		for (auto& plane : _lodFrustum)
+			plane /= glm::length(glm::vec3(plane));
+	}
+
+	void Scene::SetLodPixelError(float pixelError)
+	{
+		_lodPixelError = pixelError;
+	}
+
+	void Scene::SetAnimationLod(bool enabled, float pixelSize, int reducedPeriod)
+	{
+		_animationLod = enabled;
+		_animationLodPixelSize = pixelSize;
+		_animationLodPeriod = std::max(reducedPeriod, 1);
+	}
+
+	void Scene::UpdateAnimationLods()
+	{
+		//! Shorter period of the two, zero is the longest
+		auto combine = [](int lhs, int rhs) {
+			return lhs == 0 ? rhs : (rhs == 0 ? lhs : std::min(lhs, rhs));
+		};
+
+		_nodeUpdatePeriods.assign(_sceneNodes.size(), 0);
+		for (size_t i = 0; i < _sceneNodes.size(); ++i)
+		{
+			const auto& node = _sceneNodes[i];
+			if (node.primMeshes.empty())
+				continue;
+
+			//! The skinned vertices follow the joints, their bounds are the joints enlarged by the bind pose bounds
+			const glm::vec4& sphere = _nodeSpheres[i];
+			glm::vec3 center;
+			float radius;
+			if (node.skin != -1)
+			{
+				const auto& skin = _sceneSkins[node.skin];
+				glm::vec3 boundMin(std::numeric_limits<float>::max()), boundMax(std::numeric_limits<float>::lowest());
+				for (int j = skin.jointIndex; j < skin.jointIndex + skin.jointCount; ++j)
+				{
+					if (_jointNodes[j] == -1)
+						continue;
+					const glm::vec3 position(_nodeWorlds[_jointNodes[j]][3]);
+					boundMin = glm::min(boundMin, position);
+					boundMax = glm::max(boundMax, position);
+				}
+				if (boundMin.x > boundMax.x)
+					boundMin = boundMax = glm::vec3(_nodeWorlds[i][3]);
+				center = (boundMin + boundMax) * 0.5f;
+				radius = glm::length(boundMax - boundMin) * 0.5f + sphere.w * 2.0f;
+			}
+			else
+			{
+				const glm::mat4& world = _nodeWorlds[i];
+				const float worldScale = std::max({ glm::length(glm::vec3(world[0])),
+													glm::length(glm::vec3(world[1])),
+													glm::length(glm::vec3(world[2])) });
+				center = glm::vec3(world * glm::vec4(glm::vec3(sphere), 1.0f));
+				radius = sphere.w * worldScale;
+			}
+
+			bool isVisible = true;
+			for (const auto& plane : _lodFrustum)
+				isVisible &= glm::dot(glm::vec3(plane), center) + plane.w >= -radius;
+			if (!isVisible)
+				continue;
+
+			const float distance = glm::length(center - _lodEye) - radius;
+			const float pixelSize = distance > 0.0f ? 2.0f * radius * _lodProjectionScale / distance : std::numeric_limits<float>::max();
+			_nodeUpdatePeriods[i] = pixelSize < _animationLodPixelSize ? _animationLodPeriod : 1;
+
+			if (node.skin != -1)
+			{
+				const auto& skin = _sceneSkins[node.skin];
+				for (int j = skin.jointIndex; j < skin.jointIndex + skin.jointCount; ++j)
+				{
+					if (_jointNodes[j] != -1)
+						_nodeUpdatePeriods[_jointNodes[j]] = combine(_nodeUpdatePeriods[_jointNodes[j]], _nodeUpdatePeriods[i]);
+				}
+			}
+		}
+
+		//! Children follow their parents in the node order, so the reverse order visits every child before its parent
+		for (size_t i = _sceneNodes.size(); i-- > 0;)
+		{
+			const int parent = _nodeParents[i];
+			if (parent != -1)
+				_nodeUpdatePeriods[parent] = combine(_nodeUpdatePeriods[parent], _nodeUpdatePeriods[i]);
+		}
+	}
+};
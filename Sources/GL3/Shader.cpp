@@ -15,7 +15,8 @@ std::string GetPathDirectory(const std::string& path)
 	return path.substr(0, pos + 1);
 }
 
-std::string PreprocessShaderInclude(const std::string& path, std::string includePrefix = "#include")
+//! The version directive of the included files is skipped, a variant can define its options before including its base shader
+std::string PreprocessShaderInclude(const std::string& path, std::string includePrefix = "#include", bool isIncluded = false)
 {
 	includePrefix += ' ';
 
@@ -38,11 +39,13 @@ std::string PreprocessShaderInclude(const std::string& path, std::string include
 
 			std::string filePath = GetPathDirectory(path);
 			filePath += temp;
-			std::string includeSrc = PreprocessShaderInclude(filePath);
+			std::string includeSrc = PreprocessShaderInclude(filePath, "#include", true);
 
 			fullSourceCode += includeSrc;
 			continue;
 		}
+		if (isIncluded && temp.compare(0, 8, "#version") == 0)
+			continue;
 
 		fullSourceCode += temp + '\n';
 	}
@@ -8,6 +8,11 @@
 #include <GLFW/glfw3.h>
 
 #include <tinygltf/stb_image.h>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <sstream>
 
 GLTFSceneApp::GLTFSceneApp()
 {
@@ -44,6 +49,17 @@ bool GLTFSceneApp::OnInitialize(std::shared_ptr<GL3::Window> window, const cxxop
 	_debug.SetObjectName(GL_PROGRAM, defaultShader->GetResourceID(), "Default Program");
 	_shaders.emplace("default", std::move(defaultShader));
 
+	//! Same pipeline without the alpha test for the opaque pass of the scene
+	auto opaqueShader = std::make_shared<GL3::Shader>();
+	if (!opaqueShader->Initialize({ {GL_VERTEX_SHADER,	 RESOURCES_DIR "shaders/vertex.glsl"},
+									{GL_FRAGMENT_SHADER, RESOURCES_DIR "shaders/output_opaque.glsl"} }))
+		return false;
+
+	opaqueShader->BindUniformBlock("UBOCamera", 0);
+	opaqueShader->BindUniformBlock("UBOScene", 1);
+	_debug.SetObjectName(GL_PROGRAM, opaqueShader->GetResourceID(), "Opaque Program");
+	_shaders.emplace("opaque", std::move(opaqueShader));
+
 	//! Add Skybox shader for rendering environment map
 	auto skyboxShader = std::make_shared<GL3::Shader>();
 	if (!skyboxShader->Initialize({ {GL_VERTEX_SHADER,	 RESOURCES_DIR "shaders/skybox.vert"},
@@ -55,10 +71,42 @@ bool GLTFSceneApp::OnInitialize(std::shared_ptr<GL3::Window> window, const cxxop
 	_shaders.emplace("skybox", std::move(skyboxShader));
 
 
-	if (!_sceneInstance.Initialize(configure["scene"].as<std::string>(),
-		Core::VertexFormat::Position3Normal3TexCoord2Color4))
+	Core::GLTFLoadOptions loadOptions;
+	loadOptions.memoryMapped = configure["mmap"].as<bool>();
+	loadOptions.sceneCache = configure["cache"].as<bool>();
+	loadOptions.keepQuantized = configure["quantized"].as<bool>();
+	loadOptions.shortIndices = configure["short-indices"].as<bool>();
+	loadOptions.optimizeMeshes = configure["optimize"].as<bool>();
+	loadOptions.compressAttributes = configure["compress"].as<bool>();
+	loadOptions.generateLods = configure["lod"].as<bool>();
+	loadOptions.reduceKeyframes = configure["anim-reduce"].as<bool>();
+	loadOptions.keyframeErrorBound = configure["anim-reduce-error"].as<float>();
+	loadOptions.animationSampleRate = configure["anim-rate"].as<float>();
+	loadOptions.compressAnimations = configure["anim-compress"].as<bool>();
+	loadOptions.animationErrorBound = configure["anim-error"].as<float>();
+
+	const Core::VertexFormat format = Core::VertexFormat::Position3Normal3TexCoord2Color4;
+	Core::VertexLayout layout;
+	if (!ParseVertexLayout(configure["layout"].as<std::string>(), &layout))
 		return false;
 
+	if (!_sceneInstance.Initialize(configure["scene"].as<std::string>(), format, loadOptions, layout))
+		return false;
+	_sceneInstance.SetLodPixelError(configure["lod-pixel-error"].as<float>());
+	_sceneInstance.SetAnimationLod(configure["anim-lod"].as<bool>(), configure["anim-lod-pixels"].as<float>(), configure["anim-lod-period"].as<int>());
+	_reportAnimationStats = configure["anim-lod"].as<bool>();
+	std::vector<Core::GLTFAnimationLayer> animationLayers;
+	if (!ParseAnimationLayers(configure["anim-layers"].as<std::string>(), &animationLayers))
+		return false;
+	_sceneInstance.SetAnimationLayers(animationLayers);
+	_sceneInstance.SetUpdateMode(configure["deterministic-update"].as<bool>() ? GL3::Scene::UpdateMode::Deterministic : GL3::Scene::UpdateMode::Pipelined);
+	_sceneInstance.SetIndirectDraws(!configure["direct-draws"].as<bool>());
+	_sceneInstance.SetCpuCulling(configure["cpu-cull"].as<bool>());
+	_sceneInstance.SetGpuCulling(configure["gpu-cull"].as<bool>(), configure["cull-stats"].as<bool>());
+	_sceneInstance.SetOcclusionCulling(configure["occlusion-cull"].as<bool>());
+	_reportCullStats = (configure["gpu-cull"].as<bool>() || configure["occlusion-cull"].as<bool>()) && configure["cull-stats"].as<bool>();
+	_viewportHeight = window->GetWindowExtent().y;
+
 	if (!_skyDome.Initialize(configure["envmap"].as<std::string>()))
 		return false;
 
@@ -68,9 +116,128 @@ bool GLTFSceneApp::OnInitialize(std::shared_ptr<GL3::Window> window, const cxxop
 	glBindBuffer(GL_UNIFORM_BUFFER, 0);
 	_debug.SetObjectName(GL_BUFFER, _uniformBuffer, "SceneBuffer");
 
+	//! Compare the layouts and quit
+	const int numBenchmarkFrames = configure["benchmark-layouts"].as<int>();
+	if (numBenchmarkFrames > 0)
+	{
+		BenchmarkVertexLayouts(configure["scene"].as<std::string>(), format, loadOptions, numBenchmarkFrames);
+		glfwSetWindowShouldClose(window->GetGLFWWindow(), GLFW_TRUE);
+	}
+
+	return true;
+}
+
+bool GLTFSceneApp::ParseVertexLayout(const std::string& name, Core::VertexLayout* layout)
+{
+	for (int i = 0; i < static_cast<int>(Core::VertexLayout::Count); ++i)
+	{
+		if (name == Core::VertexHelper::GetLayoutName(static_cast<Core::VertexLayout>(i)))
+		{
+			*layout = static_cast<Core::VertexLayout>(i);
+			return true;
+		}
+	}
+
+	std::cerr << "Unknown vertex layout : " << name << std::endl;
+	return false;
+}
+
+bool GLTFSceneApp::ParseAnimationLayers(const std::string& description, std::vector<Core::GLTFAnimationLayer>* layers)
+{
+	std::stringstream layerStream(description);
+	std::string layerDescription;
+	while (std::getline(layerStream, layerDescription, ','))
+	{
+		std::vector<std::string> fields;
+		std::stringstream fieldStream(layerDescription);
+		std::string field;
+		while (std::getline(fieldStream, field, ':'))
+			fields.push_back(field);
+
+		Core::GLTFAnimationLayer layer;
+		char* end = nullptr;
+		bool valid = fields.size() >= 2;
+		if (valid)
+		{
+			layer.animIndex = static_cast<int>(std::strtol(fields[0].c_str(), &end, 10));
+			valid &= *end == '\0' && layer.animIndex >= 0 && layer.animIndex < static_cast<int>(_sceneInstance.GetNumAnimations());
+			layer.weight = std::strtof(fields[1].c_str(), &end);
+			valid &= *end == '\0';
+		}
+		std::size_t next = 2;
+		if (valid && next < fields.size() && fields[next] == "add")
+		{
+			layer.mode = Core::GLTFAnimationLayer::Mode::Additive;
+			++next;
+		}
+		if (valid && next < fields.size())
+		{
+			const int nodeIndex = static_cast<int>(std::strtol(fields[next].c_str(), &end, 10));
+			valid &= *end == '\0' && next + 1 == fields.size();
+			if (valid)
+			{
+				layer.maskIndex = _sceneInstance.AddSubtreeMask(nodeIndex);
+				valid &= layer.maskIndex != -1;
+			}
+		}
+
+		if (!valid)
+		{
+			std::cerr << "Invalid animation layer : " << layerDescription << std::endl;
+			return false;
+		}
+		layers->push_back(layer);
+	}
+
 	return true;
 }
 
+void GLTFSceneApp::BenchmarkVertexLayouts(const std::string& filename, Core::VertexFormat format, const Core::GLTFLoadOptions& options, int numFrames)
+{
+	constexpr int kNumWarmupFrames = 8;
+
+	auto& pbrShader = _shaders["default"];
+	GLuint query;
+	glGenQueries(1, &query);
+
+	//! Only the geometry processing(vertex fetch & shading) is measured, rasterization is discarded
+	glEnable(GL_RASTERIZER_DISCARD);
+	for (int i = 0; i < static_cast<int>(Core::VertexLayout::Count); ++i)
+	{
+		const auto layout = static_cast<Core::VertexLayout>(i);
+		GL3::Scene scene;
+		if (!scene.Initialize(filename, format, options, layout))
+			continue;
+
+		pbrShader->BindShaderProgram();
+		_cameras[0]->BindCamera(0);
+		glBindBufferBase(GL_UNIFORM_BUFFER, 1, _uniformBuffer);
+
+		GLuint64 totalTime = 0, bestTime = std::numeric_limits<GLuint64>::max();
+		for (int frame = -kNumWarmupFrames; frame < numFrames; ++frame)
+		{
+			glBeginQuery(GL_TIME_ELAPSED, query);
+			scene.Render(pbrShader);
+			glEndQuery(GL_TIME_ELAPSED);
+
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+			if (frame >= 0)
+			{
+				totalTime += elapsed;
+				bestTime = std::min(bestTime, elapsed);
+			}
+		}
+
+		std::cout << "[Vertex Layout Benchmark] " << Core::VertexHelper::GetLayoutName(layout)
+				  << " : average " << totalTime / numFrames / 1000.0 << " (us), best " << bestTime / 1000.0 << " (us)" << std::endl;
+		scene.CleanUp();
+	}
+	glDisable(GL_RASTERIZER_DISCARD);
+
+	glDeleteQueries(1, &query);
+}
+
 void GLTFSceneApp::OnCleanUp()
 {
 	_sceneInstance.CleanUp();
@@ -79,6 +246,30 @@ void GLTFSceneApp::OnCleanUp()
 void GLTFSceneApp::OnUpdate(double dt)
 {
 	_sceneInstance.Update(dt);
+
+	if (_reportAnimationStats)
+	{
+		const auto& stats = _sceneInstance.GetFrameAnimationStats();
+		_evaluatedChannels += stats.evaluatedChannels;
+		_skippedChannels += stats.skippedChannels;
+		_statsElapsed += dt;
+		if (_statsElapsed >= 1.0)
+		{
+			std::clog << "Animation channels evaluated : " << _evaluatedChannels << ", skipped : " << _skippedChannels << " per second\r" << std::flush;
+			_evaluatedChannels = _skippedChannels = 0;
+			_statsElapsed = 0.0;
+		}
+	}
+
+	if (_reportCullStats)
+	{
+		_cullStatsElapsed += dt;
+		if (_cullStatsElapsed >= 1.0)
+		{
+			std::clog << "Draws visible after GPU culling : " << _sceneInstance.GetNumVisibleDraws() << '\n';
+			_cullStatsElapsed = 0.0;
+		}
+	}
 }
 
 void GLTFSceneApp::OnDraw()
@@ -107,7 +298,8 @@ void GLTFSceneApp::OnDraw()
 
 	_cameras[0]->BindCamera(0);
 	glBindBufferBase(GL_UNIFORM_BUFFER, 1, _uniformBuffer);
-	_sceneInstance.Render(pbrShader, GL_BLEND_SRC_ALPHA);
+	_sceneInstance.SetLodCamera(_cameras[0]->GetViewMatrix(), _cameras[0]->GetProjectionMatrix(), _viewportHeight);
+	_sceneInstance.Render(pbrShader, _shaders["opaque"]);
 }
 
 void GLTFSceneApp::OnProcessInput(unsigned int key)
@@ -125,5 +317,5 @@ void GLTFSceneApp::OnProcessInput(unsigned int key)
 void GLTFSceneApp::OnProcessResize(int width, int height)
 {
 	UNUSED_VARIABLE(width);
-	UNUSED_VARIABLE(height);
+	_viewportHeight = height;
 }
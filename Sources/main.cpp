@@ -1,6 +1,7 @@
 #include <cxxopts/cxxopts.hpp>
 
 #include <GLTFSceneRenderer.hpp>
+#include <Core/GLTFScene.hpp>
 #include <GL3/Window.hpp>
 #include <GLFW/glfw3.h>
 #include <chrono>
@@ -18,6 +19,32 @@ int main(int argc, char* argv[])
 			cxxopts::value<std::string>()->default_value(RESOURCES_DIR "scenes/FlightHelmet/FlightHelmet.gltf"))
 		("e,envmap", "HDR SkyDome image filepath(default is '" RESOURCES_DIR  "scenes/environment.hdr')",
 			cxxopts::value<std::string>()->default_value(RESOURCES_DIR "scenes/environment.hdr"))
+		("mmap", "Memory-map the glTF binary buffers instead of copying them", cxxopts::value<bool>()->default_value("false"))
+		("cache", "Load the scene from the binary cache next to the scene file, create it if missing or stale", cxxopts::value<bool>()->default_value("false"))
+		("quantized", "Keep KHR_mesh_quantization attributes quantized in the vertex buffers", cxxopts::value<bool>()->default_value("false"))
+		("short-indices", "Draw primitives with at most 65536 vertices using 16-bit indices", cxxopts::value<bool>()->default_value("false"))
+		("optimize", "Optimize the triangle and vertex order of the meshes and report ACMR/ATVR", cxxopts::value<bool>()->default_value("false"))
+		("compress", "Compress the vertex attributes and report the encoding errors", cxxopts::value<bool>()->default_value("false"))
+		("lod", "Generate the LOD chain of the meshes and select the level of each node by its screen size", cxxopts::value<bool>()->default_value("false"))
+		("lod-pixel-error", "Largest allowed screen space error of the selected LOD in pixels", cxxopts::value<float>()->default_value("1.0"))
+		("anim-lod", "Freeze the animation of the nodes out of the frustum and slow down the small ones, report the evaluated channels", cxxopts::value<bool>()->default_value("false"))
+		("anim-lod-pixels", "Screen size in pixels below which the animated nodes update at a reduced rate", cxxopts::value<float>()->default_value("32"))
+		("anim-lod-period", "Number of frames between the updates of the small animated nodes", cxxopts::value<int>()->default_value("4"))
+		("anim-reduce", "Fit the dense linear animation keys into fewer cubic spline keys at import", cxxopts::value<bool>()->default_value("false"))
+		("anim-reduce-error", "Largest allowed error of the fitted cubic spline keys", cxxopts::value<float>()->default_value("0.001"))
+		("anim-rate", "Resample the animations to this many keys per second, 0 keeps the keys of the file", cxxopts::value<float>()->default_value("0"))
+		("anim-compress", "Pack the resampled animation keys into 48 bits", cxxopts::value<bool>()->default_value("false"))
+		("anim-layers", "Blend the comma separated layers 'clip:weight[:add][:node]' instead of the first clip, node masks the layer to the subtree of the glTF node", cxxopts::value<std::string>()->default_value(""))
+		("anim-error", "Largest allowed error of the resampled or packed animation keys", cxxopts::value<float>()->default_value("0.001"))
+		("deterministic-update", "Evaluate the animation before drawing each frame instead of overlapping it with the draws of the previous frame", cxxopts::value<bool>()->default_value("false"))
+		("direct-draws", "Submit one draw call per primitive instead of the multi-draw indirect", cxxopts::value<bool>()->default_value("false"))
+		("cpu-cull", "Cull the draws against the camera frustum with a bounding volume hierarchy refit to the animation", cxxopts::value<bool>()->default_value("false"))
+		("gpu-cull", "Cull the multi-draw indirect commands against the camera frustum in a compute pass", cxxopts::value<bool>()->default_value("false"))
+		("occlusion-cull", "Cull the multi-draw indirect commands hidden by the depth of the visible ones with a Hi-Z pyramid", cxxopts::value<bool>()->default_value("false"))
+		("cull-stats", "Read back and report the number of draws which passed the GPU culling", cxxopts::value<bool>()->default_value("false"))
+		("layout", "Vertex buffer layout : separate, interleaved or position-split", cxxopts::value<std::string>()->default_value("separate"))
+		("benchmark-layouts", "Measure the geometry processing of every vertex layout for the given number of frames and quit", cxxopts::value<int>()->default_value("0"))
+		("benchmark-animation", "Measure the animation update of 1k channels x 10k keys, the keyframe reduction of 1k channels x 7.2k keys, the transform update of 100k nodes, the skinning of 100k vertices and 64 morph targets of 20k vertices for the given number of frames and quit", cxxopts::value<int>()->default_value("0"))
 		("h,help", "Print usage");
 
 	auto result = options.parse(argc, argv);
@@ -28,6 +55,18 @@ int main(int argc, char* argv[])
 		exit(0);
 	}
 
+	//! Runs without the window
+	const int numAnimationFrames = result["benchmark-animation"].as<int>();
+	if (numAnimationFrames > 0)
+	{
+		Core::GLTFScene::BenchmarkAnimation(1000, 10000, numAnimationFrames);
+		Core::GLTFScene::BenchmarkKeyframeReduction(1000, 7200, numAnimationFrames);
+		Core::GLTFScene::BenchmarkTransforms(100000, numAnimationFrames);
+		Core::GLTFScene::BenchmarkSkinning(100000, 128, numAnimationFrames);
+		Core::GLTFScene::BenchmarkMorphTargets(20000, 64, numAnimationFrames);
+		return 0;
+	}
+
 	auto renderer = std::make_unique<GLTFSceneRenderer>();
 	if (!renderer->Initialize(result))
 	{